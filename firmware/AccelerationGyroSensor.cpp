@@ -39,6 +39,19 @@ namespace
 	{
 		value = ((value & 0x00FF) << 8) | ((value >> 8) & 0x00FF);
 	}
+
+	/*!
+		@brief Read a register of 16 bits, which is big endian and two's complement
+
+		The bytes are read by their own statements, because the order of evaluation in an expression is unspecified.
+	*/
+	inline int read_word()
+	{
+		const int high = Wire.read();
+		const int low  = Wire.read();
+
+		return static_cast<int16_t>((high << 8) | low);
+	}
 }
 
 void PLEN2::AccelerationGyroSensor::setup() {
@@ -70,13 +83,13 @@ void PLEN2::AccelerationGyroSensor::sampling()
 	Wire.write(MPU6050_REGISTER_ACCEL_XOUT_H);
 	Wire.endTransmission();
 	Wire.requestFrom(MPU6050SlaveAddress, (uint8_t)14);
-	m_values[ACC_X] = (((int16_t)Wire.read() << 8) | Wire.read());
-	m_values[ACC_Y] = (((int16_t)Wire.read() << 8) | Wire.read());
-	m_values[ACC_Z] = (((int16_t)Wire.read() << 8) | Wire.read());
-	//Temperature = (((int16_t)Wire.read() << 8) | Wire.read());
-	m_values[GYRO_ROLL] = (((int16_t)Wire.read() << 8) | Wire.read());
-	m_values[GYRO_PITCH] = (((int16_t)Wire.read() << 8) | Wire.read());
-	m_values[GYRO_YAW] = (((int16_t)Wire.read() << 8) | Wire.read());
+	m_values[ACC_X] = read_word();
+	m_values[ACC_Y] = read_word();
+	m_values[ACC_Z] = read_word();
+	read_word(); // The temperature is between the acceleration and the gyro.
+	m_values[GYRO_ROLL] = read_word();
+	m_values[GYRO_PITCH] = read_word();
+	m_values[GYRO_YAW] = read_word();
 #else
 	return;
 #endif
@@ -0,0 +1,177 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "System.h"
+#include "AccelerationGyroSensor.h"
+#include "JointController.h"
+#include "BalanceStabilizer.h"
+#include "Trigonometry.h"
+#include "Profiler.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	enum {
+		RIGHT_BEGIN = JointController::RIGHT_SHOULDER_PITCH
+	};
+
+	inline int pitch_of(AccelerationGyroSensor& sensor)
+	{
+		return Utility::atan2_binary(sensor.getAccX(), sensor.getAccZ());
+	}
+
+	inline int roll_of(AccelerationGyroSensor& sensor)
+	{
+		return Utility::atan2_binary(sensor.getAccY(), sensor.getAccZ());
+	}
+}
+
+
+PLEN2::BalanceStabilizer::BalanceStabilizer(AccelerationGyroSensor& sensor)
+	: m_sensor_ptr(&sensor)
+	, m_enabled(false)
+	, m_reference_pitch(0)
+	, m_reference_roll(0)
+	, m_update_usec_last(0)
+	, m_update_usec_max(0)
+{
+	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		m_offsets[joint_id] = 0;
+	}
+}
+
+
+int PLEN2::BalanceStabilizer::m_calculate(int tilt, int angular_velocity)
+{
+	const long tilt_deg10 = Utility::binary_to_deg10(tilt);
+	const long dps_deg10  = (static_cast<long>(angular_velocity) * 10) / GYRO_LSB_PER_DPS();
+
+	const long offset = -((KP_Q8() * tilt_deg10 + KD_Q8() * dps_deg10) >> 8);
+
+	return constrain(offset, -OFFSET_MAX(), OFFSET_MAX());
+}
+
+
+void PLEN2::BalanceStabilizer::enable(bool enabled)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("BalanceStabilizer::enable()"));
+	#endif
+
+	if (enabled)
+	{
+		m_sensor_ptr->sampling();
+
+		m_reference_pitch = pitch_of(*m_sensor_ptr);
+		m_reference_roll  = roll_of(*m_sensor_ptr);
+	}
+
+	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		m_offsets[joint_id] = 0;
+	}
+
+	m_update_usec_max = 0;
+	m_enabled = enabled;
+}
+
+
+bool PLEN2::BalanceStabilizer::enabled()
+{
+	return m_enabled;
+}
+
+
+void PLEN2::BalanceStabilizer::update()
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("BalanceStabilizer::update()"));
+	#endif
+
+	if (!m_enabled)
+	{
+		return;
+	}
+
+	const unsigned long begin_usec = micros();
+
+	m_sensor_ptr->sampling();
+
+	// Tilt is wrapped to signed 16 bits, so crossing +/-180[deg] keeps continuity.
+	const int pitch_tilt = static_cast<short>(pitch_of(*m_sensor_ptr) - m_reference_pitch);
+	const int roll_tilt  = static_cast<short>(roll_of(*m_sensor_ptr)  - m_reference_roll);
+
+	const int pitch = m_calculate(pitch_tilt, m_sensor_ptr->getGyroPitch());
+	const int roll  = m_calculate(roll_tilt,  m_sensor_ptr->getGyroRoll());
+
+	/*!
+		@note
+		The ankles take the whole correction, and the hips take the half of it.
+		Angles of the right side are mirrored from the left side by inverting the sign.
+	*/
+	int* left  = m_offsets;
+	int* right = m_offsets + RIGHT_BEGIN;
+
+	left[JointController::LEFT_THIGH_PITCH]  =  pitch / 2;
+	left[JointController::LEFT_FOOT_PITCH]   =  pitch;
+	left[JointController::LEFT_THIGH_ROLL]   =  roll / 2;
+	left[JointController::LEFT_FOOT_ROLL]    =  roll;
+
+	right[JointController::LEFT_THIGH_PITCH] = -pitch / 2;
+	right[JointController::LEFT_FOOT_PITCH]  = -pitch;
+	right[JointController::LEFT_THIGH_ROLL]  = -roll / 2;
+	right[JointController::LEFT_FOOT_ROLL]   = -roll;
+
+	m_update_usec_last = micros() - begin_usec;
+
+	if (m_update_usec_last > m_update_usec_max)
+	{
+		m_update_usec_max = m_update_usec_last;
+	}
+}
+
+
+const int* PLEN2::BalanceStabilizer::offsets()
+{
+	return m_offsets;
+}
+
+
+void PLEN2::BalanceStabilizer::dump()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("BalanceStabilizer::dump()"));
+	#endif
+
+	System::outputSerial().println(F("{"));
+
+	System::outputSerial().print(F("\t\"enabled\": "));
+	System::outputSerial().print(static_cast<int>(m_enabled));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"pitch_offset\": "));
+	System::outputSerial().print(m_offsets[JointController::LEFT_FOOT_PITCH]);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"roll_offset\": "));
+	System::outputSerial().print(m_offsets[JointController::LEFT_FOOT_ROLL]);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"update_usec_last\": "));
+	System::outputSerial().print(m_update_usec_last);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"update_usec_max\": "));
+	System::outputSerial().println(m_update_usec_max);
+
+	System::outputSerial().println(F("}"));
+}
@@ -0,0 +1,118 @@
+/*!
+	@file      BalanceStabilizer.h
+	@brief     Closed-loop balance stabilizer using the acceleration and gyro sensor.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_BALANCE_STABILIZER_H
+#define PLEN2_BALANCE_STABILIZER_H
+
+#include "JointController.h"
+
+
+namespace PLEN2
+{
+	class AccelerationGyroSensor;
+	class BalanceStabilizer;
+}
+
+/*!
+	@brief Closed-loop balance stabilizer
+
+	The class samples the sensor at each control tick, and calculates corrective offsets
+	of the hip and ankle joints with a PD controller.
+	(P: tilt from the reference posture measured by the accelerometer, D: angular velocity measured by the gyro.)
+	<br><br>
+	The motion controller adds the offsets on its output before giving it to the joint controller.
+
+	@note
+	The reference posture is sampled when the stabilizer is enabled,
+	so please enable it when PLEN is standing.
+*/
+class PLEN2::BalanceStabilizer
+{
+private:
+	//! @brief Gain of tilt. (Q8 fixed-point)
+	inline static const int KP_Q8()      { return 128; }
+
+	//! @brief Gain of angular velocity. (Q8 fixed-point)
+	inline static const int KD_Q8()      { return 16;  }
+
+	//! @brief Max value of the corrective offsets. (Steps of degree 1/10.)
+	inline static const int OFFSET_MAX() { return 100; }
+
+	//! @brief Gyro sensitivity. (LSB per degree/sec, at +/-250 degree/sec full scale.)
+	inline static const int GYRO_LSB_PER_DPS() { return 131; }
+
+	int m_calculate(int tilt, int angular_velocity);
+
+
+	AccelerationGyroSensor* m_sensor_ptr;
+
+	bool m_enabled;
+
+	int m_reference_pitch;
+	int m_reference_roll;
+
+	int m_offsets[JointController::SUM];
+
+	unsigned long m_update_usec_last;
+	unsigned long m_update_usec_max;
+
+public:
+	/*!
+		@brief Constructor
+
+		@param [in, out] sensor An instance of the sensor class.
+	*/
+	BalanceStabilizer(AccelerationGyroSensor& sensor);
+
+	/*!
+		@brief Enable or disable the stabilizer
+
+		@param [in] enabled Please set true to enable.
+	*/
+	void enable(bool enabled);
+
+	/*!
+		@brief Decide the stabilizer is enabled
+
+		@return Result
+	*/
+	bool enabled();
+
+	/*!
+		@brief Sample the sensor and update the corrective offsets
+
+		Usage assumption is to call the method at each control tick.
+	*/
+	void update();
+
+	/*!
+		@brief Get the corrective offsets
+
+		@return Array of angle-diffs, which has JointController::SUM elements.
+	*/
+	const int* offsets();
+
+	/*!
+		@brief Dump the state and metrics of the stabilizer
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"enabled": <integer>,
+			"pitch_offset": <integer>,
+			"roll_offset": <integer>,
+			"update_usec_last": <integer>,
+			"update_usec_max": <integer>
+		}
+		@endcode
+	*/
+	void dump();
+};
+
+#endif // PLEN2_BALANCE_STABILIZER_H
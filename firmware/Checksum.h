@@ -0,0 +1,51 @@
+/*!
+	@file      Checksum.h
+	@brief     Provide checksum utilities.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef UTILITY_CHECKSUM_H
+#define UTILITY_CHECKSUM_H
+
+
+namespace Utility
+{
+	/*!
+		@brief Get CRC-32 of the bytes given
+
+		The polynomial is the same as zlib's one, so crc32("123456789") is 0xCBF43926.
+
+		@param [in] data Bytes you want to get the checksum.
+		@param [in] size Size of **data**.
+		@param [in] crc  Please set the result of the preceding bytes to continue, or 0 to begin.
+
+		@return CRC-32
+
+		@note
+		The method uses a table which has 256 entries, so it processes a byte per a lookup.
+		(The table is on the flash, so it uses no RAM.)
+	*/
+	unsigned long crc32(const unsigned char data[], unsigned int size, unsigned long crc = 0);
+
+	/*!
+		@brief Get CRC-16 of the bytes given
+
+		The polynomial is CCITT's one (0x1021, initial value 0xFFFF), so crc16("123456789") is 0x29B1.
+
+		@param [in] data Bytes you want to get the checksum.
+		@param [in] size Size of **data**.
+		@param [in] crc  Please set the result of the preceding bytes to continue, or 0xFFFF to begin.
+
+		@return CRC-16
+
+		@note
+		The method uses 2 tables which have 256 entries, so it processes 2 bytes per a pair of lookups.
+		(The tables are on the flash, and have 1024 bytes.)
+	*/
+	unsigned int crc16(const unsigned char data[], unsigned int size, unsigned int crc = 0xFFFF);
+}
+
+#endif // UTILITY_CHECKSUM_H
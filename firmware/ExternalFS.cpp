@@ -16,12 +16,116 @@ File fp_motion;
 File fp_config;
 File fp_syscfg;
 
+namespace
+{
+	using namespace PLEN2;
+
+	enum { FILL_BUFFER_SIZE = 64 };
+
+	/*!
+		@brief Write-back buffer of a transaction
+	*/
+	class Transaction
+	{
+	public:
+		File          fp;
+		unsigned char depth;
+		bool          loaded;
+		unsigned int  page_address;
+		unsigned int  dirty_begin; //!< Offset of the modified area in the page.
+		unsigned int  dirty_end;   //!< Offset of the end of the modified area in the page.
+		bool          failed;      //!< A write back of the transaction has failed.
+		unsigned char page[256 /* ExternalFs::PAGE_SIZE() */];
+	};
+
+	Transaction transaction;
+
+	unsigned long page_programs = 0;
+	unsigned long flushes       = 0;
+
+	unsigned long read_usec_last = 0;
+	unsigned long read_usec_max  = 0;
+
+	unsigned long seeks        = 0;
+	unsigned long seeks_elided = 0;
+	unsigned long cache_hits   = 0;
+	unsigned long cache_misses = 0;
+
+	enum { NAME_LENGTH = 32 };
+
+	/*!
+		@brief Read-ahead cache which has a SPIFFS page
+
+		It holds the bytes of the file only, and a buffered page of a transaction is applied over it.
+	*/
+	class ReadCache
+	{
+	public:
+		bool          loaded;
+		char          name[NAME_LENGTH];
+		unsigned int  page_address;
+		unsigned char page[256 /* ExternalFs::PAGE_SIZE() */];
+	};
+
+	ReadCache cache;
+
+	inline unsigned int pages_of(unsigned int start_addr, unsigned int size)
+	{
+		return (start_addr + size - 1) / ExternalFs::PAGE_SIZE() - start_addr / ExternalFs::PAGE_SIZE() + 1;
+	}
+
+	inline bool same_file(File& lhs, File& rhs)
+	{
+		return (lhs && rhs && (strcmp(lhs.name(), rhs.name()) == 0));
+	}
+
+	//! @brief Seek only when the position of the file differs from the address given.
+	inline bool seek_to(File& fp, unsigned int address)
+	{
+		if (fp.position() == address)
+		{
+			seeks_elided++;
+
+			return true;
+		}
+
+		seeks++;
+
+		return fp.seek(address, SeekSet);
+	}
+
+	inline bool cached(File& fp, unsigned int page_address)
+	{
+		return (
+			   cache.loaded
+			&& (cache.page_address == page_address)
+			&& (strcmp(cache.name, fp.name()) == 0)
+		);
+	}
+
+	//! @brief Discard the cached page if the file given is written.
+	inline void discard(File& fp)
+	{
+		if (   cache.loaded
+			&& (strcmp(cache.name, fp.name()) == 0) )
+		{
+			cache.loaded = false;
+		}
+	}
+
+	void create(const char* path)
+	{
+		if (!SPIFFS.exists(path))
+		{
+			File fp = SPIFFS.open(path, "w+");
+			fp.close();
+		}
+	}
+}
+
+
 void PLEN2::ExternalFs::init()
 {
-	File fp;
-    unsigned int i;
-	unsigned int start_addr;
-	unsigned char buf[BUF_SIZE] = {1};
     bool result = SPIFFS.begin();
 #if DEBUG
     System::debugSerial().println("SPIFFS opened: " + result);
@@ -31,33 +135,28 @@ void PLEN2::ExternalFs::init()
         !SPIFFS.exists(CONFIG_FILE) ||
         !SPIFFS.exists(SYSCFG_FILE))
     {
+        const unsigned long begin_msec = millis();
+
     	System::outputSerial().println("prepare fs......\n");
-        
-        fp = SPIFFS.open(MOTION_FILE, "w+");
-        for (i = 0, start_addr = 0; i < MOTION_FILE_SIZE / BUF_SIZE; i++, start_addr += BUF_SIZE)
-        {
-            write(start_addr, BUF_SIZE, buf, fp);       
-        }
-        fp.close();
-        
-        fp = SPIFFS.open(CONFIG_FILE, "w+");
-        for (i = 0, start_addr = 0; i < CONFIG_FILE_SIZE / BUF_SIZE; i++, start_addr += BUF_SIZE)
-        {
-            write(start_addr, BUF_SIZE, buf, fp);      
-        }
-        fp.close();
-        
-        fp = SPIFFS.open(SYSCFG_FILE, "w+");
-        for (i = 0, start_addr = 0; i < SYSCFG_FILE_SIZE / BUF_SIZE; i++, start_addr += BUF_SIZE)
-        {
-            write(start_addr, BUF_SIZE, buf, fp);        
-        }
-        fp.close();
-        System::outputSerial().println("fs formated\n");
+
+        /*!
+            @note
+            The files are not filled here, because unwritten bytes are read as FILL_VALUE().
+            It grows a file only up to the written address, not to MOTION_FILE_SIZE.
+        */
+        create(MOTION_FILE);
+        create(CONFIG_FILE);
+        create(SYSCFG_FILE);
+
+        System::outputSerial().print("fs formated in ");
+        System::outputSerial().print(millis() - begin_msec);
+        System::outputSerial().println(" [ms]\n");
     }
     fp_motion = SPIFFS.open(MOTION_FILE, "r+");
     fp_config = SPIFFS.open(CONFIG_FILE, "r+");
     fp_syscfg = SPIFFS.open(SYSCFG_FILE, "r+");
+
+    invalidate();
 }
 
 void PLEN2::ExternalFs::de_init()
@@ -76,15 +175,324 @@ void PLEN2::ExternalFs::de_init()
     }
 }
 
-char PLEN2::ExternalFs::read(
+unsigned int PLEN2::ExternalFs::m_readSparse(
+    unsigned int start_addr,
+    unsigned int size,
+    unsigned char data[],
+    File fp)
+{
+    const unsigned int file_size = fp.size();
+    unsigned int position = 0;
+
+    /*!
+        @note
+        The bytes are served from the read-ahead cache page by page,
+        so consecutive small reads cost only one physical read per page.
+    */
+    while (position < size)
+    {
+        const unsigned int address      = start_addr + position;
+        const unsigned int page_address = address - (address % PAGE_SIZE());
+        const unsigned int offset       = address - page_address;
+        const unsigned int length       = min(size - position, PAGE_SIZE() - offset);
+
+        if (page_address >= file_size)
+        {
+            // The area over the end of the file has not been written yet.
+            memset(data + position, FILL_VALUE(), size - position);
+            break;
+        }
+
+        if (cached(fp, page_address))
+        {
+            cache_hits++;
+        }
+        else
+        {
+            cache_misses++;
+            cache.loaded = false;
+
+            if (!seek_to(fp, page_address))
+            {
+                System::debugSerial().println(F(">>>readSparse Seek Error"));
+            }
+
+            const unsigned int read_size = fp.read(cache.page, min(static_cast<unsigned int>(PAGE_SIZE()), file_size - page_address));
+            memset(cache.page + read_size, FILL_VALUE(), PAGE_SIZE() - read_size);
+
+            strncpy(cache.name, fp.name(), NAME_LENGTH - 1);
+            cache.name[NAME_LENGTH - 1] = '\0';
+            cache.page_address = page_address;
+            cache.loaded       = true;
+        }
+
+        memcpy(data + position, cache.page + offset, length);
+        position += length;
+    }
+
+    // The buffered page of a transaction is newer than the file.
+    if (transaction.loaded && same_file(fp, transaction.fp))
+    {
+        const unsigned int overlap_begin = max(start_addr, transaction.page_address);
+        const unsigned int overlap_end   = min(start_addr + size, transaction.page_address + PAGE_SIZE());
+
+        if (overlap_begin < overlap_end)
+        {
+            memcpy(
+                data + (overlap_begin - start_addr),
+                transaction.page + (overlap_begin - transaction.page_address),
+                overlap_end - overlap_begin
+            );
+        }
+    }
+
+    return size;
+}
+
+bool PLEN2::ExternalFs::m_grow(unsigned int end_addr, File fp)
+{
+    #if DEBUG
+        volatile Utility::Profiler p(F("ExternalFs::m_grow()"));
+    #endif
+
+    unsigned int file_size = fp.size();
+
+    if (file_size >= end_addr)
+    {
+        return true;
+    }
+
+    unsigned char buf[FILL_BUFFER_SIZE];
+    memset(buf, FILL_VALUE(), sizeof(buf));
+
+    discard(fp);
+    seek_to(fp, file_size);
+
+    while (file_size < end_addr)
+    {
+        const unsigned int write_size = min(static_cast<unsigned int>(sizeof(buf)), end_addr - file_size);
+
+        if (fp.write(buf, write_size) != write_size)
+        {
+            System::debugSerial().println(F(">>>grow: Write Error"));
+            return false;
+        }
+
+        file_size += write_size;
+    }
+
+    return true;
+}
+
+bool PLEN2::ExternalFs::m_inTransaction(File fp)
+{
+    return ((transaction.depth > 0) && same_file(fp, transaction.fp));
+}
+
+void PLEN2::ExternalFs::m_bufferedWrite(
+    unsigned int start_addr,
+    unsigned int size,
+    const unsigned char data[])
+{
+    while (size > 0)
+    {
+        const unsigned int page_address = start_addr - (start_addr % PAGE_SIZE());
+
+        if (!transaction.loaded || (transaction.page_address != page_address))
+        {
+            if (!m_writeBack())
+            {
+                transaction.failed = true;
+            }
+
+            transaction.loaded = false;
+            m_readSparse(page_address, PAGE_SIZE(), transaction.page, transaction.fp);
+
+            transaction.loaded       = true;
+            transaction.page_address = page_address;
+            transaction.dirty_begin  = PAGE_SIZE();
+            transaction.dirty_end    = 0;
+        }
+
+        const unsigned int offset = start_addr - page_address;
+        const unsigned int length = min(size, PAGE_SIZE() - offset);
+
+        memcpy(transaction.page + offset, data, length);
+
+        transaction.dirty_begin = min(transaction.dirty_begin, offset);
+        transaction.dirty_end   = max(transaction.dirty_end, offset + length);
+
+        start_addr += length;
+        data       += length;
+        size       -= length;
+    }
+}
+
+bool PLEN2::ExternalFs::m_writeBack()
+{
+    if (!transaction.loaded || (transaction.dirty_begin >= transaction.dirty_end))
+    {
+        return true;
+    }
+
+    const unsigned int start_addr = transaction.page_address + transaction.dirty_begin;
+    const unsigned int size       = transaction.dirty_end - transaction.dirty_begin;
+
+    bool result = m_grow(start_addr, transaction.fp);
+
+    if (result)
+    {
+        discard(transaction.fp);
+        seek_to(transaction.fp, start_addr);
+        result = (transaction.fp.write(transaction.page + transaction.dirty_begin, size) == size);
+        page_programs++;
+    }
+
+    transaction.dirty_begin = PAGE_SIZE();
+    transaction.dirty_end   = 0;
+
+    return result;
+}
+
+bool PLEN2::ExternalFs::begin(File fp)
+{
+    #if DEBUG
+        volatile Utility::Profiler p(F("ExternalFs::begin()"));
+    #endif
+
+    if (transaction.depth > 0)
+    {
+        if (!same_file(fp, transaction.fp))
+        {
+            #if DEBUG_LESS
+                System::debugSerial().println(F(">>> error : Another file has a transaction."));
+            #endif
+
+            return false;
+        }
+
+        transaction.depth++;
+
+        return true;
+    }
+
+    transaction.fp     = fp;
+    transaction.depth  = 1;
+    transaction.loaded = false;
+    transaction.failed = false;
+
+    return true;
+}
+
+bool PLEN2::ExternalFs::commit()
+{
+    #if DEBUG
+        volatile Utility::Profiler p(F("ExternalFs::commit()"));
+    #endif
+
+    if (transaction.depth == 0)
+    {
+        #if DEBUG_LESS
+            System::debugSerial().println(F(">>> error : There is no transaction."));
+        #endif
+
+        return false;
+    }
+
+    if (--transaction.depth > 0)
+    {
+        return true;
+    }
+
+    const bool result = m_writeBack() && !(transaction.failed);
+
+    transaction.fp.flush();
+    flushes++;
+
+    transaction.loaded = false;
+    transaction.fp     = File();
+
+    #if DEBUG_LESS
+        if (!result)
+        {
+            System::debugSerial().println(F(">>> error : Writing back the transaction failed."));
+        }
+    #endif
+
+    return result;
+}
+
+bool PLEN2::ExternalFs::inTransaction()
+{
+    return (transaction.depth > 0);
+}
+
+void PLEN2::ExternalFs::invalidate()
+{
+    cache.loaded = false;
+}
+
+void PLEN2::ExternalFs::dump()
+{
+    System::outputSerial().println(F("{"));
+
+    System::outputSerial().print(F("\t\"transaction_depth\": "));
+    System::outputSerial().print(static_cast<int>(transaction.depth));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"page_programs\": "));
+    System::outputSerial().print(page_programs);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"flushes\": "));
+    System::outputSerial().print(flushes);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"read_usec_last\": "));
+    System::outputSerial().print(read_usec_last);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"read_usec_max\": "));
+    System::outputSerial().print(read_usec_max);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"seeks\": "));
+    System::outputSerial().print(seeks);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"seeks_elided\": "));
+    System::outputSerial().print(seeks_elided);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"cache_hits\": "));
+    System::outputSerial().print(cache_hits);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"cache_misses\": "));
+    System::outputSerial().print(cache_misses);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"cache_hit_rate_percent\": "));
+    System::outputSerial().println(cache_hits * 100 / max(cache_hits + cache_misses, 1UL));
+
+    System::outputSerial().println(F("}"));
+}
+
+int PLEN2::ExternalFs::read(
     unsigned int start_addr,
     unsigned int size,
     unsigned char data[],File fp)
 {
     if (fp)
     {
-        fp.seek(start_addr, SeekSet);  
-        return fp.read(data, size);
+        const unsigned long begin_usec = micros();
+
+        const int result = m_readSparse(start_addr, size, data, fp);
+
+        read_usec_last = micros() - begin_usec;
+        read_usec_max  = max(read_usec_max, read_usec_last);
+
+        return result;
     }
     return -1;
 }
@@ -97,9 +505,21 @@ char PLEN2::ExternalFs::write(
     unsigned int write_size;
     if (fp)
     {
-        fp.seek(start_addr, SeekSet);
+        if (m_inTransaction(fp))
+        {
+            m_bufferedWrite(start_addr, size, data);
+            return true;
+        }
+        if (!m_grow(start_addr, fp))
+        {
+            return false;
+        }
+        discard(fp);
+        seek_to(fp, start_addr);
         write_size = fp.write(data, size);
         fp.flush();
+        page_programs += pages_of(start_addr, size);
+        flushes++;
         return write_size == size;
     }
     return -1;
@@ -112,8 +532,7 @@ unsigned char PLEN2::ExternalFs::readByte(
     unsigned char data;
     if (fp)
     {
-        fp.seek(start_addr, SeekSet);  
-        data = (unsigned char )fp.read();
+        m_readSparse(start_addr, 1, &data, fp);
         return data;
     }
     return -1;
@@ -126,9 +545,21 @@ char PLEN2::ExternalFs::writeByte(
     unsigned int write_size;
     if (fp)
     {
-        fp.seek(start_addr, SeekSet);
+        if (m_inTransaction(fp))
+        {
+            m_bufferedWrite(start_addr, 1, &data);
+            return true;
+        }
+        if (!m_grow(start_addr, fp))
+        {
+            return false;
+        }
+        discard(fp);
+        seek_to(fp, start_addr);
         write_size = fp.write(data);
         fp.flush();
+        page_programs++;
+        flushes++;
         return write_size == 1;
     }
     return 0;
@@ -169,11 +600,7 @@ char PLEN2::ExternalFs::readSlot(
 		System::debugSerial().print(F(" : "));
 		System::debugSerial().println(data_address, HEX);
 	#endif
-	if (!fp.seek(data_address, SeekSet))
-	{
-        System::debugSerial().println(F(">>>readSlot Seek Error"));
-	}
-	read_size = fp.read(data, read_size);
+	read_size = m_readSparse(data_address, read_size, data, fp);
 	return read_size;
 }
 
@@ -216,11 +643,25 @@ char PLEN2::ExternalFs::writeSlot(
 		System::debugSerial().println(data_address, HEX);
 	#endif
 
-	if(!fp.seek(data_address, SeekSet))
+	if (m_inTransaction(fp))
+	{
+		m_bufferedWrite(data_address, write_size, data);
+		return 0;
+	}
+
+	if (!m_grow(data_address, fp))
+	{
+		return 4;
+	}
+	discard(fp);
+
+	if(!seek_to(fp, data_address))
 	{
         System::debugSerial().println(F(">>>writeSlot: Seek Error"));
 	}
-	write_size = fp.write(data, write_size);
+	const unsigned char written_size = fp.write(data, write_size);
 	fp.flush();
-	return 0;
-}
+	page_programs += pages_of(data_address, written_size);
+	flushes++;
+	return (written_size == write_size)? 0 : 4;
+}
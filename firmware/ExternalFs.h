@@ -9,11 +9,20 @@
 
 #ifndef PLEN2_EXTERNAL_FS_H
 #define PLEN2_EXTERNAL_FS_H
-#include "FS.h"
+#if defined(ARDUINO)
+	#include "FS.h"
+#else
+	#include "HostFs.h" // Backend to run the storage on a host.
+#endif
 
 
-#define MOTION_FILE  "/motion.bin"
-#define MOTION_FILE_SIZE 0x200000L
+#define MOTION_FILE  "/motion_log.bin"
+#define MOTION_FILE_SIZE 0x100000L
+
+#define MOTION_FILE_COMPACTING "/motion_log.tmp"
+#define MOTION_CHECKPOINT_FILE "/motion_idx.bin"
+
+#define MOTION_FILE_LEGACY "/motion.bin" // Layout version 1.
 
 #define CONFIG_FILE  "/joint_cfg.bin"
 #define CONFIG_FILE_SIZE 0x1000L
@@ -38,6 +47,12 @@ namespace PLEN2
 	Please pay attention to it is including bytes of targeted area address (= 2 bytes).
 	Accurate data size are 30 bytes that you can write.
 	(This is the reason that there are differences between CHUNK_SIZE() and SLOT_SIZE().)
+	<br><br>
+	The files are created empty and grow on demand.
+	Reading bytes which have not been written yet gives FILL_VALUE() without any physical access.
+	<br><br>
+	Reads are served from a read-ahead cache which has a SPIFFS page,
+	and a seek is skipped when the file is already at the address.
 */
 class PLEN2::ExternalFs
 {
@@ -46,6 +61,13 @@ private:
 	//! @brief Size of external SPIFs (bytes)
 	inline static const long SIZE()          { return MOTION_FILE_SIZE; }
 
+	static unsigned int m_readSparse(unsigned int start_addr, unsigned int size, unsigned char data[], File fp);
+	static bool m_grow(unsigned int end_addr, File fp);
+
+	static bool m_inTransaction(File fp);
+	static void m_bufferedWrite(unsigned int start_addr, unsigned int size, const unsigned char data[]);
+	static bool m_writeBack();
+
 public:
 	//! @brief Chunk size of external EEPROM (bytes)
 	inline static const int CHUNK_SIZE() { return 32; }
@@ -59,16 +81,97 @@ public:
 	//! @brief End value of slots
 	inline static const int SLOT_END()   { return SIZE() / CHUNK_SIZE(); }
 
+	//! @brief Value of the bytes which have not been written yet
+	inline static const unsigned char FILL_VALUE() { return 0x01; }
+
+	//! @brief Logical page size of SPIFFS (bytes)
+	inline static const int PAGE_SIZE()  { return 256; }
+
 	/*!
 		@brief Constructor
 	*/
 	static void init();
     static void de_init();
-    static char read(unsigned int start_addr, unsigned int size, unsigned char data[], File fp);
+
+	/*!
+		@brief Read bytes of the file given through the read-ahead cache
+
+		The bytes over the end of the file are read as FILL_VALUE().
+
+		@return Count of the bytes read, or -1 if the file is not open.
+	*/
+    static int read(unsigned int start_addr, unsigned int size, unsigned char data[], File fp);
+
     static char write(unsigned int start_addr, unsigned int size, const unsigned char data[], File fp);
     static unsigned char readByte(unsigned int start_addr, File fp);
     static char writeByte(unsigned int start_addr, const unsigned char data, File fp);
 
+	/*!
+		@brief Begin a write transaction of the file given
+
+		Until commit(), writes to **fp** are stored in a write-back buffer which has a SPIFFS page,
+		and the page is written to the file only when a write goes out of it.
+		Reads of **fp** see the buffered data.
+		<br><br>
+		Transactions can be nested, and only the outermost commit() writes back and flushes.
+
+		@param [in] fp Please set the file you want to write.
+
+		@return Result
+		@retval false Another file has a transaction now.
+	*/
+	static bool begin(File fp);
+
+	/*!
+		@brief Commit the write transaction
+
+		Writes back the buffered page, and flushes the file only once.
+		A failure of a write back in the transaction, even of a page written back on the way, fails the outermost commit().
+
+		@return Result
+		@retval false There is no transaction, or writing back failed.
+	*/
+	static bool commit();
+
+	/*!
+		@brief Decide there is a transaction now
+
+		@return Result
+	*/
+	static bool inTransaction();
+
+	/*!
+		@brief Discard the read-ahead cache
+
+		Please call it after changing a file without the class. (e.g. truncating or replacing it.)
+	*/
+	static void invalidate();
+
+	/*!
+		@brief Dump the statistics of writing
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"transaction_depth": <integer>,
+			"page_programs": <integer>,
+			"flushes": <integer>,
+			"read_usec_last": <integer>,
+			"read_usec_max": <integer>,
+			"seeks": <integer>,
+			"seeks_elided": <integer>,
+			"cache_hits": <integer>,
+			"cache_misses": <integer>,
+			"cache_hit_rate_percent": <integer>
+		}
+		@endcode
+
+		@note
+		"page_programs" counts the SPIFFS pages which are touched by physical writes.
+		"cache_hits" and "cache_misses" count the pages served to reads.
+	*/
+	static void dump();
+
     /*!
 		@brief Read a slot of external EEPROM
 
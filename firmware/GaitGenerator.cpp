@@ -0,0 +1,237 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "System.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "GaitGenerator.h"
+#include "Trigonometry.h"
+#include "Profiler.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	enum {
+		PHASE_STEP  = Utility::BINARY_ANGLE_1 / GaitGenerator::KEYFRAMES_PER_PERIOD,
+		PHASE_HALF  = Utility::BINARY_ANGLE_1 / 2,
+		RIGHT_BEGIN = JointController::RIGHT_SHOULDER_PITCH
+	};
+
+	inline int scale(int amplitude, int value_q15)
+	{
+		return static_cast<int>((static_cast<long>(amplitude) * value_q15) >> 15);
+	}
+
+	/*!
+		@brief Set the angles of a half body
+
+		@param [out] frame  Frame to store the angles.
+		@param [in]  begin  Joint id of the half body's shoulder pitch.
+		@param [in]  sign   Direction of the half body. (Left side is 1, right side is -1.)
+		@param [in]  phase  Binary angle of the leg.
+		@param [in]  sway   Angle of thigh roll, which is shared by the both legs.
+		@param [in]  params Gait parameters.
+	*/
+	void setHalfBody(
+		Motion::Frame& frame,
+		unsigned char begin,
+		int sign,
+		unsigned int phase,
+		int sway,
+		const GaitGenerator::Parameters& params
+	)
+	{
+		const int sin_value = Utility::sin_q15(phase);
+		const int cos_value = Utility::cos_q15(phase);
+
+		// The leg is lifted while it swings forward.
+		const int swing = scale(params.step_length, sin_value);
+		const int lift  = (cos_value > 0)? scale(params.height, cos_value) : 0;
+
+		int* angle = frame.joint_angle + begin;
+
+		angle[JointController::LEFT_SHOULDER_PITCH] = -swing * sign;
+		angle[JointController::LEFT_THIGH_YAW]      = scale(params.turn_rate, sin_value) * sign;
+		angle[JointController::LEFT_THIGH_ROLL]     = sway * sign;
+		angle[JointController::LEFT_THIGH_PITCH]    = (swing + lift) * sign;
+		angle[JointController::LEFT_KNEE_PITCH]     = -2 * lift * sign;
+		angle[JointController::LEFT_FOOT_PITCH]     = (lift - swing) * sign; // Keep the sole parallel to the ground.
+		angle[JointController::LEFT_FOOT_ROLL]      = -sway * sign;
+	}
+}
+
+
+PLEN2::GaitGenerator::GaitGenerator()
+	: m_phase(0)
+	, m_keyframe(0)
+	, m_running(false)
+	, m_stopping(false)
+	, m_generate_usec_last(0)
+	, m_generate_usec_max(0)
+{
+	m_params.step_length = 150;
+	m_params.height      = 200;
+	m_params.period_ms   = 800;
+	m_params.turn_rate   = 0;
+}
+
+
+bool PLEN2::GaitGenerator::setParameters(const Parameters& params)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("GaitGenerator::setParameters()"));
+	#endif
+
+	if (   (params.period_ms < PERIOD_MIN_MS)
+		|| (params.period_ms > PERIOD_MAX_MS) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : period_ms = "));
+			System::debugSerial().println(params.period_ms);
+		#endif
+
+		return false;
+	}
+
+	if (   (abs(params.step_length) > AMPLITUDE_MAX)
+		|| (abs(params.height)      > AMPLITUDE_MAX)
+		|| (abs(params.turn_rate)   > AMPLITUDE_MAX) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> bad argment : amplitude is out of range."));
+		#endif
+
+		return false;
+	}
+
+
+	m_params = params;
+
+	return true;
+}
+
+
+const PLEN2::GaitGenerator::Parameters& PLEN2::GaitGenerator::getParameters()
+{
+	return m_params;
+}
+
+
+void PLEN2::GaitGenerator::start()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("GaitGenerator::start()"));
+	#endif
+
+	m_phase    = 0;
+	m_keyframe = 0;
+	m_running  = true;
+	m_stopping = false;
+}
+
+
+void PLEN2::GaitGenerator::willStop()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("GaitGenerator::willStop()"));
+	#endif
+
+	m_stopping = true;
+}
+
+
+bool PLEN2::GaitGenerator::running()
+{
+	return m_running;
+}
+
+
+void PLEN2::GaitGenerator::generate(Motion::Frame& frame)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("GaitGenerator::generate()"));
+	#endif
+
+	const unsigned long begin_usec = micros();
+
+	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		frame.joint_angle[joint_id] = 0;
+	}
+
+	frame.index              = m_keyframe;
+	frame.transition_time_ms = m_params.period_ms / KEYFRAMES_PER_PERIOD;
+
+	/*!
+		@note
+		Stopping is delayed until the end of a gait period, and then a neutral frame is generated.
+	*/
+	if (m_stopping && (m_phase == 0))
+	{
+		m_running = false;
+	}
+	else
+	{
+		m_phase    = (m_phase + PHASE_STEP) & (Utility::BINARY_ANGLE_1 - 1);
+		m_keyframe = (m_keyframe + 1) % KEYFRAMES_PER_PERIOD;
+
+		const int sway = scale(m_params.height / 2, Utility::sin_q15(m_phase));
+
+		setHalfBody(frame, 0,           1,  m_phase,              sway, m_params);
+		setHalfBody(frame, RIGHT_BEGIN, -1, m_phase + PHASE_HALF, sway, m_params);
+	}
+
+	m_generate_usec_last = micros() - begin_usec;
+
+	if (m_generate_usec_last > m_generate_usec_max)
+	{
+		m_generate_usec_max = m_generate_usec_last;
+	}
+}
+
+
+void PLEN2::GaitGenerator::dump()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("GaitGenerator::dump()"));
+	#endif
+
+	System::outputSerial().println(F("{"));
+
+	System::outputSerial().print(F("\t\"step_length\": "));
+	System::outputSerial().print(m_params.step_length);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"height\": "));
+	System::outputSerial().print(m_params.height);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"period_ms\": "));
+	System::outputSerial().print(m_params.period_ms);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"turn_rate\": "));
+	System::outputSerial().print(m_params.turn_rate);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"running\": "));
+	System::outputSerial().print(static_cast<int>(m_running));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"generate_usec_last\": "));
+	System::outputSerial().print(m_generate_usec_last);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"generate_usec_max\": "));
+	System::outputSerial().println(m_generate_usec_max);
+
+	System::outputSerial().println(F("}"));
+}
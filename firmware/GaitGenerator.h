@@ -0,0 +1,139 @@
+/*!
+	@file      GaitGenerator.h
+	@brief     Procedural gait generator.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_GAIT_GENERATOR_H
+#define PLEN2_GAIT_GENERATOR_H
+
+#include "Motion.h"
+
+
+namespace PLEN2
+{
+	class GaitGenerator;
+}
+
+/*!
+	@brief Procedural gait generator
+
+	The class generates walking frames on the fly with a fixed-point oscillator,
+	so the motion controller can play a gait without reading any stored motion.
+	<br><br>
+	A gait period is divided into KEYFRAMES_PER_PERIOD keyframes,
+	and the motion controller interpolates between them at the control rate.
+
+	@note
+	All angles are angle-diffs from the home positions, and have steps of degree 1/10.
+	Angles of the right side are mirrored from the left side by inverting the sign.
+*/
+class PLEN2::GaitGenerator
+{
+public:
+	enum {
+		KEYFRAMES_PER_PERIOD = 8, //!< Keyframes generated in a gait period.
+
+		PERIOD_MIN_MS = Motion::Frame::UPDATE_INTERVAL_MS * KEYFRAMES_PER_PERIOD, //!< Min value of a gait period.
+		PERIOD_MAX_MS = 10000,                                                    //!< Max value of a gait period.
+
+		AMPLITUDE_MAX = 450 //!< Max value of amplitudes.
+	};
+
+	/*!
+		@brief Gait parameters
+	*/
+	class Parameters
+	{
+	public:
+		int          step_length; //!< Amplitude of thigh pitch. (Negative value walks backward.)
+		int          height;      //!< Amplitude of foot lifting on knee pitch.
+		unsigned int period_ms;   //!< Time of a gait period.
+		int          turn_rate;   //!< Amplitude of thigh yaw. (Negative value turns right.)
+	};
+
+	/*!
+		@brief Constructor
+	*/
+	GaitGenerator();
+
+	/*!
+		@brief Set gait parameters
+
+		The parameters can be changed while the gait is running.
+		They take effect from the next keyframe, and the motion controller interpolates the change.
+
+		@param [in] params Gait parameters.
+
+		@return Result
+	*/
+	bool setParameters(const Parameters& params);
+
+	/*!
+		@brief Get gait parameters
+
+		@return Reference of gait parameters
+	*/
+	const Parameters& getParameters();
+
+	/*!
+		@brief Start generating from beginning of a gait period
+	*/
+	void start();
+
+	/*!
+		@brief Will stop generating
+
+		The method doesn't stop the gait just after running itself,
+		but will stop it when the gait period has finished and the neutral frame has been generated.
+	*/
+	void willStop();
+
+	/*!
+		@brief Decide the generator has a frame to generate
+
+		@return Result
+	*/
+	bool running();
+
+	/*!
+		@brief Generate the next keyframe
+
+		@param [out] frame Frame to store the keyframe.
+	*/
+	void generate(Motion::Frame& frame);
+
+	/*!
+		@brief Dump the gait parameters and metrics
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"step_length": <integer>,
+			"height": <integer>,
+			"period_ms": <integer>,
+			"turn_rate": <integer>,
+			"running": <integer>,
+			"generate_usec_last": <integer>,
+			"generate_usec_max": <integer>
+		}
+		@endcode
+	*/
+	void dump();
+
+private:
+	Parameters m_params;
+
+	unsigned int  m_phase;
+	unsigned char m_keyframe;
+	bool          m_running;
+	bool          m_stopping;
+
+	unsigned long m_generate_usec_last;
+	unsigned long m_generate_usec_max;
+};
+
+#endif // PLEN2_GAIT_GENERATOR_H
@@ -0,0 +1,363 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#if !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HostFs.h"
+
+FS SPIFFS;
+
+
+namespace PLEN2
+{
+	/*!
+		@brief Mapping of an opened file
+
+		The whole window is mapped at opening, and only the file size is changed to grow,
+		so the address of the mapping is never moved.
+	*/
+	class HostMapping
+	{
+	public:
+		enum {
+			NAME_LENGTH = 32,
+			WINDOW_SIZE = 0x1000000 //!< Max size of a file. (16 MB)
+		};
+
+		int            fd;
+		unsigned char* base;
+		size_t         size;
+		int            references;
+		char           name[NAME_LENGTH];
+	};
+}
+
+
+namespace
+{
+	using namespace PLEN2;
+
+	void host_path(const char* path, char result[], size_t size)
+	{
+		const char* root = getenv("PLEN2_FS_ROOT");
+
+		snprintf(result, size, "%s%s", (root != NULL)? root : ".", path);
+	}
+
+	void release(HostMapping* mapping)
+	{
+		if (   (mapping == NULL)
+			|| (--mapping->references > 0) )
+		{
+			return;
+		}
+
+		munmap(mapping->base, HostMapping::WINDOW_SIZE);
+		close(mapping->fd);
+
+		delete mapping;
+	}
+}
+
+
+File::File()
+	: m_mapping(NULL)
+	, m_position(0)
+{
+	// noop.
+}
+
+File::File(HostMapping* mapping)
+	: m_mapping(mapping)
+	, m_position(0)
+{
+	// noop.
+}
+
+File::File(const File& other)
+	: m_mapping(other.m_mapping)
+	, m_position(other.m_position)
+{
+	if (m_mapping != NULL)
+	{
+		m_mapping->references++;
+	}
+}
+
+File& File::operator=(const File& other)
+{
+	if (other.m_mapping != NULL)
+	{
+		other.m_mapping->references++;
+	}
+
+	release(m_mapping);
+
+	m_mapping  = other.m_mapping;
+	m_position = other.m_position;
+
+	return *this;
+}
+
+File::~File()
+{
+	release(m_mapping);
+}
+
+
+size_t File::write(uint8_t data)
+{
+	return write(&data, 1);
+}
+
+size_t File::write(const uint8_t* data, size_t size)
+{
+	if (   (m_mapping == NULL)
+		|| (m_position + size > HostMapping::WINDOW_SIZE) )
+	{
+		return 0;
+	}
+
+	if (m_position + size > m_mapping->size)
+	{
+		if (ftruncate(m_mapping->fd, m_position + size) != 0)
+		{
+			return 0;
+		}
+
+		m_mapping->size = m_position + size;
+	}
+
+	memcpy(m_mapping->base + m_position, data, size);
+	m_position += size;
+
+	return size;
+}
+
+int File::read()
+{
+	uint8_t data;
+
+	return (read(&data, 1) == 1)? data : -1;
+}
+
+size_t File::read(uint8_t* data, size_t size)
+{
+	if (   (m_mapping == NULL)
+		|| (m_position >= m_mapping->size) )
+	{
+		return 0;
+	}
+
+	if (size > m_mapping->size - m_position)
+	{
+		size = m_mapping->size - m_position;
+	}
+
+	memcpy(data, m_mapping->base + m_position, size);
+	m_position += size;
+
+	return size;
+}
+
+int File::peek()
+{
+	if (   (m_mapping == NULL)
+		|| (m_position >= m_mapping->size) )
+	{
+		return -1;
+	}
+
+	return m_mapping->base[m_position];
+}
+
+int File::available()
+{
+	if (   (m_mapping == NULL)
+		|| (m_position >= m_mapping->size) )
+	{
+		return 0;
+	}
+
+	return m_mapping->size - m_position;
+}
+
+void File::flush()
+{
+	// noop. (The mapping is shared with the page cache.)
+}
+
+bool File::seek(uint32_t position, SeekMode mode)
+{
+	if (m_mapping == NULL)
+	{
+		return false;
+	}
+
+	size_t base = (mode == SeekSet)? 0 : (mode == SeekCur)? m_position : m_mapping->size;
+
+	if (base + position > m_mapping->size)
+	{
+		return false;
+	}
+
+	m_position = base + position;
+
+	return true;
+}
+
+size_t File::position() const
+{
+	return m_position;
+}
+
+size_t File::size() const
+{
+	return (m_mapping == NULL)? 0 : m_mapping->size;
+}
+
+bool File::truncate(uint32_t size)
+{
+	if (   (m_mapping == NULL)
+		|| (ftruncate(m_mapping->fd, size) != 0) )
+	{
+		return false;
+	}
+
+	m_mapping->size = size;
+
+	if (m_position > size)
+	{
+		m_position = size;
+	}
+
+	return true;
+}
+
+void File::close()
+{
+	release(m_mapping);
+
+	m_mapping  = NULL;
+	m_position = 0;
+}
+
+const char* File::name() const
+{
+	return (m_mapping == NULL)? "" : m_mapping->name;
+}
+
+File::operator bool() const
+{
+	return (m_mapping != NULL);
+}
+
+
+bool FS::begin()
+{
+	return true;
+}
+
+bool FS::exists(const char* path)
+{
+	char host[256];
+	struct stat status;
+
+	host_path(path, host, sizeof(host));
+
+	return (stat(host, &status) == 0);
+}
+
+File FS::open(const char* path, const char* mode)
+{
+	char host[256];
+	host_path(path, host, sizeof(host));
+
+	int flags = (mode[0] == 'r')? 0 : (O_CREAT | O_TRUNC);
+
+	if (   (mode[0] == 'a')
+		|| (mode[0] == 'w')
+		|| (mode[1] == '+') )
+	{
+		flags |= O_RDWR;
+	}
+
+	if (mode[0] == 'a')
+	{
+		flags &= ~O_TRUNC;
+	}
+
+	const int fd = ::open(host, flags, 0644);
+
+	if (fd < 0)
+	{
+		return File();
+	}
+
+	struct stat status;
+	fstat(fd, &status);
+
+	void* base = mmap(
+		NULL, HostMapping::WINDOW_SIZE, (flags & O_RDWR)? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0
+	);
+
+	if (base == MAP_FAILED)
+	{
+		::close(fd);
+
+		return File();
+	}
+
+	HostMapping* mapping = new HostMapping();
+
+	mapping->fd         = fd;
+	mapping->base       = static_cast<unsigned char*>(base);
+	mapping->size       = status.st_size;
+	mapping->references = 1;
+
+	strncpy(mapping->name, path, HostMapping::NAME_LENGTH - 1);
+	mapping->name[HostMapping::NAME_LENGTH - 1] = '\0';
+
+	File file(mapping);
+
+	if (mode[0] == 'a')
+	{
+		file.seek(0, SeekEnd);
+	}
+
+	return file;
+}
+
+bool FS::remove(const char* path)
+{
+	char host[256];
+	host_path(path, host, sizeof(host));
+
+	return (unlink(host) == 0);
+}
+
+bool FS::rename(const char* path_from, const char* path_to)
+{
+	char host_from[256];
+	char host_to[256];
+
+	host_path(path_from, host_from, sizeof(host_from));
+	host_path(path_to, host_to, sizeof(host_to));
+
+	return (::rename(host_from, host_to) == 0);
+}
+
+#endif // !defined(ARDUINO)
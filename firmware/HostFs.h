@@ -0,0 +1,88 @@
+/*!
+	@file      HostFs.h
+	@brief     Memory mapped file system to run the storage on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_HOST_FS_H
+#define PLEN2_HOST_FS_H
+
+#if !defined(ARDUINO)
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+enum SeekMode
+{
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+namespace PLEN2
+{
+	class HostMapping;
+}
+
+/*!
+	@brief File of the host backend
+
+	It has the same interface as the subset of FS.h's File which the storage uses,
+	and the copies share the same opened file like FS.h's one.
+	The file is mapped to memory, so reads and writes are only memory copies.
+*/
+class File
+{
+public:
+	File();
+	File(PLEN2::HostMapping* mapping);
+	File(const File& other);
+	File& operator=(const File& other);
+	~File();
+
+	size_t write(uint8_t data);
+	size_t write(const uint8_t* data, size_t size);
+	int    read();
+	size_t read(uint8_t* data, size_t size);
+	int    peek();
+	int    available();
+	void   flush();
+	bool   seek(uint32_t position, SeekMode mode = SeekSet);
+	size_t position() const;
+	size_t size() const;
+	bool   truncate(uint32_t size);
+	void   close();
+	const char* name() const;
+
+	operator bool() const;
+
+private:
+	PLEN2::HostMapping* m_mapping;
+	size_t              m_position;
+};
+
+/*!
+	@brief File system of the host backend
+
+	Paths are mapped under the directory given by environment variable "PLEN2_FS_ROOT".
+	(The current directory is used if it is not set.)
+*/
+class FS
+{
+public:
+	bool begin();
+	bool exists(const char* path);
+	File open(const char* path, const char* mode);
+	bool remove(const char* path);
+	bool rename(const char* path_from, const char* path_to);
+};
+
+extern FS SPIFFS;
+
+#endif // !defined(ARDUINO)
+
+#endif // PLEN2_HOST_FS_H
@@ -74,7 +74,7 @@ bool PLEN2::Interpreter::popCode()
 	Code& doing = m_code_queue[m_queue_begin];
 	m_queue_begin = getIndex(m_queue_begin + 1);
 
-	m_motion_ctrl_ptr->play(doing.slot);
+	m_motion_ctrl_ptr->play(doing.slot, doing.flags);
 
 	if (doing.loop_count != 0)
 	{
@@ -34,6 +34,7 @@ public:
 	public:
 		unsigned char slot;       //!< Slot number of a motion.
 		unsigned char loop_count; //!< Loop count. (Using 255 as infinity.)
+		unsigned char flags;      //!< Play flags. (Refer to MotionController::PLAY_MIRROR, MotionController::PLAY_REVERSE.)
 	};
 
 	enum {
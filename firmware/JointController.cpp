@@ -30,6 +30,7 @@
 #include "JointController.h"
 #include "ExternalFs.h"
 #include "Motion.h"
+#include "Checksum.h"
 #if(WS2812_HEAD || WS2812_TORSO)
 	Adafruit_NeoPixel leds = Adafruit_NeoPixel(WS2812_COUNT, PLEN2::Pin::PIXEL_PIN(), NEO_GRB);
 #endif
@@ -88,6 +89,18 @@ namespace
 		};
 
 		const int ERROR_LVALUE = -32768;
+
+		/*!
+			@brief Layout of a joint setting written with INIT_FLAG_VALUE_LEGACY()
+		*/
+		class LegacyJointSetting
+		{
+		public:
+			int MIN;
+			int MAX;
+			int HOME;
+			unsigned char pin;
+		};
 	}
 }
 
@@ -116,14 +129,17 @@ void PLEN2::JointController::Init()
     
 	for (char joint_id = 0; joint_id < SUM; joint_id++)
 	{
-		m_SETTINGS[joint_id].MIN  = Shared::m_SETTINGS_INITIAL[joint_id * 3].MIN;
-		m_SETTINGS[joint_id].MAX  = Shared::m_SETTINGS_INITIAL[joint_id * 3 + 1].MAX;
-		m_SETTINGS[joint_id].HOME = Shared::m_SETTINGS_INITIAL[joint_id * 3 + 2].HOME;
+		m_SETTINGS[joint_id].MIN  = Shared::m_SETTINGS_INITIAL[joint_id].MIN;
+		m_SETTINGS[joint_id].MAX  = Shared::m_SETTINGS_INITIAL[joint_id].MAX;
+		m_SETTINGS[joint_id].HOME = Shared::m_SETTINGS_INITIAL[joint_id].HOME;
 		setAngle(joint_id, m_SETTINGS[joint_id].HOME);
 	}
 }
 
 PLEN2::JointController::JointController()
+	: m_calibrating(false)
+	, m_bank(BANK_SUM - 1)
+	, m_sequence(0)
 {
 
 }
@@ -135,17 +151,27 @@ void PLEN2::JointController::loadSettings()
 		volatile Utility::Profiler p(F("JointController::loadSettings()"));
 	#endif
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(m_SETTINGS);
-	
-	if (ExternalFs::readByte(INIT_FLAG_ADDRESS(), fp_config) != INIT_FLAG_VALUE())
+	unsigned char flag = ExternalFs::readByte(INIT_FLAG_ADDRESS(), fp_config);
+
+	if (   (flag == INIT_FLAG_VALUE_LEGACY())
+		|| (flag == INIT_FLAG_VALUE_SINGLE_BANK()) )
 	{
-		ExternalFs::writeByte(INIT_FLAG_ADDRESS(), INIT_FLAG_VALUE(), fp_config);
-        ExternalFs::write(SETTINGS_HEAD_ADDRESS(), sizeof(m_SETTINGS), filler, fp_config);
+		m_migrateSettings(flag);
+		System::debugSerial().println(F("migrate config"));
+	}
+	else if (   (flag != INIT_FLAG_VALUE())
+			 || !(m_readSettings()) )
+	{
+		if (m_writeSettings())
+		{
+			ExternalFs::begin(fp_config);
+			ExternalFs::writeByte(INIT_FLAG_ADDRESS(), INIT_FLAG_VALUE(), fp_config);
+			ExternalFs::commit();
+		}
 		System::debugSerial().println(F("reset config\n"));
 	}
 	else
 	{
-		ExternalFs::read(SETTINGS_HEAD_ADDRESS(), sizeof(m_SETTINGS), filler, fp_config);
 		System::debugSerial().println(F("read config"));
 	}
 
@@ -159,25 +185,214 @@ void PLEN2::JointController::loadSettings()
 }
 
 
+void PLEN2::JointController::m_migrateSettings(unsigned char flag)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::m_migrateSettings()"));
+	#endif
+
+	if (flag == INIT_FLAG_VALUE_LEGACY())
+	{
+		Shared::LegacyJointSetting legacy[SUM];
+
+		ExternalFs::read(SETTINGS_HEAD_ADDRESS(), sizeof(legacy), reinterpret_cast<unsigned char*>(legacy), fp_config);
+
+		for (char joint_id = 0; joint_id < SUM; joint_id++)
+		{
+			m_SETTINGS[joint_id].MIN              = legacy[joint_id].MIN;
+			m_SETTINGS[joint_id].MAX              = legacy[joint_id].MAX;
+			m_SETTINGS[joint_id].HOME             = legacy[joint_id].HOME;
+			m_SETTINGS[joint_id].pin              = legacy[joint_id].pin;
+			m_SETTINGS[joint_id].VELOCITY_MAX     = VELOCITY_MAX_DEFAULT;
+			m_SETTINGS[joint_id].ACCELERATION_MAX = ACCELERATION_MAX_DEFAULT;
+		}
+	}
+	else
+	{
+		ExternalFs::read(SETTINGS_HEAD_ADDRESS(), sizeof(m_SETTINGS), reinterpret_cast<unsigned char*>(m_SETTINGS), fp_config);
+	}
+
+	// The banks are placed after the old settings, and the flag is written after the bank is committed,
+	// so the migration is redone from the old settings if the power is cut on the way, or the bank fails to be written.
+	if (!m_writeSettings())
+	{
+		return;
+	}
+
+	ExternalFs::begin(fp_config);
+	ExternalFs::writeByte(INIT_FLAG_ADDRESS(), INIT_FLAG_VALUE(), fp_config);
+	ExternalFs::commit();
+}
+
+
+bool PLEN2::JointController::m_readSettings()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::m_readSettings()"));
+	#endif
+
+	JointSetting settings[SUM];
+	bool         found = false;
+
+	for (unsigned char bank = 0; bank < BANK_SUM; bank++)
+	{
+		const unsigned int address = BANK_HEAD_ADDRESS() + bank * BANK_SIZE();
+		unsigned long sequence;
+		unsigned long crc;
+
+		ExternalFs::read(address, sizeof(sequence), reinterpret_cast<unsigned char*>(&sequence), fp_config);
+		ExternalFs::read(address + sizeof(sequence), sizeof(settings), reinterpret_cast<unsigned char*>(settings), fp_config);
+		ExternalFs::read(address + sizeof(sequence) + sizeof(settings), sizeof(crc), reinterpret_cast<unsigned char*>(&crc), fp_config);
+
+		unsigned long actual = Utility::crc32(reinterpret_cast<const unsigned char*>(&sequence), sizeof(sequence));
+		actual = Utility::crc32(reinterpret_cast<const unsigned char*>(settings), sizeof(settings), actual);
+
+		if (actual != crc)
+		{
+			#if DEBUG
+				System::debugSerial().print(F(">>> broken bank : "));
+				System::debugSerial().println(static_cast<int>(bank));
+			#endif
+
+			continue;
+		}
+
+		if (   !(found)
+			|| (sequence > m_sequence) )
+		{
+			memcpy(m_SETTINGS, settings, sizeof(m_SETTINGS));
+
+			m_bank     = bank;
+			m_sequence = sequence;
+			found      = true;
+		}
+	}
+
+	return found;
+}
+
+
+bool PLEN2::JointController::m_writeSettings()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::m_writeSettings()"));
+	#endif
+
+	const unsigned char bank     = (m_bank + 1) % BANK_SUM;
+	const unsigned long sequence = m_sequence + 1;
+	const unsigned int  address  = BANK_HEAD_ADDRESS() + bank * BANK_SIZE();
+
+	static_assert(sizeof(sequence) + sizeof(m_SETTINGS) + sizeof(unsigned long) <= BANK_SIZE(),
+		"The settings overflow the bank.");
+
+	unsigned long crc = Utility::crc32(reinterpret_cast<const unsigned char*>(&sequence), sizeof(sequence));
+	crc = Utility::crc32(reinterpret_cast<const unsigned char*>(m_SETTINGS), sizeof(m_SETTINGS), crc);
+
+	ExternalFs::begin(fp_config);
+	ExternalFs::write(address, sizeof(sequence), reinterpret_cast<const unsigned char*>(&sequence), fp_config);
+	ExternalFs::write(address + sizeof(sequence), sizeof(m_SETTINGS), reinterpret_cast<const unsigned char*>(m_SETTINGS), fp_config);
+	ExternalFs::write(address + sizeof(sequence) + sizeof(m_SETTINGS), sizeof(crc), reinterpret_cast<const unsigned char*>(&crc), fp_config);
+
+	// The bank in use is kept if the bank fails to be written, so the next writing retries the same bank.
+	if (!ExternalFs::commit())
+	{
+		return false;
+	}
+
+	m_bank     = bank;
+	m_sequence = sequence;
+
+	#if DEBUG
+		System::debugSerial().print(F(">>> committed bank : "));
+		System::debugSerial().print(static_cast<int>(m_bank));
+		System::debugSerial().print(F(", sequence : "));
+		System::debugSerial().println(m_sequence);
+	#endif
+
+	return true;
+}
+
+
 void PLEN2::JointController::resetSettings()
 {
 	#if DEBUG
 		volatile Utility::Profiler p(F("JointController::resetSettings()"));
 	#endif
-	
-    ExternalFs::writeByte(INIT_FLAG_ADDRESS(), INIT_FLAG_VALUE(), fp_config);
+
+	m_calibrating = false;
 
 	for (char joint_id = 0; joint_id < SUM; joint_id++)
 	{
-		m_SETTINGS[joint_id].MIN  = Shared::m_SETTINGS_INITIAL[joint_id * 3].MIN;
-		m_SETTINGS[joint_id].MAX  = Shared::m_SETTINGS_INITIAL[joint_id * 3 + 1].MAX;
-		m_SETTINGS[joint_id].HOME = Shared::m_SETTINGS_INITIAL[joint_id * 3 + 2].HOME;
+		m_SETTINGS[joint_id].MIN  = Shared::m_SETTINGS_INITIAL[joint_id].MIN;
+		m_SETTINGS[joint_id].MAX  = Shared::m_SETTINGS_INITIAL[joint_id].MAX;
+		m_SETTINGS[joint_id].HOME = Shared::m_SETTINGS_INITIAL[joint_id].HOME;
+
+		m_SETTINGS[joint_id].VELOCITY_MAX     = VELOCITY_MAX_DEFAULT;
+		m_SETTINGS[joint_id].ACCELERATION_MAX = ACCELERATION_MAX_DEFAULT;
 
 		setAngle(joint_id, m_SETTINGS[joint_id].HOME);
 	}
-	
-    ExternalFs::write(SETTINGS_HEAD_ADDRESS(), sizeof(m_SETTINGS), 
-                    reinterpret_cast<const unsigned char*>(m_SETTINGS), fp_config);
+
+	m_writeSettings();
+}
+
+
+void PLEN2::JointController::beginCalibration()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::beginCalibration()"));
+	#endif
+
+	m_calibrating = true;
+}
+
+
+bool PLEN2::JointController::commitCalibration()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::commitCalibration()"));
+	#endif
+
+	if (!m_calibrating)
+	{
+		return false;
+	}
+
+	if (!m_writeSettings())
+	{
+		return false;
+	}
+
+	m_calibrating = false;
+
+	return true;
+}
+
+
+void PLEN2::JointController::abortCalibration()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("JointController::abortCalibration()"));
+	#endif
+
+	if (!m_calibrating)
+	{
+		return;
+	}
+
+	m_readSettings();
+	m_calibrating = false;
+
+	for (char joint_id = 0; joint_id < SUM; joint_id++)
+	{
+		setAngle(joint_id, m_SETTINGS[joint_id].HOME);
+	}
+}
+
+
+bool PLEN2::JointController::calibrating() const
+{
+	return m_calibrating;
 }
 
 
@@ -241,6 +456,46 @@ const int& PLEN2::JointController::getHomeAngle(unsigned char joint_id)
 }
 
 
+const int& PLEN2::JointController::getMaxVelocity(unsigned char joint_id)
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("JointController::getMaxVelocity()"));
+	#endif
+
+	if (joint_id >= SUM)
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+			System::debugSerial().println(static_cast<int>(joint_id));
+		#endif
+
+		return Shared::ERROR_LVALUE;
+	}
+
+	return m_SETTINGS[joint_id].VELOCITY_MAX;
+}
+
+
+const int& PLEN2::JointController::getMaxAcceleration(unsigned char joint_id)
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("JointController::getMaxAcceleration()"));
+	#endif
+
+	if (joint_id >= SUM)
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+			System::debugSerial().println(static_cast<int>(joint_id));
+		#endif
+
+		return Shared::ERROR_LVALUE;
+	}
+
+	return m_SETTINGS[joint_id].ACCELERATION_MAX;
+}
+
+
 bool PLEN2::JointController::setMinAngle(unsigned char joint_id, int angle)
 {
 	#if DEBUG
@@ -271,15 +526,10 @@ bool PLEN2::JointController::setMinAngle(unsigned char joint_id, int angle)
 
 	m_SETTINGS[joint_id].MIN = angle;
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(&(m_SETTINGS[joint_id].MIN));
-	int address_offset    = reinterpret_cast<int>(filler) - reinterpret_cast<int>(m_SETTINGS);
-
-	#if DEBUG
-		System::debugSerial().print(F(">>> address_offset : "));
-		System::debugSerial().println(address_offset);
-	#endif
-
-	ExternalFs::write(SETTINGS_HEAD_ADDRESS() + address_offset, sizeof(m_SETTINGS[joint_id].MIN), filler, fp_config);
+	if (!m_calibrating)
+	{
+		m_writeSettings();
+	}
 
 	return true;
 }
@@ -315,15 +565,10 @@ bool PLEN2::JointController::setMaxAngle(unsigned char joint_id, int angle)
 
 	m_SETTINGS[joint_id].MAX = angle;
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(&(m_SETTINGS[joint_id].MAX));
-	int address_offset    = reinterpret_cast<int>(filler) - reinterpret_cast<int>(m_SETTINGS);
-
-	#if DEBUG
-		System::debugSerial().print(F(">>> address_offset : "));
-		System::debugSerial().println(address_offset);
-	#endif
-
-	ExternalFs::write(SETTINGS_HEAD_ADDRESS() + address_offset, sizeof(m_SETTINGS[joint_id].MAX), filler, fp_config);
+	if (!m_calibrating)
+	{
+		m_writeSettings();
+	}
 
 	return true;
 }
@@ -359,15 +604,51 @@ bool PLEN2::JointController::setHomeAngle(unsigned char joint_id, int angle)
 
 	m_SETTINGS[joint_id].HOME = angle;
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(&(m_SETTINGS[joint_id].HOME));
-	int address_offset    = reinterpret_cast<int>(filler) - reinterpret_cast<int>(m_SETTINGS);
+	if (!m_calibrating)
+	{
+		m_writeSettings();
+	}
+
+	return true;
+}
 
+bool PLEN2::JointController::setMotionLimits(unsigned char joint_id, int velocity, int acceleration)
+{
 	#if DEBUG
-		System::debugSerial().print(F(">>> address_offset : "));
-		System::debugSerial().println(address_offset);
+		volatile Utility::Profiler p(F("JointController::setMotionLimits()"));
 	#endif
 
-	ExternalFs::write(SETTINGS_HEAD_ADDRESS() + address_offset, sizeof(m_SETTINGS[joint_id].HOME), filler, fp_config);
+	if (joint_id >= SUM)
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+			System::debugSerial().println(static_cast<int>(joint_id));
+		#endif
+
+		return false;
+	}
+
+	if (   (velocity     <= 0) || (velocity     > 0xFFFF)
+		|| (acceleration <= 0) || (acceleration > 0xFFFF) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment! : velocity = "));
+			System::debugSerial().print(velocity);
+			System::debugSerial().print(F(", acceleration = "));
+			System::debugSerial().println(acceleration);
+		#endif
+
+		return false;
+	}
+
+
+	m_SETTINGS[joint_id].VELOCITY_MAX     = velocity;
+	m_SETTINGS[joint_id].ACCELERATION_MAX = acceleration;
+
+	if (!m_calibrating)
+	{
+		m_writeSettings();
+	}
 
 	return true;
 }
@@ -389,28 +670,7 @@ bool PLEN2::JointController::setAngle(unsigned char joint_id, int angle)
 	}
 
 
-	angle = constrain(angle, m_SETTINGS[joint_id].MIN, m_SETTINGS[joint_id].MAX);
-	if(joint_id  == 0 || joint_id == 12)
-	{
-		#if CLOCK_WISE
-			m_pwms[joint_id] = 90 + angle / 10;
-		#else
-			m_pwms[joint_id] = 90 - angle / 10;
-		#endif
-	}
-	else
-	{
-		m_pwms[joint_id] = map(
-			angle,
-			PLEN2::JointController::ANGLE_MIN, PLEN2::JointController::ANGLE_MAX,
-
-			#if CLOCK_WISE
-				PLEN2::JointController::PWM_MIN(), PLEN2::JointController::PWM_MAX()
-			#else
-				PLEN2::JointController::PWM_MAX(), PLEN2::JointController::PWM_MIN()
-			#endif
-		);
-	}
+	m_pwms[joint_id] = m_toPwm(joint_id, angle);
 #if DEBUG_LESS
 	System::debugSerial().print(F(": joint_id = "));
 	System::debugSerial().print(static_cast<int>(joint_id));
@@ -439,36 +699,79 @@ bool PLEN2::JointController::setAngleDiff(unsigned char joint_id, int angle_diff
 	}
 
 
-	int angle = constrain(
-		angle_diff + m_SETTINGS[joint_id].HOME,
-		m_SETTINGS[joint_id].MIN, m_SETTINGS[joint_id].MAX
-	);
+	m_pwms[joint_id] = m_toPwm(joint_id, angle_diff + m_SETTINGS[joint_id].HOME);
 
-	if(joint_id  == 0 || joint_id == 12)
+	return true;
+}
+
+
+bool PLEN2::JointController::setAnglesDiff(const int angle_diffs[SUM], unsigned long mask)
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("JointController::setAnglesDiff()"));
+	#endif
+
+	if ((mask >> SUM) != 0)
 	{
-		#if CLOCK_WISE
-			m_pwms[joint_id] = 90 + angle / 10;
-		#else
-			m_pwms[joint_id] = 90 - angle / 10;
+		#if DEBUG_HARD
+			System::debugSerial().print(F(">>> bad argment! : mask = "));
+			System::debugSerial().println(mask, HEX);
 		#endif
+
+		return false;
 	}
-	else
+
+	int pwms[SUM];
+
+	for (unsigned char joint_id = 0; joint_id < SUM; joint_id++)
 	{
-		m_pwms[joint_id] = map(
-			angle,
-			PLEN2::JointController::ANGLE_MIN, PLEN2::JointController::ANGLE_MAX,
+		if (mask & (1UL << joint_id))
+		{
+			pwms[joint_id] = m_toPwm(joint_id, angle_diffs[joint_id] + m_SETTINGS[joint_id].HOME);
+		}
+	}
 
-			#if CLOCK_WISE
-				PLEN2::JointController::PWM_MIN(), PLEN2::JointController::PWM_MAX()
-			#else
-				PLEN2::JointController::PWM_MAX(), PLEN2::JointController::PWM_MIN()
-			#endif
-		);
+	noInterrupts();
+
+	for (unsigned char joint_id = 0; joint_id < SUM; joint_id++)
+	{
+		if (mask & (1UL << joint_id))
+		{
+			m_pwms[joint_id] = pwms[joint_id];
+		}
 	}
 
+	interrupts();
+
 	return true;
 }
 
+
+int PLEN2::JointController::m_toPwm(unsigned char joint_id, int angle)
+{
+	angle = constrain(angle, m_SETTINGS[joint_id].MIN, m_SETTINGS[joint_id].MAX);
+
+	if(joint_id  == 0 || joint_id == 12)
+	{
+		#if CLOCK_WISE
+			return 90 + angle / 10;
+		#else
+			return 90 - angle / 10;
+		#endif
+	}
+
+	return map(
+		angle,
+		PLEN2::JointController::ANGLE_MIN, PLEN2::JointController::ANGLE_MAX,
+
+		#if CLOCK_WISE
+			PLEN2::JointController::PWM_MIN(), PLEN2::JointController::PWM_MAX()
+		#else
+			PLEN2::JointController::PWM_MAX(), PLEN2::JointController::PWM_MIN()
+		#endif
+	);
+}
+
 void PLEN2::JointController::dump()
 {
 	#if DEBUG
@@ -490,7 +793,15 @@ void PLEN2::JointController::dump()
 		System::outputSerial().println(F(","));
 
 		System::outputSerial().print(F("\t\t\"home\": "));
-		System::outputSerial().println(m_SETTINGS[joint_id].HOME);
+		System::outputSerial().print(m_SETTINGS[joint_id].HOME);
+		System::outputSerial().println(F(","));
+
+		System::outputSerial().print(F("\t\t\"velocity_max\": "));
+		System::outputSerial().print(m_SETTINGS[joint_id].VELOCITY_MAX);
+		System::outputSerial().println(F(","));
+
+		System::outputSerial().print(F("\t\t\"acceleration_max\": "));
+		System::outputSerial().println(m_SETTINGS[joint_id].ACCELERATION_MAX);
 
 		System::outputSerial().print(F("\t}"));
 
@@ -598,4 +909,4 @@ void PLEN2::JointController::updateLeds()
 	}
 #endif
 }
-
+
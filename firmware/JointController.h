@@ -28,7 +28,37 @@ public:
 
 		ANGLE_MIN     = -800, //!< Min angle of the servos. // TODO : fix it for MG90S
 		ANGLE_MAX     =  800, //!< Max angle of the servos. // TODO : fix it for MG90S
-		ANGLE_NEUTRAL =    0  //!< Neutral angle of the servos.
+		ANGLE_NEUTRAL =    0, //!< Neutral angle of the servos.
+
+		VELOCITY_MAX_DEFAULT     =  4000, //!< Default max velocity of the servos. (Steps of degree 1/10 per second.)
+		ACCELERATION_MAX_DEFAULT = 40000  //!< Default max acceleration of the servos. (Steps of degree 1/10 per second^2.)
+	};
+
+	/*!
+		@brief Joint ids
+
+		@sa
+		JointController.cpp::Shared::m_SETTINGS_INITIAL
+	*/
+	enum {
+		LEFT_SHOULDER_PITCH,  //!< [01] Left : Shoulder Pitch
+		LEFT_THIGH_YAW,       //!< [02] Left : Thigh Yaw
+		LEFT_SHOULDER_ROLL,   //!< [03] Left : Shoulder Roll
+		LEFT_ELBOW_ROLL,      //!< [04] Left : Elbow Roll
+		LEFT_THIGH_ROLL,      //!< [05] Left : Thigh Roll
+		LEFT_THIGH_PITCH,     //!< [06] Left : Thigh Pitch
+		LEFT_KNEE_PITCH,      //!< [07] Left : Knee Pitch
+		LEFT_FOOT_PITCH,      //!< [08] Left : Foot Pitch
+		LEFT_FOOT_ROLL,       //!< [09] Left : Foot Roll
+		RIGHT_SHOULDER_PITCH, //!< [10] Right : Shoulder Pitch
+		RIGHT_THIGH_YAW,      //!< [11] Right : Thigh Yaw
+		RIGHT_SHOULDER_ROLL,  //!< [12] Right : Shoulder Roll
+		RIGHT_ELBOW_ROLL,     //!< [13] Right : Elbow Roll
+		RIGHT_THIGH_ROLL,     //!< [14] Right : Thigh Roll
+		RIGHT_THIGH_PITCH,    //!< [15] Right : Thigh Pitch
+		RIGHT_KNEE_PITCH,     //!< [16] Right : Knee Pitch
+		RIGHT_FOOT_PITCH,     //!< [17] Right : Foot Pitch
+		RIGHT_FOOT_ROLL       //!< [18] Right : Foot Roll
 	};
 
 private:
@@ -36,11 +66,32 @@ private:
 	inline static const int INIT_FLAG_ADDRESS()     { return 0; }
 
 	//! @brief Initialized flag's value
-	inline static const unsigned char INIT_FLAG_VALUE()       { return 2; }
+	inline static const unsigned char INIT_FLAG_VALUE()       { return 4; }
+
+	//! @brief Initialized flag's value of the settings written in place without banks
+	inline static const unsigned char INIT_FLAG_VALUE_SINGLE_BANK() { return 3; }
+
+	//! @brief Initialized flag's value of the settings without velocity and acceleration limits
+	inline static const unsigned char INIT_FLAG_VALUE_LEGACY() { return 2; }
 
-	//! @brief Head-address of joint settings on internal EEPROM
+	//! @brief Head-address of joint settings written without banks
 	inline static const int SETTINGS_HEAD_ADDRESS() { return 1; }
 
+	/*!
+		@brief Head-address of the setting banks
+
+		Each bank has layout below, and the valid bank that has the latest sequence is used.
+		@code
+		<sequence : 4 bytes>, <JointSetting> * SUM, <CRC-32 of the sequence and the settings : 4 bytes>
+		@endcode
+	*/
+	inline static const int BANK_HEAD_ADDRESS()     { return 0x200; }
+
+	//! @brief Size of a setting bank
+	inline static constexpr int BANK_SIZE()         { return 0x200; }
+
+	enum { BANK_SUM = 2 }; //!< Summation of the setting banks. (A/B)
+
 	/*!
 		@brief Management class of joint setting
 	*/
@@ -51,6 +102,9 @@ private:
 		int MAX;  //!< Setting about max angle.
 		int HOME; //!< Setting about home angle.
 		unsigned char pin;
+		int VELOCITY_MAX;     //!< Setting about max velocity.
+		int ACCELERATION_MAX; //!< Setting about max acceleration.
+
 		/*!
 			@brief Constructor
 		*/
@@ -59,12 +113,50 @@ private:
 			, MAX(ANGLE_MAX)
 			, HOME(ANGLE_NEUTRAL)
 			, pin(0)
+			, VELOCITY_MAX(VELOCITY_MAX_DEFAULT)
+			, ACCELERATION_MAX(ACCELERATION_MAX_DEFAULT)
 		{
 			// noop.
 		}
 	};
 
-	JointSetting m_SETTINGS[SUM];
+	/*!
+		@brief Migrate the settings written without banks
+
+		@param [in] flag Please set initialized flag's value of the settings.
+	*/
+	void m_migrateSettings(unsigned char flag);
+
+	/*!
+		@brief Read the latest valid bank
+
+		@return Result
+		@retval false Both of the banks are broken.
+	*/
+	bool m_readSettings();
+
+	/*!
+		@brief Write the whole settings to the bank not in use, and switch to it
+
+		@return Result
+		@retval false Writing the bank failed, and the bank in use is not switched.
+	*/
+	bool m_writeSettings();
+
+	/*!
+		@brief Convert angle of the joint given to PWM width
+
+		@param [in] joint_id Please set joint id.
+		@param [in] angle    Please set angle that has steps of degree 1/10.
+
+		@return PWM width after trimming the angle by user defined min-max value.
+	*/
+	int m_toPwm(unsigned char joint_id, int angle);
+
+	JointSetting  m_SETTINGS[SUM];
+	bool          m_calibrating;
+	unsigned char m_bank;
+	unsigned long m_sequence;
 public:
     inline static const int PWM_FREQ()    { return 60;  }
 
@@ -127,6 +219,40 @@ public:
 	*/
 	void resetSettings();
 
+	/*!
+		@brief Begin calibration
+
+		Until the calibration is committed, min, max and home angles and motion limits set
+		are applied only on RAM, and the settings on the file system are left as they are.
+	*/
+	void beginCalibration();
+
+	/*!
+		@brief Commit calibration
+
+		Writes the whole settings edited at once.
+		The settings are written to the bank not in use,
+		so the previous settings remain valid if the power is cut on the way.
+
+		@return Result
+		@retval false The calibration has not begun, or writing the settings failed. (The calibration continues then.)
+	*/
+	bool commitCalibration();
+
+	/*!
+		@brief Abort calibration
+
+		Restores the settings edited from the bank in use, and moves the joints to their home angles restored.
+	*/
+	void abortCalibration();
+
+	/*!
+		@brief Decide the calibration is in progress
+
+		@return Result
+	*/
+	bool calibrating() const;
+
 	/*!
 		@brief Get min angle of the joint given
 
@@ -157,6 +283,26 @@ public:
 	*/
 	const int& getHomeAngle(unsigned char joint_id);
 
+	/*!
+		@brief Get max velocity of the joint given
+
+		@param [in] joint_id Please set joint id you want to get max velocity.
+
+		@return Reference of max velocity a joint expressed by **joint_id** has.
+		@retval -32768 Argument error. (**joint_id** is invalid.)
+	*/
+	const int& getMaxVelocity(unsigned char joint_id);
+
+	/*!
+		@brief Get max acceleration of the joint given
+
+		@param [in] joint_id Please set joint id you want to get max acceleration.
+
+		@return Reference of max acceleration a joint expressed by **joint_id** has.
+		@retval -32768 Argument error. (**joint_id** is invalid.)
+	*/
+	const int& getMaxAcceleration(unsigned char joint_id);
+
 	/*!
 		@brief Set min angle of the joint given
 
@@ -187,6 +333,17 @@ public:
 	*/
 	bool setHomeAngle(unsigned char joint_id, int angle);
 
+	/*!
+		@brief Set max velocity and max acceleration of the joint given
+
+		@param [in] joint_id     Please set joint id you want to define the limits.
+		@param [in] velocity     Please set velocity that has steps of degree 1/10 per second.
+		@param [in] acceleration Please set acceleration that has steps of degree 1/10 per second^2.
+
+		@return Result
+	*/
+	bool setMotionLimits(unsigned char joint_id, int velocity, int acceleration);
+
 	/*!
 		@brief Set angle of the joint given
 
@@ -217,6 +374,23 @@ public:
 	*/
 	bool setAngleDiff(unsigned char joint_id, int angle_diff);
 
+	/*!
+		@brief Set angles to "angle-diff + home-angle" of the joints given at once
+
+		All the PWM widths are computed before the PWM buffer is written,
+		so updateAngle() outputs either the previous pose or the new one, never a mix of them.
+
+		@param [in] angle_diffs Please set angle-diffs of all the joints, that have steps of degree 1/10.
+		@param [in] mask        Please set bits of the joints to apply. (Bit N is joint id N.)
+
+		@return Result
+		@retval false Bits over joint id SUM - 1 are set.
+
+		@attention
+		<b>angle_diffs</b> might not be setting actually, like setAngleDiff().
+	*/
+	bool setAnglesDiff(const int angle_diffs[SUM], unsigned long mask);
+
 	/*!
 		@brief Dump the joint settings
 
@@ -226,7 +400,9 @@ public:
 			{
 				"max": <integer>,
 				"min": <integer>,
-				"home": <integer>
+				"home": <integer>,
+				"velocity_max": <integer>,
+				"acceleration_max": <integer>
 			},
 			...
 		]
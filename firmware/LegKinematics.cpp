@@ -0,0 +1,149 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "System.h"
+#include "JointController.h"
+#include "LegKinematics.h"
+#include "Trigonometry.h"
+#include "Profiler.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	enum {
+		LENGTH_SUM  = LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH,
+		LENGTH_DIFF = (LegKinematics::THIGH_LENGTH > LegKinematics::SHIN_LENGTH)?
+			(LegKinematics::THIGH_LENGTH - LegKinematics::SHIN_LENGTH) : (LegKinematics::SHIN_LENGTH - LegKinematics::THIGH_LENGTH),
+
+		COSINE_LIMIT = 0x7FFF
+	};
+
+	inline long scale_q15(long value, int value_q15)
+	{
+		return (value * value_q15) >> 15;
+	}
+}
+
+
+bool PLEN2::LegKinematics::solve(const FootPose& pose, LegAngles& angles)
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("LegKinematics::solve()"));
+	#endif
+
+	if (pose.z <= 0)
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment : pose.z = "));
+			System::debugSerial().println(pose.z);
+		#endif
+
+		return false;
+	}
+
+	// Rotate the foot position into the frame of thigh yaw.
+	const unsigned int yaw = Utility::deg10_to_binary(pose.yaw);
+	const int yaw_sin = Utility::sin_q15(yaw);
+	const int yaw_cos = Utility::cos_q15(yaw);
+
+	const long x = scale_q15(pose.x, yaw_cos) + scale_q15(pose.y, yaw_sin);
+	const long y = scale_q15(pose.y, yaw_cos) - scale_q15(pose.x, yaw_sin);
+	const long z = pose.z;
+
+	// Thigh roll tilts the sagittal plane to the foot.
+	const int  roll = Utility::atan2_binary(y, z);
+	const long z_sagittal = Utility::isqrt(y * y + z * z);
+
+	const long distance_2 = x * x + z_sagittal * z_sagittal;
+
+	if (   (distance_2 > static_cast<long>(LENGTH_SUM)  * LENGTH_SUM)
+		|| (distance_2 < static_cast<long>(LENGTH_DIFF) * LENGTH_DIFF) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> unreachable : distance_2 = "));
+			System::debugSerial().println(distance_2);
+		#endif
+
+		return false;
+	}
+
+	// Law of cosines, knee = acos(numerator / denominator).
+	long numerator   = distance_2
+	                 - static_cast<long>(THIGH_LENGTH) * THIGH_LENGTH
+	                 - static_cast<long>(SHIN_LENGTH)  * SHIN_LENGTH;
+	long denominator = 2L * THIGH_LENGTH * SHIN_LENGTH;
+
+	while (denominator > COSINE_LIMIT)
+	{
+		numerator   /= 2;
+		denominator /= 2;
+	}
+
+	numerator = constrain(numerator, -denominator, denominator);
+
+	const long knee_sin = Utility::isqrt(denominator * denominator - numerator * numerator);
+	const int  knee     = Utility::atan2_binary(knee_sin, numerator);
+
+	// Angle between the thigh and the line from the hip to the foot.
+	const int alpha = Utility::atan2_binary(
+		scale_q15(SHIN_LENGTH, Utility::sin_q15(knee)),
+		THIGH_LENGTH + scale_q15(SHIN_LENGTH, Utility::cos_q15(knee))
+	);
+
+	const int hip = Utility::atan2_binary(x, z_sagittal) + alpha;
+
+	angles.thigh_yaw   = pose.yaw;
+	angles.thigh_roll  = Utility::binary_to_deg10(roll);
+	angles.thigh_pitch = Utility::binary_to_deg10(hip);
+	angles.knee_pitch  = -Utility::binary_to_deg10(knee);
+	angles.foot_pitch  = -(angles.thigh_pitch + angles.knee_pitch);
+	angles.foot_roll   = -angles.thigh_roll;
+
+	return true;
+}
+
+
+bool PLEN2::LegKinematics::apply(JointController& joint_ctrl, unsigned char leg, const FootPose& pose)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("LegKinematics::apply()"));
+	#endif
+
+	if (leg > RIGHT)
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : leg = "));
+			System::debugSerial().println(static_cast<int>(leg));
+		#endif
+
+		return false;
+	}
+
+	LegAngles angles;
+
+	if (!solve(pose, angles))
+	{
+		return false;
+	}
+
+
+	const unsigned char begin = (leg == LEFT)? 0 : JointController::RIGHT_SHOULDER_PITCH;
+	const int sign = (leg == LEFT)? 1 : -1;
+
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_THIGH_YAW,   angles.thigh_yaw   * sign);
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_THIGH_ROLL,  angles.thigh_roll  * sign);
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_THIGH_PITCH, angles.thigh_pitch * sign);
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_KNEE_PITCH,  angles.knee_pitch  * sign);
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_FOOT_PITCH,  angles.foot_pitch  * sign);
+	joint_ctrl.setAngleDiff(begin + JointController::LEFT_FOOT_ROLL,   angles.foot_roll   * sign);
+
+	return true;
+}
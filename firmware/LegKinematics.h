@@ -0,0 +1,94 @@
+/*!
+	@file      LegKinematics.h
+	@brief     Fixed-point inverse kinematics of the legs.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_LEG_KINEMATICS_H
+#define PLEN2_LEG_KINEMATICS_H
+
+
+namespace PLEN2
+{
+	class JointController;
+	class LegKinematics;
+}
+
+/*!
+	@brief Fixed-point inverse kinematics of the legs
+
+	The class solves the leg chain, "thigh yaw - thigh roll - thigh pitch - knee pitch - foot pitch - foot roll",
+	from a foot pose without floating-point operations.
+	<br><br>
+	Coordinates of a foot pose are relative to the hip joint.
+	(X: forward, Y: left, Z: downward, and they have steps of 1/10 [mm].)
+	The sole is kept parallel to the ground.
+
+	@note
+	Output angles are angle-diffs from the home positions, and the home position is regarded as a straight leg.
+	Angles of the right leg are mirrored from the left leg by inverting the sign.
+*/
+class PLEN2::LegKinematics
+{
+public:
+	enum {
+		THIGH_LENGTH = 400, //!< Length from thigh pitch to knee pitch. (1/10 [mm])
+		SHIN_LENGTH  = 400, //!< Length from knee pitch to foot pitch. (1/10 [mm])
+
+		LEFT  = 0, //!< Selector of the left leg.
+		RIGHT = 1  //!< Selector of the right leg.
+	};
+
+	/*!
+		@brief Foot pose
+	*/
+	class FootPose
+	{
+	public:
+		int x;   //!< Forward position. (1/10 [mm])
+		int y;   //!< Left position. (1/10 [mm])
+		int z;   //!< Downward position. (1/10 [mm])
+		int yaw; //!< Rotation of the foot. (Steps of degree 1/10.)
+	};
+
+	/*!
+		@brief Joint angles of a leg
+	*/
+	class LegAngles
+	{
+	public:
+		int thigh_yaw;   //!< Angle-diff of thigh yaw.
+		int thigh_roll;  //!< Angle-diff of thigh roll.
+		int thigh_pitch; //!< Angle-diff of thigh pitch.
+		int knee_pitch;  //!< Angle-diff of knee pitch.
+		int foot_pitch;  //!< Angle-diff of foot pitch.
+		int foot_roll;   //!< Angle-diff of foot roll.
+	};
+
+	/*!
+		@brief Solve joint angles of the left leg from a foot pose
+
+		@param [in]  pose   Foot pose.
+		@param [out] angles Joint angles.
+
+		@return Result
+		@retval false The foot pose is unreachable.
+	*/
+	static bool solve(const FootPose& pose, LegAngles& angles);
+
+	/*!
+		@brief Solve joint angles from a foot pose and apply them
+
+		@param [in, out] joint_ctrl Instance of a joint controller.
+		@param [in]      leg        LEFT or RIGHT.
+		@param [in]      pose       Foot pose.
+
+		@return Result
+	*/
+	static bool apply(JointController& joint_ctrl, unsigned char leg, const FootPose& pose);
+};
+
+#endif // PLEN2_LEG_KINEMATICS_H
@@ -10,6 +10,8 @@
 
 #include "ExternalFs.h"
 #include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionStore.h"
 
 #include "System.h"
 #include "Profiler.h"
@@ -20,38 +22,55 @@ namespace
 	using namespace PLEN2::Motion;
 
 
-	template<const int N>
-	struct IF
-	{
-		enum { VALUE = 1 };
-	};
-
-	template<>
-	struct IF<0>
-	{
-		enum { VALUE = 0 };
-	};
-
-	template<typename T>
-	struct SIZE_SUP
-	{
-		enum { VALUE = sizeof(T) % 32 /* ExternalFs:SLOT_SIZE */ };
-	};
+	/*!
+		@brief Layout of the motion file version 1
 
-	template<typename T>
-	struct SLOT_COUNT
+		Each record is split into 30 bytes pieces, and the pieces are stored from the head of 32 bytes chunks.
+		(It is carried over from the I2C buffer of 24FC1025.)
+	*/
+	namespace Legacy
 	{
 		enum {
-			VALUE = sizeof(T) / 32 /* ExternalFs::SLOT_SIZE */
-			      + IF<SIZE_SUP<T>::VALUE>::VALUE
+			CHUNK_SIZE = 32,
+			PIECE_SIZE = 30,
+
+			SLOT_COUNT_HEADER = (sizeof(Header) + CHUNK_SIZE - 1) / CHUNK_SIZE,
+			SLOT_COUNT_FRAME  = (sizeof(Frame)  + CHUNK_SIZE - 1) / CHUNK_SIZE,
+			SLOT_COUNT_MOTION = SLOT_COUNT_HEADER + SLOT_COUNT_FRAME * Header::FRAMELENGTH_MAX
 		};
-	};
 
-	enum {
-		SLOT_COUNT_HEADER = SLOT_COUNT<Header>::VALUE,
-		SLOT_COUNT_FRAME  = SLOT_COUNT<Frame >::VALUE,
-		SLOT_COUNT_MOTION = SLOT_COUNT_HEADER + SLOT_COUNT_FRAME * Header::FRAMELENGTH_MAX
-	};
+		/*!
+			@brief Read a record with the same splitting as version 1
+
+			@note
+			The last piece has "size % CHUNK_SIZE" bytes, so some tail bytes of a record were never stored.
+			They are left as the fill value.
+		*/
+		bool read(File fp, unsigned int slot, unsigned int slot_count, unsigned int size, unsigned char data[])
+		{
+			memset(data, ExternalFs::FILL_VALUE(), size);
+
+			for (unsigned int count = 0; count < slot_count; count++)
+			{
+				unsigned int piece_size = PIECE_SIZE;
+
+				if (   (count == (slot_count - 1))
+					&& (size % CHUNK_SIZE) )
+				{
+					piece_size = size % CHUNK_SIZE;
+				}
+
+				piece_size = min(piece_size, size - count * PIECE_SIZE);
+
+				if (ExternalFs::read((slot + count) * CHUNK_SIZE, piece_size, data + count * PIECE_SIZE, fp) == -1)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
 }
 
 
@@ -107,42 +126,24 @@ bool Header::set()
 	}
 
 
-	const unsigned char* filler = reinterpret_cast<const unsigned char*>(this);
+	ExternalFs::begin(fp_motion);
 
-	for (int count = 0; count < SLOT_COUNT_HEADER; count++)
-	{
-		int ret = ExternalFs::writeSlot(
-			(
-				static_cast<int>(slot) * SLOT_COUNT_MOTION + count
-			),
-			(
-				filler + count * ExternalFs::SLOT_SIZE()
-			),
-			(
-				(count == (SLOT_COUNT_HEADER - 1))?
-					(
-						(SIZE_SUP<Header>::VALUE)?
-							SIZE_SUP<Header>::VALUE : ExternalFs::SLOT_SIZE()
-					)
-					: ExternalFs::SLOT_SIZE()
-			),
-			fp_motion
-		);
+	bool result = MotionStore::append(
+		MotionStore::TYPE_HEADER, slot, 0, reinterpret_cast<const unsigned char*>(this), sizeof(Header)
+	);
+
+	MotionDirectory::invalidate(slot);
+
+	result = ExternalFs::commit() && result;
 
-		if (ret != 0)
+	#if DEBUG_LESS
+		if (!result)
 		{
-			#if DEBUG_LESS
-				System::debugSerial().print(F(">>> failed : ret["));
-				System::debugSerial().print(count);
-				System::debugSerial().print(F("] = "));
-				System::debugSerial().println(ret);
-			#endif
-
-			return false;
+			System::debugSerial().println(F(">>> failed : MotionStore::append()"));
 		}
-	}
+	#endif
 
-	return true;
+	return result;
 }
 
 
@@ -163,39 +164,13 @@ bool Header::get()
 	}
 
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(this);
-
-	for (int count = 0; count < SLOT_COUNT_HEADER; count++)
+	if (!MotionStore::read(MotionStore::TYPE_HEADER, slot, 0, reinterpret_cast<unsigned char*>(this), sizeof(Header)))
 	{
-		int ret = ExternalFs::readSlot(
-			(
-				static_cast<int>(slot) * SLOT_COUNT_MOTION + count
-			),
-			(
-				filler + count * ExternalFs::SLOT_SIZE()
-			),
-			(
-				(count == (SLOT_COUNT_HEADER - 1))?
-					(
-						(SIZE_SUP<Header>::VALUE)?
-							SIZE_SUP<Header>::VALUE : ExternalFs::SLOT_SIZE()
-					)
-					: ExternalFs::SLOT_SIZE()
-			),
-			fp_motion
-		);
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> failed : MotionStore::read()"));
+		#endif
 
-		if (ret == -1)
-		{
-			#if DEBUG_LESS
-				System::debugSerial().print(F(">>> failed : ret["));
-				System::debugSerial().print(count);
-				System::debugSerial().print(F("] = "));
-				System::debugSerial().println(ret);
-			#endif
-
-			return false;
-		}
+		return false;
 	}
 
 	return true;
@@ -229,44 +204,24 @@ bool Frame::set(unsigned char slot)
 	}
 
 
-	const unsigned char* filler = reinterpret_cast<const unsigned char*>(this);
-	for (int count = 0; count < SLOT_COUNT_FRAME; count++)
-	{
-		int ret = ExternalFs::writeSlot(
-			(
-				  static_cast<int>(slot) * SLOT_COUNT_MOTION
-				+ SLOT_COUNT_HEADER
-				+ index * SLOT_COUNT_FRAME
-				+ count
-			),
-			(
-				filler + ExternalFs::SLOT_SIZE() * count
-			),
-			(
-				(count == (SLOT_COUNT_FRAME - 1))?
-					(
-						(SIZE_SUP<Frame>::VALUE)?
-							SIZE_SUP<Frame>::VALUE : ExternalFs::SLOT_SIZE()
-					)
-					: ExternalFs::SLOT_SIZE()
-			),
-			fp_motion
-		);
+	ExternalFs::begin(fp_motion);
+
+	bool result = MotionStore::append(
+		MotionStore::TYPE_FRAME, slot, index, reinterpret_cast<const unsigned char*>(this), sizeof(Frame)
+	);
 
-		if (ret != 0)
+	MotionDirectory::invalidate(slot);
+
+	result = ExternalFs::commit() && result;
+
+	#if DEBUG_LESS
+		if (!result)
 		{
-			#if DEBUG_LESS
-				System::debugSerial().print(F(">>> failed : ret["));
-				System::debugSerial().print(count);
-				System::debugSerial().print(F("] = "));
-				System::debugSerial().println(ret);
-			#endif
-
-			return false;
+			System::debugSerial().println(F(">>> failed : MotionStore::append()"));
 		}
-	}
+	#endif
 
-	return true;
+	return result;
 }
 
 
@@ -297,45 +252,94 @@ bool Frame::get(unsigned char slot)
 	}
 
 
-	unsigned char* filler = reinterpret_cast<unsigned char*>(this);
+	if (!MotionStore::read(MotionStore::TYPE_FRAME, slot, index, reinterpret_cast<unsigned char*>(this), sizeof(Frame)))
+	{
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> failed : MotionStore::read()"));
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+
+void migrate()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("Motion::migrate()"));
+	#endif
+
+	if (!SPIFFS.exists(MOTION_FILE_LEGACY))
+	{
+		return;
+	}
+
+	const unsigned long begin_msec = millis();
+	int migrated = 0;
+
+	File fp_legacy = SPIFFS.open(MOTION_FILE_LEGACY, "r");
+
+	Header header;
+	Frame  frame;
+
+	ExternalFs::begin(fp_motion);
 
-	for (int count = 0; count < SLOT_COUNT_FRAME; count++)
+	for (int slot = SLOT_BEGIN; slot < SLOT_END; slot++)
 	{
-		int ret = ExternalFs::readSlot(
-			(
-				  static_cast<int>(slot) * SLOT_COUNT_MOTION
-				+ SLOT_COUNT_HEADER
-				+ index * SLOT_COUNT_FRAME
-				+ count
-			),
-			(
-				filler + ExternalFs::SLOT_SIZE() * count
-			),
-			(
-				(count == (SLOT_COUNT_FRAME - 1))?
-					(
-						(SIZE_SUP<Frame>::VALUE)?
-							SIZE_SUP<Frame>::VALUE : ExternalFs::SLOT_SIZE()
-					)
-					: ExternalFs::SLOT_SIZE()
-			),
-			fp_motion
+		Legacy::read(
+			fp_legacy, slot * Legacy::SLOT_COUNT_MOTION, Legacy::SLOT_COUNT_HEADER,
+			sizeof(Header), reinterpret_cast<unsigned char*>(&header)
 		);
 
-		if (ret == -1)
+		// Skip the slots which have never been installed.
+		if (   (header.slot != slot)
+			|| (header.frame_length < Header::FRAMELENGTH_MIN)
+			|| (header.frame_length > Header::FRAMELENGTH_MAX) )
+		{
+			continue;
+		}
+
+		header.set();
+
+		for (int index = 0; index < header.frame_length; index++)
 		{
-			#if DEBUG_LESS
-				System::debugSerial().print(F(">>> failed : ret["));
-				System::debugSerial().print(count);
-				System::debugSerial().print(F("] = "));
-				System::debugSerial().println(ret);
-			#endif
-
-			return false;
+			Legacy::read(
+				fp_legacy,
+				slot * Legacy::SLOT_COUNT_MOTION + Legacy::SLOT_COUNT_HEADER + index * Legacy::SLOT_COUNT_FRAME,
+				Legacy::SLOT_COUNT_FRAME,
+				sizeof(Frame), reinterpret_cast<unsigned char*>(&frame)
+			);
+
+			frame.index = index;
+			frame.set(slot);
 		}
+
+		migrated++;
 	}
 
-	return true;
+	const bool committed = ExternalFs::commit();
+
+	fp_legacy.close();
+
+	// The legacy file is kept unless the motions are written, so the migration is redone at the next boot.
+	if (!committed)
+	{
+		System::outputSerial().println(F(">>> error : Writing the migrated motions failed."));
+
+		return;
+	}
+
+	SPIFFS.remove(MOTION_FILE_LEGACY);
+
+	System::outputSerial().print(F("migrate motions from version 1 to version "));
+	System::outputSerial().print(static_cast<int>(LAYOUT_VERSION));
+	System::outputSerial().print(F(" : "));
+	System::outputSerial().print(migrated);
+	System::outputSerial().print(F(" motions in "));
+	System::outputSerial().print(millis() - begin_msec);
+	System::outputSerial().println(F(" [ms]"));
 }
 
 } // end of namespace "Motion".
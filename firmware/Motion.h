@@ -145,4 +145,31 @@ public:
 	unsigned char device_value[8];                   //!< Output values.
 };
 
+
+namespace PLEN2
+{
+	namespace Motion
+	{
+		/*!
+			@brief Record layout of the motion file
+
+			Headers and frames are records of the log managed by MotionStore.
+		*/
+		enum {
+			LAYOUT_VERSION = 2 //!< Version of the layout. (Version 1 is split into 30 bytes pieces.)
+		};
+
+		/*!
+			@brief Migrate the motion file of the older layout
+
+			Converts the installed motions of MOTION_FILE_LEGACY, then removes the file.
+			Nothing is done if the file doesn't exist.
+
+			@attention
+			Please call it after MotionStore::init().
+		*/
+		void migrate();
+	}
+}
+
 #endif // PLEN2_MOTION_H
\ No newline at end of file
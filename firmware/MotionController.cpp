@@ -13,6 +13,10 @@
 #include "JointController.h"
 #include "Motion.h"
 #include "MotionController.h"
+#include "MotionDirectory.h"
+#include "GaitGenerator.h"
+#include "BalanceStabilizer.h"
+#include "Trigonometry.h"
 #include "Profiler.h"
 
 namespace
@@ -28,14 +32,74 @@ namespace
 	{
 		return static_cast<int>(value >> PRECISION);
 	}
+
+	using namespace PLEN2;
+
+	/*!
+		@brief Get the joint swapped with the joint given by mirroring
+
+		The joint ids of the left side are followed by the ones of the right side in the same order,
+		so a joint is swapped with the joint which is JointController::RIGHT_SHOULDER_PITCH away from it.
+	*/
+	inline constexpr unsigned char mirrored(const unsigned char joint_id)
+	{
+		return (joint_id + JointController::RIGHT_SHOULDER_PITCH) % JointController::SUM;
+	}
+
+	static_assert(JointController::RIGHT_SHOULDER_PITCH * 2 == JointController::SUM,
+		"The joints are not divided to the left and right sides equally.");
+	static_assert(   (mirrored(JointController::LEFT_SHOULDER_PITCH) == JointController::RIGHT_SHOULDER_PITCH)
+				  && (mirrored(JointController::LEFT_THIGH_YAW)      == JointController::RIGHT_THIGH_YAW)
+				  && (mirrored(JointController::LEFT_SHOULDER_ROLL)  == JointController::RIGHT_SHOULDER_ROLL)
+				  && (mirrored(JointController::LEFT_ELBOW_ROLL)     == JointController::RIGHT_ELBOW_ROLL)
+				  && (mirrored(JointController::LEFT_THIGH_ROLL)     == JointController::RIGHT_THIGH_ROLL)
+				  && (mirrored(JointController::LEFT_THIGH_PITCH)    == JointController::RIGHT_THIGH_PITCH)
+				  && (mirrored(JointController::LEFT_KNEE_PITCH)     == JointController::RIGHT_KNEE_PITCH)
+				  && (mirrored(JointController::LEFT_FOOT_PITCH)     == JointController::RIGHT_FOOT_PITCH)
+				  && (mirrored(JointController::LEFT_FOOT_ROLL)      == JointController::RIGHT_FOOT_ROLL)
+				  && (mirrored(JointController::RIGHT_FOOT_ROLL)     == JointController::LEFT_FOOT_ROLL),
+		"The joint ids of the right side are not in the same order as the left side.");
+
+	enum { INDEX_INVALID = 255 };
+
+	/*!
+		@brief Mirror a frame
+
+		@note
+		The servos of the right side are installed mirrored from the left side,
+		so every angle is inverted its sign when swapped.
+	*/
+	void mirror(Motion::Frame& frame)
+	{
+		int angles[JointController::SUM];
+
+		for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			angles[joint_id] = frame.joint_angle[joint_id];
+		}
+
+		for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			frame.joint_angle[joint_id] = -angles[mirrored(joint_id)];
+		}
+	}
 }
 
 
 PLEN2::MotionController::MotionController(JointController& joint_ctrl)
 {
 	m_joint_ctrl_ptr = &joint_ctrl;
+	m_gait_ptr       = NULL;
+	m_stabilizer_ptr = NULL;
+
+	m_playing    = false;
+	m_retiming   = false;
+	m_play_flags = 0;
+
+	m_reverse_slot_last    = INDEX_INVALID;
+	m_reverse_index_last   = INDEX_INVALID;
+	m_reverse_time_ms_last = 0;
 
-	m_playing = false;
 	m_frame_current_ptr = m_buffer;
 	m_frame_next_ptr    = m_buffer + 1;
 
@@ -46,6 +110,16 @@ PLEN2::MotionController::MotionController(JointController& joint_ctrl)
 }
 
 
+void PLEN2::MotionController::attachStabilizer(BalanceStabilizer& stabilizer)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionController::attachStabilizer()"));
+	#endif
+
+	m_stabilizer_ptr = &stabilizer;
+}
+
+
 bool PLEN2::MotionController::playing()
 {
 	#if DEBUG_HARD
@@ -82,6 +156,11 @@ bool PLEN2::MotionController::nextFrameLoadable()
 		volatile Utility::Profiler p(F("MotionController::nextFrameLoadable()"));
 	#endif
 
+	if (m_gait_ptr != NULL)
+	{
+		return m_gait_ptr->running();
+	}
+
 	if (   (m_header.use_loop)
 		|| (m_header.use_jump) )
 	{
@@ -92,7 +171,7 @@ bool PLEN2::MotionController::nextFrameLoadable()
 }
 
 
-void PLEN2::MotionController::play(unsigned char slot)
+bool PLEN2::MotionController::play(unsigned char slot, unsigned char flags)
 {
 	#if DEBUG
 		volatile Utility::Profiler p(F("MotionController::play()"));
@@ -104,7 +183,7 @@ void PLEN2::MotionController::play(unsigned char slot)
 			System::debugSerial().println(F(">>> error : A motion has been playing."));
 		#endif
 
-		return;
+		return false;
 	}
 
 	if (slot >= Motion::SLOT_END)
@@ -114,12 +193,51 @@ void PLEN2::MotionController::play(unsigned char slot)
 			System::debugSerial().println(static_cast<int>(slot));
 		#endif
 
+		return false;
+	}
+
+
+	if (!MotionDirectory::get(slot, m_header))
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> error : No sound motion in slot "));
+			System::debugSerial().println(static_cast<int>(slot));
+		#endif
+
+		return false;
+	}
+
+	m_play_flags = flags;
+	m_reverse_slot_last = INDEX_INVALID; // The slot might be rewritten after the last playing.
+
+	m_setupFrame(0);
+
+	m_playing = true;
+
+	return true;
+}
+
+
+void PLEN2::MotionController::play(GaitGenerator& gait)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionController::play()"));
+	#endif
+
+	if (playing())
+	{
+		#if DEBUG
+			System::debugSerial().println(F(">>> error : A motion has been playing."));
+		#endif
+
 		return;
 	}
 
 
-	m_header.slot = slot;
-	m_header.get();
+	m_gait_ptr = &gait;
+	m_gait_ptr->start();
+
+	m_play_flags = 0;
 
 	m_setupFrame(0);
 
@@ -135,6 +253,11 @@ void PLEN2::MotionController::willStop()
 
 	m_header.use_loop = 0;
 	m_header.use_jump = 0;
+
+	if (m_gait_ptr != NULL)
+	{
+		m_gait_ptr->willStop();
+	}
 }
 
 
@@ -144,7 +267,8 @@ void PLEN2::MotionController::stop()
 		volatile Utility::Profiler p(F("MotionController::stop()"));
 	#endif
 
-	m_playing = false;
+	m_playing  = false;
+	m_gait_ptr = NULL;
 	m_bufferingFrame(); // @attension It is necessary for a valid sequence!
 }
 
@@ -157,10 +281,27 @@ void PLEN2::MotionController::updateFrame()
 
 	m_transition_count--;
 
+	const int* offsets = NULL;
+
+	if (   (m_stabilizer_ptr != NULL)
+		&& (m_stabilizer_ptr->enabled()) )
+	{
+		m_stabilizer_ptr->update();
+		offsets = m_stabilizer_ptr->offsets();
+	}
+
 	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
 	{
 		m_current_fixed_points[joint_id] += m_diff_fixed_points[joint_id];
-		m_joint_ctrl_ptr->setAngleDiff(joint_id, unfixed_cast(m_current_fixed_points[joint_id]));
+
+		int angle_diff = unfixed_cast(m_current_fixed_points[joint_id]);
+
+		if (offsets != NULL)
+		{
+			angle_diff += offsets[joint_id];
+		}
+
+		m_joint_ctrl_ptr->setAngleDiff(joint_id, angle_diff);
 	}
 
 	m_joint_ctrl_ptr->m_1cycle_finished = false;
@@ -173,10 +314,42 @@ void PLEN2::MotionController::m_setupFrame(unsigned char index)
 		volatile Utility::Profiler p(F("MotionController::m_setupFrame()"));
 	#endif
 
-	m_frame_next_ptr->index = index;
-	m_frame_next_ptr->get(m_header.slot);
+	if (m_gait_ptr != NULL)
+	{
+		m_gait_ptr->generate(*m_frame_next_ptr);
+	}
+	else if (!m_loadFrame(index))
+	{
+		m_holdFrame();
+
+		return;
+	}
+
+	unsigned long transition_time_ms = m_frame_next_ptr->transition_time_ms;
+
+	if (m_retiming)
+	{
+		const unsigned long limited_time_ms = m_limitedTransitionTime();
+
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> planned : "));
+			System::debugSerial().print(transition_time_ms);
+			System::debugSerial().print(F(" [ms], limited : "));
+			System::debugSerial().print(limited_time_ms);
+			System::debugSerial().println(F(" [ms]"));
+		#endif
+
+		if (limited_time_ms > transition_time_ms)
+		{
+			// Round up, so the stretched transition never gets shorter than the limited time.
+			transition_time_ms = limited_time_ms + Motion::Frame::UPDATE_INTERVAL_MS - 1;
+		}
+	}
+
+	m_transition_count = constrain(
+		transition_time_ms / Motion::Frame::UPDATE_INTERVAL_MS, 1, TRANSITION_COUNT_MAX
+	);
 
-	m_transition_count = m_frame_next_ptr->transition_time_ms / Motion::Frame::UPDATE_INTERVAL_MS;
 	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
 	{
 		m_current_fixed_points[joint_id] = fixed_cast(m_frame_current_ptr->joint_angle[joint_id]);
@@ -187,6 +360,168 @@ void PLEN2::MotionController::m_setupFrame(unsigned char index)
 }
 
 
+bool PLEN2::MotionController::m_loadFrame(unsigned char index)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionController::m_loadFrame()"));
+	#endif
+
+	if (!(m_play_flags & PLAY_REVERSE))
+	{
+		m_frame_next_ptr->index = index;
+
+		if (!m_frame_next_ptr->get(m_header.slot))
+		{
+			return false;
+		}
+
+		if (m_play_flags & PLAY_MIRROR)
+		{
+			mirror(*m_frame_next_ptr);
+		}
+
+		return true;
+	}
+
+	/*!
+		@note
+		A stored frame has the time of transit to itself from the previous frame,
+		so walking backwards, a frame takes the time of the frame that follows it.
+		(The last frame takes the time of the first frame, as the time from the posture before playing.)
+		<br><br>
+		The time is cached from the frame loaded just before, so a sequential walk reads each frame once.
+	*/
+	const unsigned char physical_index = m_header.frame_length - 1 - index;
+	const unsigned char follower_index = (index == 0)? 0 : (physical_index + 1);
+
+	m_frame_next_ptr->index = physical_index;
+
+	if (!m_frame_next_ptr->get(m_header.slot))
+	{
+		m_reverse_slot_last = INDEX_INVALID;
+
+		return false;
+	}
+
+	unsigned int transition_time_ms = m_frame_next_ptr->transition_time_ms;
+
+	if (   (m_reverse_slot_last  == m_header.slot)
+		&& (m_reverse_index_last == follower_index) )
+	{
+		transition_time_ms = m_reverse_time_ms_last;
+	}
+	else
+	{
+		Motion::Frame follower;
+
+		follower.index = follower_index;
+
+		// A corrupt follower only loses its time, so the frame takes its own time.
+		if (follower.get(m_header.slot))
+		{
+			transition_time_ms = follower.transition_time_ms;
+		}
+	}
+
+	m_reverse_slot_last    = m_header.slot;
+	m_reverse_index_last   = physical_index;
+	m_reverse_time_ms_last = m_frame_next_ptr->transition_time_ms;
+
+	m_frame_next_ptr->index = index;
+	m_frame_next_ptr->transition_time_ms = transition_time_ms;
+
+	if (m_play_flags & PLAY_MIRROR)
+	{
+		mirror(*m_frame_next_ptr);
+	}
+
+	return true;
+}
+
+
+void PLEN2::MotionController::m_holdFrame()
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionController::m_holdFrame()"));
+	#endif
+
+	*m_frame_next_ptr = *m_frame_current_ptr;
+
+	m_frame_next_ptr->index              = m_header.frame_length - 1;
+	m_frame_next_ptr->transition_time_ms = Motion::Frame::UPDATE_INTERVAL_MS;
+
+	m_header.use_loop = 0;
+	m_header.use_jump = 0;
+
+	m_transition_count = 1;
+
+	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		m_current_fixed_points[joint_id] = fixed_cast(m_frame_current_ptr->joint_angle[joint_id]);
+		m_diff_fixed_points[joint_id]    = 0;
+	}
+}
+
+
+unsigned long PLEN2::MotionController::m_limitedTransitionTime()
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("MotionController::m_limitedTransitionTime()"));
+	#endif
+
+	/*!
+		@note
+		Each joint moves with a trapezoidal velocity profile which starts and ends at rest.
+		If the joint can't reach its max velocity within the distance,
+		the profile becomes triangular.
+	*/
+	unsigned long result = 0;
+
+	for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		const unsigned long distance = abs(
+			m_frame_next_ptr->joint_angle[joint_id] - m_frame_current_ptr->joint_angle[joint_id]
+		);
+
+		const unsigned long velocity     = m_joint_ctrl_ptr->getMaxVelocity(joint_id);
+		const unsigned long acceleration = m_joint_ctrl_ptr->getMaxAcceleration(joint_id);
+
+		if (distance == 0)
+		{
+			continue;
+		}
+
+		unsigned long time_ms;
+
+		if (distance * acceleration >= velocity * velocity)
+		{
+			time_ms = (distance * 1000) / velocity + (velocity * 1000) / acceleration;
+		}
+		else
+		{
+			time_ms = 2 * Utility::isqrt((distance * 1000000) / acceleration);
+		}
+
+		if (time_ms > result)
+		{
+			result = time_ms;
+		}
+	}
+
+	return result;
+}
+
+
+void PLEN2::MotionController::setRetiming(bool enabled)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionController::setRetiming()"));
+	#endif
+
+	m_retiming = enabled;
+}
+
+
 void PLEN2::MotionController::m_bufferingFrame()
 {
 	#if DEBUG
@@ -206,6 +541,14 @@ void PLEN2::MotionController::loadNextFrame()
 	#endif
 
 	m_bufferingFrame();
+
+	if (m_gait_ptr != NULL)
+	{
+		m_setupFrame(0);
+
+		return;
+	}
+
 	const unsigned char index_now = m_frame_current_ptr->index;
 
 	#if DEBUG
@@ -222,9 +565,23 @@ void PLEN2::MotionController::loadNextFrame()
 	*/
 	if (m_header.use_loop)
 	{
-		if (index_now >= m_header.loop_end)
+		/*!
+			@note
+			The loop is defined on the stored frames, and index_now is the index of the frames walked.
+			So the bounds are mapped when the frames are walked from the last one.
+		*/
+		unsigned char loop_begin = m_header.loop_begin;
+		unsigned char loop_end   = m_header.loop_end;
+
+		if (m_play_flags & PLAY_REVERSE)
+		{
+			loop_begin = m_header.frame_length - 1 - m_header.loop_end;
+			loop_end   = m_header.frame_length - 1 - m_header.loop_begin;
+		}
+
+		if (index_now >= loop_end)
 		{
-			m_setupFrame(m_header.loop_begin);
+			m_setupFrame(loop_begin);
 
 			if (m_header.loop_count != 255)
 			{
@@ -244,8 +601,16 @@ void PLEN2::MotionController::loadNextFrame()
 		&& (m_header.use_jump)
 		&& (index_now >= (m_header.frame_length - 1)) )
 	{
-		m_header.slot = m_header.jump_slot;
-		m_header.get();
+		if (!MotionDirectory::get(m_header.jump_slot, m_header))
+		{
+			m_holdFrame();
+
+			return;
+		}
+
+		// The play flags are kept, so the motion jumped to is played as the same way.
+		m_reverse_slot_last = INDEX_INVALID;
+
 		m_setupFrame(0);
 
 		return;
@@ -21,6 +21,9 @@ namespace PLEN2
 		class Frame;
 	}
 
+	class GaitGenerator;
+	class BalanceStabilizer;
+
 	#ifdef PLEN2_INTERPRETER_H
 		class Interpreter;
 	#endif
@@ -45,6 +48,15 @@ public:
 	*/
 	MotionController(JointController& joint_ctrl);
 
+	/*!
+		@brief Attach a balance stabilizer
+
+		Corrective offsets of the stabilizer are added to angles at each frame update.
+
+		@param [in, out] stabilizer Instance of a balance stabilizer.
+	*/
+	void attachStabilizer(BalanceStabilizer& stabilizer);
+
 	/*!
 		@brief Decide a motion is playing
 
@@ -73,12 +85,40 @@ public:
 	*/
 	bool nextFrameLoadable();
 
+	/*!
+		@brief Play flags
+	*/
+	enum {
+		PLAY_MIRROR  = (1 << 0), //!< Swap the left and right joints.
+		PLAY_REVERSE = (1 << 1)  //!< Walk the frames from the last one to the first one.
+	};
+
 	/*!
 		@brief Play a motion
 
 		@param [in] slot  Number of a motion.
+		@param [in] flags Please set logical sum of the play flags.
+
+		@note
+		The flags are applied to each frame when it is loaded,
+		so a mirrored or reversed motion doesn't need its own slot.
+		A loop of a reversed motion runs over the same frames as played forward,
+		and the flags are kept across a jump, so the motion jumped to is played with them too.
+
+		@return Result
+		@retval false A motion has been playing, or the slot has no sound motion.
+	*/
+	bool play(unsigned char slot, unsigned char flags = 0);
+
+	/*!
+		@brief Play a gait generated on the fly
+
+		The frames are not read from a stored motion, but generated by **gait** at each keyframe.
+		Stopping the gait is requested by willStop().
+
+		@param [in, out] gait Instance of a gait generator.
 	*/
-	void play(unsigned char slot);
+	void play(GaitGenerator& gait);
 
 	/*!
 		@brief Will stop playing a motion
@@ -117,19 +157,42 @@ public:
 	*/
 	void dump(unsigned char slot);
 
-private:
+	/*!
+		@brief Enable or disable retiming of transitions
+
+		When retiming is enabled, each transition is stretched so that no joint exceeds
+		its max velocity and max acceleration defined in the joint controller.
+		Transitions which already satisfy the limits are kept as planned.
+
+		@param [in] enabled Please set true to enable.
+	*/
+	void setRetiming(bool enabled);
+
+protected:
 	enum {
-		FRAMEBUFFER_LENGTH = 2
+		FRAMEBUFFER_LENGTH = 2,
+		TRANSITION_COUNT_MAX = 255 //!< Max count of the transition. (Limited by m_transition_count.)
 	};
 
 	void m_setupFrame(unsigned char index);
+	bool m_loadFrame(unsigned char index);
+	void m_holdFrame();
 	void m_bufferingFrame();
+	unsigned long m_limitedTransitionTime();
 
 
-	JointController* m_joint_ctrl_ptr;
+	JointController*   m_joint_ctrl_ptr;
+	GaitGenerator*     m_gait_ptr;
+	BalanceStabilizer* m_stabilizer_ptr;
 
 	unsigned char m_transition_count;
 	bool          m_playing;
+	bool          m_retiming;
+	unsigned char m_play_flags;
+
+	unsigned char m_reverse_slot_last;
+	unsigned char m_reverse_index_last;
+	unsigned int  m_reverse_time_ms_last;
 
 	Motion::Header m_header;
 	Motion::Frame  m_buffer[FRAMEBUFFER_LENGTH];
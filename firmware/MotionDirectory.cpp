@@ -0,0 +1,241 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "System.h"
+#include "Profiler.h"
+#include "Checksum.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	class Entry
+	{
+	public:
+		Motion::Header header;
+		unsigned long  duration_ms;
+		unsigned long  checksum;
+		bool           sound; //!< All the records of the motion passed verification.
+		bool           stale;
+	};
+
+	Entry entries[Motion::SLOT_END];
+
+
+	inline bool installed(const Motion::Header& header, unsigned char slot)
+	{
+		return (
+			   (header.slot == slot)
+			&& (header.frame_length >= Motion::Header::FRAMELENGTH_MIN)
+			&& (header.frame_length <= Motion::Header::FRAMELENGTH_MAX)
+		);
+	}
+
+	void build(unsigned char slot)
+	{
+		Entry& entry = entries[slot];
+
+		entry.header.slot = slot;
+		entry.sound       = entry.header.get();
+		entry.duration_ms = 0;
+		entry.checksum    = Utility::crc32(reinterpret_cast<const unsigned char*>(&entry.header), sizeof(Motion::Header));
+
+		if (installed(entry.header, slot))
+		{
+			Motion::Frame frame;
+
+			for (unsigned char index = 0; index < entry.header.frame_length; index++)
+			{
+				frame.index = index;
+
+				if (!frame.get(slot))
+				{
+					entry.sound = false;
+				}
+
+				entry.duration_ms += frame.transition_time_ms;
+				entry.checksum     = Utility::crc32(reinterpret_cast<const unsigned char*>(&frame), sizeof(Motion::Frame), entry.checksum);
+			}
+		}
+
+		entry.stale = false;
+	}
+
+	inline Entry& fresh(unsigned char slot)
+	{
+		if (entries[slot].stale)
+		{
+			build(slot);
+		}
+
+		return entries[slot];
+	}
+}
+
+
+void PLEN2::MotionDirectory::init()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionDirectory::init()"));
+	#endif
+
+	const unsigned long begin_msec = millis();
+	int count = 0;
+
+	for (int slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+	{
+		build(slot);
+
+		if (installed(entries[slot].header, slot))
+		{
+			count++;
+		}
+	}
+
+	System::outputSerial().print(F("motion directory : "));
+	System::outputSerial().print(count);
+	System::outputSerial().print(F(" motions in "));
+	System::outputSerial().print(millis() - begin_msec);
+	System::outputSerial().println(F(" [ms]"));
+}
+
+
+bool PLEN2::MotionDirectory::get(unsigned char slot, Motion::Header& header)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionDirectory::get()"));
+	#endif
+
+	if (slot >= Motion::SLOT_END)
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : slot = "));
+			System::debugSerial().println(static_cast<int>(slot));
+		#endif
+
+		return false;
+	}
+
+	const Entry& entry = fresh(slot);
+
+	if (   !(entry.sound)
+		|| !(installed(entry.header, slot)) )
+	{
+		return false;
+	}
+
+	header = entry.header;
+
+	return true;
+}
+
+
+void PLEN2::MotionDirectory::invalidate(unsigned char slot)
+{
+	if (slot < Motion::SLOT_END)
+	{
+		entries[slot].stale = true;
+	}
+}
+
+
+void PLEN2::MotionDirectory::dump()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionDirectory::dump()"));
+	#endif
+
+	bool first = true;
+
+	System::outputSerial().println(F("["));
+
+	for (int slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+	{
+		Entry& entry = fresh(slot);
+
+		if (!installed(entry.header, slot))
+		{
+			continue;
+		}
+
+		if (!first)
+		{
+			System::outputSerial().println(F(","));
+		}
+
+		first = false;
+
+		System::outputSerial().println(F("\t{"));
+
+		System::outputSerial().print(F("\t\t\"slot\": "));
+		System::outputSerial().print(slot);
+		System::outputSerial().println(F(","));
+
+		entry.header.name[Motion::Header::NAME_LENGTH - 1] = '\0'; // sanity check.
+		System::outputSerial().print(F("\t\t\"name\": \""));
+		System::outputSerial().print(entry.header.name);
+		System::outputSerial().println(F("\","));
+
+		System::outputSerial().print(F("\t\t\"frame_length\": "));
+		System::outputSerial().print(static_cast<int>(entry.header.frame_length));
+		System::outputSerial().println(F(","));
+
+		System::outputSerial().print(F("\t\t\"loop\": "));
+
+		if (entry.header.use_loop)
+		{
+			System::outputSerial().print(F("["));
+			System::outputSerial().print(static_cast<int>(entry.header.loop_begin));
+			System::outputSerial().print(F(", "));
+			System::outputSerial().print(static_cast<int>(entry.header.loop_end));
+			System::outputSerial().print(F(", "));
+			System::outputSerial().print(static_cast<int>(entry.header.loop_count));
+			System::outputSerial().println(F("],"));
+		}
+		else
+		{
+			System::outputSerial().println(F("null,"));
+		}
+
+		System::outputSerial().print(F("\t\t\"jump\": "));
+
+		if (entry.header.use_jump)
+		{
+			System::outputSerial().print(static_cast<int>(entry.header.jump_slot));
+			System::outputSerial().println(F(","));
+		}
+		else
+		{
+			System::outputSerial().println(F("null,"));
+		}
+
+		System::outputSerial().print(F("\t\t\"duration_ms\": "));
+		System::outputSerial().print(entry.duration_ms);
+		System::outputSerial().println(F(","));
+
+		System::outputSerial().print(F("\t\t\"checksum\": "));
+		System::outputSerial().print(entry.checksum);
+		System::outputSerial().println(F(","));
+
+		System::outputSerial().print(F("\t\t\"sound\": "));
+		System::outputSerial().println(entry.sound? F("true") : F("false"));
+
+		System::outputSerial().print(F("\t}"));
+	}
+
+	if (!first)
+	{
+		System::outputSerial().println();
+	}
+
+	System::outputSerial().println(F("]"));
+}
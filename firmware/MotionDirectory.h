@@ -0,0 +1,85 @@
+/*!
+	@file      MotionDirectory.h
+	@brief     Directory of the installed motions on RAM.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_MOTION_DIRECTORY_H
+#define PLEN2_MOTION_DIRECTORY_H
+
+#include "Motion.h"
+
+
+namespace PLEN2
+{
+	class MotionDirectory;
+}
+
+/*!
+	@brief Directory of the installed motions on RAM
+
+	The directory has a header, total duration and CRC-32 of each slot, and whether the records are sound.
+	It is built at boot, so getting a header doesn't access the motion file.
+	<br><br>
+	Writing a header or a frame marks the slot as stale,
+	and the slot is built again when it is accessed next time.
+*/
+class PLEN2::MotionDirectory
+{
+public:
+	/*!
+		@brief Build the directory
+
+		@attention
+		Please call it after Motion::migrate().
+	*/
+	static void init();
+
+	/*!
+		@brief Get the header of the slot given
+
+		@param [in]  slot   Please set slot number of a motion.
+		@param [out] header Please set instance to store the header.
+
+		@return Result
+		@retval false Argument error, or the slot has no sound motion. (**header** is not changed.)
+	*/
+	static bool get(unsigned char slot, Motion::Header& header);
+
+	/*!
+		@brief Mark the slot given as stale
+
+		@param [in] slot Please set slot number of a motion which is written.
+	*/
+	static void invalidate(unsigned char slot);
+
+	/*!
+		@brief Dump the installed motions
+
+		Outputs result like JSON format below.
+		@code
+		[
+			{
+				"slot": <integer>,
+				"name": <string>,
+				"frame_length": <integer>,
+				"loop": [<begin>, <end>, <count>] or null,
+				"jump": <slot> or null,
+				"duration_ms": <integer>,
+				"checksum": <integer>,
+				"sound": <boolean>
+			},
+			...
+		]
+		@endcode
+
+		@note
+		"duration_ms" is summation of transition times of the frames, without repeats by loop.
+	*/
+	static void dump();
+};
+
+#endif // PLEN2_MOTION_DIRECTORY_H
@@ -0,0 +1,161 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+#include "System.h"
+#include "Profiler.h"
+
+extern File fp_motion;
+
+namespace
+{
+	using namespace PLEN2;
+
+	bool           installing = false;
+	const void*    owner      = NULL;
+	unsigned long  staged_ms  = 0; //!< Time of the last begun or staged, on millis().
+	unsigned char  count      = 0;
+	Motion::Header header;
+	Motion::Frame  frames[Motion::Frame::FRAME_END];
+}
+
+
+bool PLEN2::MotionInstaller::begin(const Motion::Header& header_given, const void* owner_given)
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionInstaller::begin()"));
+	#endif
+
+	if (   (installing)
+		&& (owner != owner_given)
+		&& (millis() - staged_ms < STAGE_TIMEOUT_MS) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> busy : an install of another owner is staging"));
+		#endif
+
+		return false;
+	}
+
+	installing = false;
+
+	if (   (header_given.slot >= Motion::SLOT_END)
+		|| (header_given.frame_length < Motion::Header::FRAMELENGTH_MIN)
+		|| (header_given.frame_length > Motion::Header::FRAMELENGTH_MAX) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> bad argment : header"));
+		#endif
+
+		return false;
+	}
+
+	header     = header_given;
+	owner      = owner_given;
+	staged_ms  = millis();
+	count      = 0;
+	installing = true;
+
+	return true;
+}
+
+
+bool PLEN2::MotionInstaller::stage(const Motion::Frame& frame, const void* owner_given)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionInstaller::stage()"));
+	#endif
+
+	if (   (!installing)
+		|| (owner != owner_given)
+		|| (frame.index != count)
+		|| (count >= header.frame_length) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : frame.index = "));
+			System::debugSerial().println(static_cast<int>(frame.index));
+		#endif
+
+		return false;
+	}
+
+	frames[count++] = frame;
+	staged_ms       = millis();
+
+	return true;
+}
+
+
+bool PLEN2::MotionInstaller::staged()
+{
+	return (   (installing)
+			&& (count == header.frame_length) );
+}
+
+
+bool PLEN2::MotionInstaller::commit(const void* owner_given)
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionInstaller::commit()"));
+	#endif
+
+	if (owner != owner_given)
+	{
+		return false;
+	}
+
+	if (!staged())
+	{
+		installing = false;
+
+		return false;
+	}
+
+	installing = false;
+
+	if (!ExternalFs::begin(fp_motion))
+	{
+		return false;
+	}
+
+	/*
+		The header before is erased first and the header is written last, so any part of the records on the flash
+		restores the motion before, no motion, or the motion installed. (Refer to the note of MotionInstaller.)
+	*/
+	bool result = MotionStore::erase(header.slot);
+	MotionDirectory::invalidate(header.slot);
+
+	for (unsigned char index = 0; index < count; index++)
+	{
+		result = frames[index].set(header.slot) && result;
+	}
+
+	if (result)
+	{
+		result = header.set();
+	}
+
+	result = ExternalFs::commit() && result;
+
+	return result;
+}
+
+
+void PLEN2::MotionInstaller::abort(const void* owner_given)
+{
+	if (owner == owner_given)
+	{
+		installing = false;
+	}
+}
@@ -0,0 +1,97 @@
+/*!
+	@file      MotionInstaller.h
+	@brief     Staged install of a motion.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_MOTION_INSTALLER_H
+#define PLEN2_MOTION_INSTALLER_H
+
+#include "Motion.h"
+
+
+namespace PLEN2
+{
+	class MotionInstaller;
+}
+
+/*!
+	@brief Staged install of a motion
+
+	The header and the frames of a motion are staged on RAM as they are received,
+	and are written to the motion store at once by a transaction when all the frames are staged.
+	So the flash is written only once for a motion, and a motion which fails is never installed partially.
+	<br><br>
+	The records reach the flash in the order of the log, and a page may be written back before the commit ends.
+	So the header of the motion before is erased first, the frames are written next, and the header is written last.
+	If the power is lost while committing, the slot has the motion before, no motion, or the motion installed,
+	and a header never refers to frames of another motion.
+
+	@attention
+	The stage is only one, since the RAM can't afford one for each input channel.
+	So an install is owned by the channel which began it, and an install of another owner is rejected while it is staging.
+	An install not staged for STAGE_TIMEOUT_MS is abandoned, so a channel lost on the way doesn't block the others.
+*/
+class PLEN2::MotionInstaller
+{
+public:
+	enum {
+		STAGE_TIMEOUT_MS = 1000 //!< Time from the last staged after which an install is abandoned.
+	};
+
+	/*!
+		@brief Begin an install
+
+		The install which the owner began before is discarded.
+
+		@param [in] header Please set the header of the motion.
+		@param [in] owner  Please set the owner of the install, e.g. the instance of the input channel.
+
+		@return Result
+		@retval false The header is broken, or an install of another owner is staging.
+	*/
+	static bool begin(const Motion::Header& header, const void* owner = NULL);
+
+	/*!
+		@brief Stage a frame
+
+		@param [in] frame Please set the frame. (The frames must be given in the order of their indices.)
+		@param [in] owner Please set the owner given to begin().
+
+		@return Result
+		@retval false No install of the owner has begun, or the index is unexpected.
+	*/
+	static bool stage(const Motion::Frame& frame, const void* owner = NULL);
+
+	/*!
+		@brief Decide all the frames are staged
+
+		@return Result
+	*/
+	static bool staged();
+
+	/*!
+		@brief Write the motion staged to the motion store
+
+		The install ends whether it succeeds or not.
+
+		@param [in] owner Please set the owner given to begin().
+
+		@return Result
+		@retval false The install is of another owner, all the frames are not staged,
+		              a transaction is open on another file, or the store failed.
+	*/
+	static bool commit(const void* owner = NULL);
+
+	/*!
+		@brief Discard the install staging
+
+		@param [in] owner Please set the owner given to begin(). (The install of another owner is kept.)
+	*/
+	static void abort(const void* owner = NULL);
+};
+
+#endif // PLEN2_MOTION_INSTALLER_H
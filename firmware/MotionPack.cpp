@@ -0,0 +1,483 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionPack.h"
+#include "System.h"
+#include "Profiler.h"
+#include "Checksum.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	enum {
+		STAGE_PACK_HEADER,
+		STAGE_HEADERS,
+		STAGE_FRAMES,
+		STAGE_TRAILER,
+		STAGE_FINISHED,
+		STAGE_BROKEN
+	};
+
+	enum {
+		PACK_HEADER_SIZE = 8,
+		FRAME_SIZE       = 2 + 2 * JointController::SUM,
+		TRAILER_SIZE     = 4,
+		RECORD_SIZE_MAX  = FRAME_SIZE
+	};
+
+	const unsigned char MAGIC[] = { 'P', 'L', 'M', 'P' };
+
+	bool          exporting       = false;
+	unsigned char stage           = STAGE_FINISHED;
+	unsigned char record[RECORD_SIZE_MAX];
+	unsigned int  record_size     = 0;
+	unsigned int  record_position = 0;
+
+	unsigned char count  = 0;
+	unsigned char motion = 0;
+	unsigned char index  = 0;
+	unsigned char slots[Motion::SLOT_END];
+	unsigned char frame_lengths[Motion::SLOT_END];
+
+	Motion::Header headers[Motion::SLOT_END]; //!< Header table of the pack importing, which begins the install of each motion.
+
+	unsigned long crc        = 0;
+	unsigned long bytes      = 0;
+	unsigned long begin_msec = 0;
+	unsigned long elapsed_ms = 0;
+	bool          result     = false;
+
+
+	inline void put16(unsigned char data[], int value)
+	{
+		data[0] = value & 0xFF;
+		data[1] = (value >> 8) & 0xFF;
+	}
+
+	inline int get16(const unsigned char data[])
+	{
+		return static_cast<short>(data[0] | (data[1] << 8));
+	}
+
+	void begin(bool export_mode)
+	{
+		exporting       = export_mode;
+		stage           = STAGE_PACK_HEADER;
+		record_size     = PACK_HEADER_SIZE;
+		record_position = 0;
+		motion          = 0;
+		index           = 0;
+		crc             = 0;
+		bytes           = 0;
+		result          = false;
+		begin_msec      = millis();
+	}
+
+	//! @brief Skip the stages which have no record left.
+	void advance()
+	{
+		if (   (stage == STAGE_HEADERS)
+			&& (motion == count) )
+		{
+			stage  = STAGE_FRAMES;
+			motion = 0;
+			index  = 0;
+		}
+
+		if (   (stage == STAGE_FRAMES)
+			&& (motion == count) )
+		{
+			stage = STAGE_TRAILER;
+		}
+
+		record_size = (stage == STAGE_HEADERS)? sizeof(Motion::Header)
+					: (stage == STAGE_FRAMES)?  FRAME_SIZE
+					: TRAILER_SIZE;
+	}
+
+
+	//! @brief Build the record at the cursor, and move the cursor to the next record.
+	void export_record()
+	{
+		switch (stage)
+		{
+			case STAGE_PACK_HEADER:
+			{
+				memcpy(record, MAGIC, sizeof(MAGIC));
+				record[4] = MotionPack::PACK_VERSION;
+				record[5] = count;
+				record[6] = 0;
+				record[7] = 0;
+
+				record_size = PACK_HEADER_SIZE;
+				stage       = STAGE_HEADERS;
+
+				break;
+			}
+
+			case STAGE_HEADERS:
+			{
+				Motion::Header header;
+
+				// The motion might be removed or rewritten after beginExport(), and then the pack can't be made.
+				if (   !(MotionDirectory::get(slots[motion], header))
+					|| (header.frame_length != frame_lengths[motion]) )
+				{
+					stage = STAGE_BROKEN;
+
+					return;
+				}
+
+				memcpy(record, &header, sizeof(header));
+				motion++;
+
+				break;
+			}
+
+			case STAGE_FRAMES:
+			{
+				Motion::Frame frame;
+				frame.index = index;
+
+				if (!frame.get(slots[motion]))
+				{
+					stage = STAGE_BROKEN;
+
+					return;
+				}
+
+				put16(record, frame.transition_time_ms);
+
+				for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+				{
+					put16(record + 2 + joint_id * 2, frame.joint_angle[joint_id]);
+				}
+
+				if (++index == frame_lengths[motion])
+				{
+					index = 0;
+					motion++;
+				}
+
+				break;
+			}
+
+			case STAGE_TRAILER:
+			{
+				memcpy(record, &crc, TRAILER_SIZE);
+				stage = STAGE_FINISHED;
+
+				break;
+			}
+		}
+
+		if (stage != STAGE_FINISHED)
+		{
+			crc = Utility::crc32(record, record_size, crc);
+		}
+
+		record_position = 0;
+	}
+
+
+	//! @brief Install the record received, and decide the size of the next record.
+	void import_record()
+	{
+		if (stage != STAGE_TRAILER)
+		{
+			crc = Utility::crc32(record, record_size, crc);
+		}
+
+		switch (stage)
+		{
+			case STAGE_PACK_HEADER:
+			{
+				count = record[5];
+
+				if (   (memcmp(record, MAGIC, sizeof(MAGIC)) != 0)
+					|| (record[4] != MotionPack::PACK_VERSION)
+					|| (count > Motion::SLOT_END) )
+				{
+					stage = STAGE_BROKEN;
+
+					return;
+				}
+
+				stage = STAGE_HEADERS;
+
+				break;
+			}
+
+			case STAGE_HEADERS:
+			{
+				Motion::Header& header = headers[motion];
+				memcpy(&header, record, sizeof(header));
+
+				if (   (header.slot >= Motion::SLOT_END)
+					|| (header.frame_length < Motion::Header::FRAMELENGTH_MIN)
+					|| (header.frame_length > Motion::Header::FRAMELENGTH_MAX) )
+				{
+					stage = STAGE_BROKEN;
+
+					return;
+				}
+
+				frame_lengths[motion] = header.frame_length;
+				motion++;
+
+				break;
+			}
+
+			case STAGE_FRAMES:
+			{
+				Motion::Frame frame;
+
+				frame.index              = index;
+				frame.transition_time_ms = get16(record);
+
+				for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+				{
+					frame.joint_angle[joint_id] = get16(record + 2 + joint_id * 2);
+				}
+
+				memset(frame.device_value, 0, sizeof(frame.device_value));
+
+				// The motion is installed only when all its frames are received, so it is never installed partially.
+				if (   (   (index == 0)
+						&& !(MotionInstaller::begin(headers[motion])) )
+					|| !(MotionInstaller::stage(frame)) )
+				{
+					stage = STAGE_BROKEN;
+
+					return;
+				}
+
+				if (++index == frame_lengths[motion])
+				{
+					if (!MotionInstaller::commit())
+					{
+						stage = STAGE_BROKEN;
+
+						return;
+					}
+
+					index = 0;
+					motion++;
+				}
+
+				break;
+			}
+
+			case STAGE_TRAILER:
+			{
+				stage = (memcmp(record, &crc, TRAILER_SIZE) == 0)? STAGE_FINISHED : STAGE_BROKEN;
+
+				return;
+			}
+		}
+
+		advance();
+		record_position = 0;
+	}
+}
+
+
+unsigned long PLEN2::MotionPack::beginExport()
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionPack::beginExport()"));
+	#endif
+
+	Motion::Header header;
+	unsigned long frame_sum = 0;
+
+	count = 0;
+
+	for (int slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+	{
+		if (MotionDirectory::get(slot, header))
+		{
+			slots[count]         = slot;
+			frame_lengths[count] = header.frame_length;
+			frame_sum           += header.frame_length;
+			count++;
+		}
+	}
+
+	begin(true);
+	record_position = record_size; // Nothing is built yet.
+
+	return PACK_HEADER_SIZE + count * sizeof(Motion::Header) + frame_sum * FRAME_SIZE + TRAILER_SIZE;
+}
+
+
+unsigned int PLEN2::MotionPack::readChunk(unsigned char data[], unsigned int size)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionPack::readChunk()"));
+	#endif
+
+	unsigned int length = 0;
+
+	while (   (exporting)
+		   && (length < size) )
+	{
+		if (record_position == record_size)
+		{
+			if (   (stage == STAGE_FINISHED)
+				|| (stage == STAGE_BROKEN) )
+			{
+				break;
+			}
+
+			if (stage != STAGE_PACK_HEADER)
+			{
+				advance();
+			}
+
+			export_record();
+		}
+
+		const unsigned int copy_size = min(size - length, record_size - record_position);
+
+		memcpy(data + length, record + record_position, copy_size);
+
+		length          += copy_size;
+		record_position += copy_size;
+	}
+
+	bytes += length;
+
+	return length;
+}
+
+
+void PLEN2::MotionPack::beginImport()
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionPack::beginImport()"));
+	#endif
+
+	count = 0;
+	begin(false);
+}
+
+
+bool PLEN2::MotionPack::writeChunk(const unsigned char data[], unsigned int size)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionPack::writeChunk()"));
+	#endif
+
+	if (exporting)
+	{
+		return false;
+	}
+
+	unsigned int position = 0;
+
+	while (position < size)
+	{
+		if (   (stage == STAGE_FINISHED)
+			|| (stage == STAGE_BROKEN) )
+		{
+			stage = STAGE_BROKEN; // Trailing garbage, or the pack has already been broken.
+
+			break;
+		}
+
+		const unsigned int copy_size = min(size - position, record_size - record_position);
+
+		memcpy(record + record_position, data + position, copy_size);
+
+		position        += copy_size;
+		record_position += copy_size;
+
+		if (record_position == record_size)
+		{
+			import_record();
+		}
+	}
+
+	bytes += position;
+
+	return (stage != STAGE_BROKEN);
+}
+
+
+bool PLEN2::MotionPack::importFinished()
+{
+	return (   (!exporting)
+			&& (stage == STAGE_FINISHED) );
+}
+
+
+bool PLEN2::MotionPack::end()
+{
+	#if DEBUG_LESS
+		volatile Utility::Profiler p(F("MotionPack::end()"));
+	#endif
+
+	elapsed_ms = millis() - begin_msec;
+	result     = (stage == STAGE_FINISHED);
+
+	// The motion staging is discarded, if the pack is broken or incomplete.
+	if (   (!exporting)
+		&& (!result) )
+	{
+		MotionInstaller::abort();
+	}
+
+	if (exporting)
+	{
+		result = result && (record_position == record_size); // The trailer has been read.
+	}
+
+	#if DEBUG_LESS
+		dump(System::debugSerial());
+	#endif
+
+	return result;
+}
+
+
+void PLEN2::MotionPack::dump(Stream& stream)
+{
+	stream.println(F("{"));
+
+	stream.print(F("\t\"direction\": \""));
+	stream.print(exporting? F("export") : F("import"));
+	stream.println(F("\","));
+
+	stream.print(F("\t\"result\": "));
+	stream.print(result? F("true") : F("false"));
+	stream.println(F(","));
+
+	stream.print(F("\t\"motions\": "));
+	stream.print(static_cast<int>(count));
+	stream.println(F(","));
+
+	stream.print(F("\t\"bytes\": "));
+	stream.print(bytes);
+	stream.println(F(","));
+
+	stream.print(F("\t\"elapsed_ms\": "));
+	stream.print(elapsed_ms);
+	stream.println(F(","));
+
+	stream.print(F("\t\"throughput_kb_per_s\": "));
+	stream.println(bytes * 1000 / 1024 / max(elapsed_ms, 1UL));
+
+	stream.println(F("}"));
+}
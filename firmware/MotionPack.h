@@ -0,0 +1,120 @@
+/*!
+	@file      MotionPack.h
+	@brief     Binary package of the installed motions.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_MOTION_PACK_H
+#define PLEN2_MOTION_PACK_H
+
+
+class Stream;
+
+namespace PLEN2
+{
+	class MotionPack;
+}
+
+/*!
+	@brief Binary package of the installed motions
+
+	A pack is streamed to or from the motion store in chunks, so it is never held on RAM.
+	The layout is below. (Integers are little endian.)
+	@code
+	"PLMP", <version : 1 byte>, <count : 1 byte>, <reserved : 2 bytes>
+	<Motion::Header> * count                                   // Header table.
+	{ <transition_time_ms : 2 bytes>, <angle : 2 bytes> * 18 } // Frames of the motions in the order of the table.
+	<CRC-32 of all the bytes above : 4 bytes>
+	@endcode
+
+	@attention
+	Each motion is staged by MotionInstaller, and is installed when all its frames are received.
+	So a pack which fails leaves the motions before it installed, but never a motion installed partially.
+	The stage is shared, so importing a pack discards an install by the protocol staging now.
+*/
+class PLEN2::MotionPack
+{
+public:
+	enum {
+		PACK_VERSION = 1,
+		CHUNK_SIZE   = 256 //!< Recommended chunk size of the transports. (bytes)
+	};
+
+	/*!
+		@brief Begin exporting the installed motions
+
+		@return Size of the pack. (bytes)
+	*/
+	static unsigned long beginExport();
+
+	/*!
+		@brief Read the next chunk of the pack
+
+		@param [out] data Please set buffer to store the chunk.
+		@param [in]  size Please set buffer size.
+
+		@return Size of the chunk. (0 means the end of the pack.)
+
+		@attention
+		A motion removed or rewritten while exporting ends the pack early, so please check end() after it.
+	*/
+	static unsigned int readChunk(unsigned char data[], unsigned int size);
+
+	/*!
+		@brief Begin importing a pack
+
+		@attention
+		Please don't import a pack while a motion is playing, because the motion might be rewritten.
+	*/
+	static void beginImport();
+
+	/*!
+		@brief Write the next chunk of the pack
+
+		@param [in] data Please set the chunk.
+		@param [in] size Please set size of the chunk.
+
+		@return Result
+		@retval false The pack is broken, or the import has finished.
+	*/
+	static bool writeChunk(const unsigned char data[], unsigned int size);
+
+	/*!
+		@brief Decide the whole pack has been imported
+
+		@return Result
+	*/
+	static bool importFinished();
+
+	/*!
+		@brief Finish the transfer
+
+		@return Result
+		@retval false The pack is broken or incomplete.
+	*/
+	static bool end();
+
+	/*!
+		@brief Dump the result of the last transfer
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"direction": <"import" or "export">,
+			"result": <boolean>,
+			"motions": <integer>,
+			"bytes": <integer>,
+			"elapsed_ms": <integer>,
+			"throughput_kb_per_s": <integer>
+		}
+		@endcode
+
+		@param [out] stream Please set the stream to output.
+	*/
+	static void dump(Stream& stream);
+};
+
+#endif // PLEN2_MOTION_PACK_H
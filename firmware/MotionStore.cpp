@@ -0,0 +1,913 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionStore.h"
+#include "System.h"
+#include "Profiler.h"
+#include "Checksum.h"
+
+extern File fp_motion;
+
+namespace
+{
+	using namespace PLEN2;
+
+	class LogHeader
+	{
+	public:
+		unsigned long magic;
+		unsigned long generation; //!< Incremented by each compaction.
+	};
+
+	class RecordHead
+	{
+	public:
+		unsigned char magic;
+		unsigned char type;
+		unsigned char slot;
+		unsigned char index;
+	};
+
+	class CheckpointHeader
+	{
+	public:
+		unsigned long magic;
+		unsigned long generation; //!< Generation of the log that the index belongs to.
+		unsigned long log_end;    //!< End of the log that the index covers.
+	};
+
+	enum {
+		LOG_MAGIC        = 0x504C4C32, // "PLL2"
+		CHECKPOINT_MAGIC = 0x504C4350, // "PLCP"
+		RECORD_MAGIC     = 0xA5,
+
+		/*!
+			@brief Alignment of the records
+
+			Positions are stored by the unit in 16 bits, so the log can use 1 MB.
+		*/
+		ALIGNMENT     = 16,
+		LOG_BEGIN     = ALIGNMENT, //!< Position of the first record. (Next to the log header.)
+		POSITION_NONE = 0xFFFF,
+
+		ENTRY_PER_SLOT = 1 + Motion::Header::FRAMELENGTH_MAX,
+		ENTRY_SUM      = (Motion::SLOT_END - Motion::SLOT_BEGIN) * ENTRY_PER_SLOT,
+
+		CRC_SIZE        = 4,
+		RECORD_SIZE_MAX = (sizeof(RecordHead) + sizeof(Motion::Frame) + CRC_SIZE + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT,
+
+		COMPACTION_STEP_RECORDS = 4,
+		COMPACTION_THRESHOLD    = 0x40000, //!< Log size to consider compaction. (bytes)
+		CHECKPOINT_DELAY_MS     = 2000     //!< Quiet time of the log before writing a checkpoint.
+	};
+
+	unsigned short index_table[ENTRY_SUM];  //!< Position of the latest record. (Unit of ALIGNMENT bytes.)
+	unsigned short shadow_table[ENTRY_SUM]; //!< Index of the log under compaction.
+
+	unsigned long generation = 0;
+	unsigned long log_end    = LOG_BEGIN;
+	unsigned long live_bytes = 0;
+
+	bool          compacting        = false;
+	File          fp_compacting;
+	unsigned long compacting_end    = LOG_BEGIN;
+	unsigned int  compaction_cursor = 0;
+
+	bool          checkpoint_dirty = false;
+	unsigned long append_msec_last = 0;
+
+	unsigned long logical_bytes  = 0;
+	unsigned long physical_bytes = 0;
+	unsigned long compactions    = 0;
+	unsigned long checkpoints    = 0;
+
+	unsigned long verified_records = 0;
+	unsigned long corrupt_records  = 0;
+	unsigned long verify_usec_last = 0;
+	unsigned long verify_usec_max  = 0;
+
+
+	inline unsigned int payload_size(unsigned char type)
+	{
+		if (type == MotionStore::TYPE_ERASE)
+		{
+			return 0;
+		}
+
+		return (type == MotionStore::TYPE_HEADER)? sizeof(Motion::Header) : sizeof(Motion::Frame);
+	}
+
+	/*!
+		@brief Size of a record
+
+		A record is the head, the payload and CRC-32 of them, which is padded to ALIGNMENT.
+	*/
+	inline unsigned int record_size(unsigned char type)
+	{
+		return (sizeof(RecordHead) + payload_size(type) + CRC_SIZE + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	inline unsigned char type_of(int entry)
+	{
+		return ((entry % ENTRY_PER_SLOT) == 0)? MotionStore::TYPE_HEADER : MotionStore::TYPE_FRAME;
+	}
+
+	//! @note A record of TYPE_ERASE belongs to the entry of the header.
+	int entry_of(unsigned char type, unsigned char slot, unsigned char index)
+	{
+		if (   (slot >= Motion::SLOT_END)
+			|| ((type != MotionStore::TYPE_HEADER) && (type != MotionStore::TYPE_FRAME) && (type != MotionStore::TYPE_ERASE))
+			|| ((type == MotionStore::TYPE_FRAME)  && (index >= Motion::Header::FRAMELENGTH_MAX)) )
+		{
+			return -1;
+		}
+
+		return slot * ENTRY_PER_SLOT + ((type == MotionStore::TYPE_FRAME)? (1 + index) : 0);
+	}
+
+	//! @brief Position of the entry after the record given is appended or replayed
+	inline unsigned short position_of(unsigned char type, unsigned long position)
+	{
+		return (type == MotionStore::TYPE_ERASE)? POSITION_NONE : position / ALIGNMENT;
+	}
+
+	inline unsigned int crc_offset(unsigned char type)
+	{
+		return sizeof(RecordHead) + payload_size(type);
+	}
+
+	void seal(unsigned char record[], unsigned char type)
+	{
+		const unsigned long crc = Utility::crc32(record, crc_offset(type));
+
+		memcpy(record + crc_offset(type), &crc, CRC_SIZE);
+	}
+
+	/*!
+		@brief Decide the record given is sound
+
+		@param [in] record Please set the record read from the log.
+		@param [in] entry  Please set the entry expected, or -1 to accept any entry.
+	*/
+	bool sound(const unsigned char record[], int entry)
+	{
+		const RecordHead* head = reinterpret_cast<const RecordHead*>(record);
+		const int head_entry   = entry_of(head->type, head->slot, head->index);
+
+		if (   (head->magic != RECORD_MAGIC)
+			|| (head_entry < 0)
+			|| ((entry >= 0) && (head_entry != entry)) )
+		{
+			return false;
+		}
+
+		unsigned long crc = 0;
+		memcpy(&crc, record + crc_offset(head->type), CRC_SIZE);
+
+		return (Utility::crc32(record, crc_offset(head->type)) == crc);
+	}
+
+	void clear(unsigned short table[])
+	{
+		for (int entry = 0; entry < ENTRY_SUM; entry++)
+		{
+			table[entry] = POSITION_NONE;
+		}
+	}
+
+	void count_live_bytes()
+	{
+		live_bytes = 0;
+
+		for (int entry = 0; entry < ENTRY_SUM; entry++)
+		{
+			if (index_table[entry] != POSITION_NONE)
+			{
+				live_bytes += record_size(type_of(entry));
+			}
+		}
+	}
+
+	void write_log_header(File fp, unsigned long log_generation)
+	{
+		LogHeader header;
+
+		header.magic      = LOG_MAGIC;
+		header.generation = log_generation;
+
+		ExternalFs::write(0, sizeof(header), reinterpret_cast<const unsigned char*>(&header), fp);
+	}
+
+
+	/*!
+		@brief Find the first sound record from the position given
+
+		@return Position of the record, or **file_size** if there is no sound record.
+	*/
+	unsigned long next_sound(unsigned long position, unsigned long file_size)
+	{
+		unsigned char record[RECORD_SIZE_MAX];
+		const RecordHead* head = reinterpret_cast<const RecordHead*>(record);
+
+		for (; position + sizeof(RecordHead) <= file_size; position += ALIGNMENT)
+		{
+			ExternalFs::read(position, sizeof(RecordHead), record, fp_motion);
+
+			if (   (head->magic != RECORD_MAGIC)
+				|| (entry_of(head->type, head->slot, head->index) < 0)
+				|| (position + record_size(head->type) > file_size) )
+			{
+				continue;
+			}
+
+			ExternalFs::read(position, record_size(head->type), record, fp_motion);
+
+			if (sound(record, -1))
+			{
+				return position;
+			}
+		}
+
+		return file_size;
+	}
+
+
+	/*!
+		@brief Replay the records from the position given to the end of the log
+
+		A corrupt record which has a sound record after it is skipped,
+		and its entry refers to it, so reading the entry fails instead of giving an older record.
+		Only a torn tail, which has no sound record after it, is discarded.
+	*/
+	void replay(unsigned long position)
+	{
+		const unsigned long file_size = fp_motion.size();
+
+		unsigned char record[RECORD_SIZE_MAX];
+		const RecordHead* head = reinterpret_cast<const RecordHead*>(record);
+		int replayed = 0;
+		int skipped  = 0;
+
+		while (position + sizeof(RecordHead) <= file_size)
+		{
+			ExternalFs::read(position, sizeof(RecordHead), record, fp_motion);
+
+			const int entry = entry_of(head->type, head->slot, head->index);
+
+			if (   (head->magic == RECORD_MAGIC)
+				&& (entry >= 0)
+				&& (position + record_size(head->type) > file_size) )
+			{
+				break;
+			}
+
+			if (   (head->magic == RECORD_MAGIC)
+				&& (entry >= 0) )
+			{
+				ExternalFs::read(position, record_size(head->type), record, fp_motion);
+
+				if (sound(record, entry))
+				{
+					index_table[entry] = position_of(head->type, position);
+					position += record_size(head->type);
+					replayed++;
+
+					continue;
+				}
+			}
+
+			const unsigned long next = next_sound(position + ALIGNMENT, file_size);
+
+			if (next == file_size)
+			{
+				break;
+			}
+
+			// The head is sound, so the entry is known.
+			if (   (head->magic == RECORD_MAGIC)
+				&& (entry >= 0) )
+			{
+				index_table[entry] = position / ALIGNMENT;
+			}
+
+			System::outputSerial().print(F("skip corrupt record of the motion log : "));
+			System::outputSerial().println(position);
+
+			corrupt_records++;
+			position = next;
+			skipped++;
+		}
+
+		log_end = position;
+
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> replayed records : "));
+			System::debugSerial().print(replayed);
+			System::debugSerial().print(F(", skipped : "));
+			System::debugSerial().println(skipped);
+		#endif
+
+		if (log_end < file_size)
+		{
+			System::outputSerial().print(F("discard torn tail of the motion log : "));
+			System::outputSerial().print(file_size - log_end);
+			System::outputSerial().println(F(" bytes"));
+
+			fp_motion.truncate(log_end);
+			ExternalFs::invalidate();
+		}
+	}
+
+
+	bool load_checkpoint()
+	{
+		if (!SPIFFS.exists(MOTION_CHECKPOINT_FILE))
+		{
+			return false;
+		}
+
+		File fp = SPIFFS.open(MOTION_CHECKPOINT_FILE, "r");
+		CheckpointHeader header;
+
+		bool result = (
+			   (fp.size() >= sizeof(header) + sizeof(index_table))
+			&& (ExternalFs::read(0, sizeof(header), reinterpret_cast<unsigned char*>(&header), fp) != -1)
+			&& (header.magic      == CHECKPOINT_MAGIC)
+			&& (header.generation == generation)
+			&& (header.log_end    >= LOG_BEGIN)
+			&& (header.log_end    <= fp_motion.size())
+		);
+
+		if (result)
+		{
+			ExternalFs::read(sizeof(header), sizeof(index_table), reinterpret_cast<unsigned char*>(index_table), fp);
+			log_end = header.log_end;
+		}
+
+		fp.close();
+
+		return result;
+	}
+
+
+	void save_checkpoint()
+	{
+		#if DEBUG
+			volatile Utility::Profiler p(F("MotionStore::save_checkpoint()"));
+		#endif
+
+		File fp = SPIFFS.open(MOTION_CHECKPOINT_FILE, SPIFFS.exists(MOTION_CHECKPOINT_FILE)? "r+" : "w+");
+
+		CheckpointHeader header;
+
+		header.magic      = CHECKPOINT_MAGIC;
+		header.generation = generation;
+		header.log_end    = log_end;
+
+		// The index is written before the header. (Refer to the note of MotionStore.)
+		ExternalFs::begin(fp);
+		ExternalFs::write(sizeof(header), sizeof(index_table), reinterpret_cast<const unsigned char*>(index_table), fp);
+
+		// The header is not written over an index written partially, so the last checkpoint remains valid.
+		if (!ExternalFs::commit())
+		{
+			fp.close();
+
+			return;
+		}
+
+		ExternalFs::write(0, sizeof(header), reinterpret_cast<const unsigned char*>(&header), fp);
+
+		fp.close();
+
+		physical_bytes  += sizeof(header) + sizeof(index_table);
+		checkpoint_dirty = false;
+		checkpoints++;
+	}
+
+
+	void start_compaction()
+	{
+		#if DEBUG_LESS
+			volatile Utility::Profiler p(F("MotionStore::start_compaction()"));
+		#endif
+
+		if (SPIFFS.exists(MOTION_FILE_COMPACTING))
+		{
+			SPIFFS.remove(MOTION_FILE_COMPACTING);
+		}
+
+		fp_compacting = SPIFFS.open(MOTION_FILE_COMPACTING, "w+");
+		ExternalFs::invalidate();
+		write_log_header(fp_compacting, generation + 1);
+
+		clear(shadow_table);
+
+		compacting_end    = LOG_BEGIN;
+		compaction_cursor = 0;
+		compacting        = true;
+	}
+
+
+	/*!
+		@brief Abandon the compaction, when writing the new log failed
+
+		The log has all the records still, so the compaction is started again when it is needed.
+	*/
+	void abort_compaction()
+	{
+		fp_compacting.close();
+		SPIFFS.remove(MOTION_FILE_COMPACTING);
+		ExternalFs::invalidate();
+
+		compacting = false;
+
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> error : Writing the compacted log failed."));
+		#endif
+	}
+
+
+	void step_compaction(unsigned int records)
+	{
+		#if DEBUG
+			volatile Utility::Profiler p(F("MotionStore::step_compaction()"));
+		#endif
+
+		if (!ExternalFs::begin(fp_compacting))
+		{
+			return;
+		}
+
+		unsigned char record[RECORD_SIZE_MAX];
+
+		while (   (records > 0)
+			   && (compaction_cursor < ENTRY_SUM) )
+		{
+			const int entry = compaction_cursor++;
+
+			// An entry appended during compaction is in the new log already.
+			if (   (index_table[entry]  == POSITION_NONE)
+				|| (shadow_table[entry] != POSITION_NONE) )
+			{
+				continue;
+			}
+
+			const unsigned int size = record_size(type_of(entry));
+
+			ExternalFs::read(static_cast<unsigned long>(index_table[entry]) * ALIGNMENT, size, record, fp_motion);
+			ExternalFs::write(compacting_end, size, record, fp_compacting);
+
+			shadow_table[entry] = compacting_end / ALIGNMENT;
+			compacting_end     += size;
+			physical_bytes     += size;
+
+			records--;
+		}
+
+		if (!ExternalFs::commit())
+		{
+			abort_compaction();
+		}
+	}
+
+
+	/*!
+		@attention
+		The log file is replaced, so it must not be called while a transaction is open.
+	*/
+	void finish_compaction()
+	{
+		#if DEBUG_LESS
+			volatile Utility::Profiler p(F("MotionStore::finish_compaction()"));
+		#endif
+
+		fp_compacting.close();
+		fp_motion.close();
+
+		SPIFFS.remove(MOTION_FILE);
+		SPIFFS.rename(MOTION_FILE_COMPACTING, MOTION_FILE);
+
+		fp_motion = SPIFFS.open(MOTION_FILE, "r+");
+		ExternalFs::invalidate();
+
+		memcpy(index_table, shadow_table, sizeof(index_table));
+
+		log_end    = compacting_end;
+		compacting = false;
+		generation++;
+		compactions++;
+
+		count_live_bytes();
+		save_checkpoint();
+	}
+
+
+	bool compaction_needed()
+	{
+		return (
+			   (log_end > COMPACTION_THRESHOLD)
+			&& ((log_end - LOG_BEGIN) > 2 * live_bytes)
+		) || (log_end > MOTION_FILE_SIZE / 4 * 3);
+	}
+}
+
+
+void PLEN2::MotionStore::init()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionStore::init()"));
+	#endif
+
+	const unsigned long begin_msec = millis();
+
+	// A compaction before is restarted, as after a reboot.
+	if (compacting)
+	{
+		fp_compacting.close();
+		compacting = false;
+	}
+
+	/*!
+		@note
+		The log under compaction replaces the log only after it is completed,
+		so it is adopted only when the log has been removed.
+	*/
+	if (SPIFFS.exists(MOTION_FILE_COMPACTING))
+	{
+		if (fp_motion.size() == 0)
+		{
+			fp_motion.close();
+			SPIFFS.remove(MOTION_FILE);
+			SPIFFS.rename(MOTION_FILE_COMPACTING, MOTION_FILE);
+			fp_motion = SPIFFS.open(MOTION_FILE, "r+");
+			ExternalFs::invalidate();
+		}
+		else
+		{
+			SPIFFS.remove(MOTION_FILE_COMPACTING);
+		}
+	}
+
+	LogHeader header;
+	ExternalFs::read(0, sizeof(header), reinterpret_cast<unsigned char*>(&header), fp_motion);
+
+	if (   (fp_motion.size() < LOG_BEGIN)
+		|| (header.magic != LOG_MAGIC) )
+	{
+		fp_motion.truncate(0);
+		ExternalFs::invalidate();
+
+		generation = 1;
+		write_log_header(fp_motion, generation);
+	}
+	else
+	{
+		generation = header.generation;
+	}
+
+	clear(index_table);
+
+	if (!load_checkpoint())
+	{
+		clear(index_table);
+		log_end = LOG_BEGIN;
+	}
+
+	replay(log_end);
+	count_live_bytes();
+
+	System::outputSerial().print(F("motion log : "));
+	System::outputSerial().print(log_end);
+	System::outputSerial().print(F(" bytes, restored in "));
+	System::outputSerial().print(millis() - begin_msec);
+	System::outputSerial().println(F(" [ms]"));
+}
+
+
+bool PLEN2::MotionStore::read(
+	unsigned char type,
+	unsigned char slot,
+	unsigned char index,
+	unsigned char data[],
+	unsigned int  size
+)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionStore::read()"));
+	#endif
+
+	const int entry = entry_of(type, slot, index);
+
+	if (   (entry < 0)
+		|| (type == TYPE_ERASE)
+		|| (size > payload_size(type)) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : slot = "));
+			System::debugSerial().print(static_cast<int>(slot));
+			System::debugSerial().print(F(", or index = "));
+			System::debugSerial().println(static_cast<int>(index));
+		#endif
+
+		return false;
+	}
+
+	if (index_table[entry] == POSITION_NONE)
+	{
+		memset(data, ExternalFs::FILL_VALUE(), size);
+
+		return false;
+	}
+
+	unsigned char record[RECORD_SIZE_MAX];
+
+	if (ExternalFs::read(
+		static_cast<unsigned long>(index_table[entry]) * ALIGNMENT, record_size(type), record, fp_motion
+	) == -1)
+	{
+		memset(data, ExternalFs::FILL_VALUE(), size);
+
+		return false;
+	}
+
+	const unsigned long begin_usec = micros();
+	// A corrupt record of TYPE_ERASE may be referred to by the entry of the header. (Refer to replay().)
+	const bool result = sound(record, entry) && (reinterpret_cast<const RecordHead*>(record)->type == type);
+
+	verify_usec_last = micros() - begin_usec;
+	verify_usec_max  = max(verify_usec_max, verify_usec_last);
+
+	if (!result)
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> error : corrupt record : slot = "));
+			System::debugSerial().print(static_cast<int>(slot));
+			System::debugSerial().print(F(", index = "));
+			System::debugSerial().println(static_cast<int>(index));
+		#endif
+
+		corrupt_records++;
+		memset(data, ExternalFs::FILL_VALUE(), size);
+
+		return false;
+	}
+
+	verified_records++;
+	memcpy(data, record + sizeof(RecordHead), size);
+
+	return true;
+}
+
+
+bool PLEN2::MotionStore::append(
+	unsigned char       type,
+	unsigned char       slot,
+	unsigned char       index,
+	const unsigned char data[],
+	unsigned int        size
+)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionStore::append()"));
+	#endif
+
+	const int entry = entry_of(type, slot, index);
+
+	if (   (entry < 0)
+		|| (size != payload_size(type)) )
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : slot = "));
+			System::debugSerial().print(static_cast<int>(slot));
+			System::debugSerial().print(F(", or index = "));
+			System::debugSerial().println(static_cast<int>(index));
+		#endif
+
+		return false;
+	}
+
+	const unsigned int record_length = record_size(type);
+
+	// Make a room by compaction at once, if the log is full.
+	if (   (log_end + record_length > MOTION_FILE_SIZE)
+		&& (!ExternalFs::inTransaction()) )
+	{
+		if (!compacting)
+		{
+			start_compaction();
+		}
+
+		step_compaction(ENTRY_SUM);
+
+		if (compacting)
+		{
+			finish_compaction();
+		}
+	}
+
+	if (log_end + record_length > MOTION_FILE_SIZE)
+	{
+		#if DEBUG_LESS
+			System::debugSerial().println(F(">>> error : The motion log is full."));
+		#endif
+
+		return false;
+	}
+
+
+	unsigned char record[RECORD_SIZE_MAX];
+	RecordHead* head = reinterpret_cast<RecordHead*>(record);
+
+	head->magic = RECORD_MAGIC;
+	head->type  = type;
+	head->slot  = slot;
+	head->index = (type == TYPE_FRAME)? index : 0;
+
+	memcpy(record + sizeof(RecordHead), data, size);
+	memset(record + sizeof(RecordHead) + size, 0, record_length - sizeof(RecordHead) - size);
+	seal(record, type);
+
+	if (ExternalFs::write(log_end, record_length, record, fp_motion) != 1)
+	{
+		return false;
+	}
+
+	if (index_table[entry] != POSITION_NONE)
+	{
+		live_bytes -= record_size(type_of(entry));
+	}
+
+	if (type != TYPE_ERASE)
+	{
+		live_bytes += record_length;
+	}
+
+	index_table[entry] = position_of(type, log_end);
+	log_end           += record_length;
+
+	// A record of TYPE_ERASE is copied too, so the new log never restores a header erased.
+	if (compacting)
+	{
+		if (ExternalFs::write(compacting_end, record_length, record, fp_compacting) == 1)
+		{
+			shadow_table[entry] = position_of(type, compacting_end);
+			compacting_end     += record_length;
+			physical_bytes     += record_length;
+		}
+		else
+		{
+			abort_compaction();
+		}
+	}
+
+	logical_bytes   += size;
+	physical_bytes  += record_length;
+
+	checkpoint_dirty = true;
+	append_msec_last = millis();
+
+	return true;
+}
+
+
+bool PLEN2::MotionStore::erase(unsigned char slot)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionStore::erase()"));
+	#endif
+
+	const int entry = entry_of(TYPE_HEADER, slot, 0);
+
+	if (entry < 0)
+	{
+		#if DEBUG_LESS
+			System::debugSerial().print(F(">>> bad argment : slot = "));
+			System::debugSerial().println(static_cast<int>(slot));
+		#endif
+
+		return false;
+	}
+
+	// A header which has never been written, or has been erased, has nothing to be replayed.
+	if (index_table[entry] == POSITION_NONE)
+	{
+		return true;
+	}
+
+	const unsigned char none = 0;
+
+	return append(TYPE_ERASE, slot, 0, &none, 0);
+}
+
+
+void PLEN2::MotionStore::idle()
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("MotionStore::idle()"));
+	#endif
+
+	if (ExternalFs::inTransaction())
+	{
+		return;
+	}
+
+	if (compacting)
+	{
+		if (compaction_cursor < ENTRY_SUM)
+		{
+			step_compaction(COMPACTION_STEP_RECORDS);
+		}
+		else
+		{
+			finish_compaction();
+		}
+
+		return;
+	}
+
+	if (compaction_needed())
+	{
+		start_compaction();
+
+		return;
+	}
+
+	if (   (checkpoint_dirty)
+		&& (millis() - append_msec_last >= CHECKPOINT_DELAY_MS) )
+	{
+		save_checkpoint();
+	}
+}
+
+
+void PLEN2::MotionStore::dump()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("MotionStore::dump()"));
+	#endif
+
+	System::outputSerial().println(F("{"));
+
+	System::outputSerial().print(F("\t\"generation\": "));
+	System::outputSerial().print(generation);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"log_end\": "));
+	System::outputSerial().print(log_end);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"live_bytes\": "));
+	System::outputSerial().print(live_bytes);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"compacting\": "));
+	System::outputSerial().print(static_cast<int>(compacting));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"compactions\": "));
+	System::outputSerial().print(compactions);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"checkpoints\": "));
+	System::outputSerial().print(checkpoints);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"logical_bytes\": "));
+	System::outputSerial().print(logical_bytes);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"physical_bytes\": "));
+	System::outputSerial().print(physical_bytes);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"write_amplification_x100\": "));
+	System::outputSerial().print((logical_bytes == 0)? 0 : (physical_bytes * 100 / logical_bytes));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"verified_records\": "));
+	System::outputSerial().print(verified_records);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"corrupt_records\": "));
+	System::outputSerial().print(corrupt_records);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"verify_usec_last\": "));
+	System::outputSerial().print(verify_usec_last);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"verify_usec_max\": "));
+	System::outputSerial().println(verify_usec_max);
+
+	System::outputSerial().println(F("}"));
+}
@@ -0,0 +1,133 @@
+/*!
+	@file      MotionStore.h
+	@brief     Log-structured store of motion records.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_MOTION_STORE_H
+#define PLEN2_MOTION_STORE_H
+
+
+namespace PLEN2
+{
+	class MotionStore;
+}
+
+/*!
+	@brief Log-structured store of motion records
+
+	Headers and frames are appended to the motion file as records, and never overwritten in place.
+	An index in RAM (slot and frame to position of the latest record) is restored at boot from a checkpoint file,
+	and then the records appended after the checkpoint are replayed on it.
+	<br><br>
+	Superseded records are removed by compaction, that copies live records to a new log
+	a few records at a time in idle time, and replaces the log when it finishes.
+
+	Each record has CRC-32 of itself, and it is verified when the record is read or replayed.
+	<br><br>
+	@note
+	A record torn by power loss is always the tail of the log, so it is discarded when the log is replayed.
+	A corrupt record in the middle of the log is skipped, and the motion which has it is not sound.
+	A checkpoint is written index first and header last, so a torn checkpoint replays from the older end of the log.
+*/
+class PLEN2::MotionStore
+{
+public:
+	enum {
+		TYPE_HEADER = 1, //!< Record type of a motion header.
+		TYPE_FRAME  = 2, //!< Record type of a motion frame.
+		TYPE_ERASE  = 3  //!< Record type which erases the header of a motion. (It has no payload.)
+	};
+
+	/*!
+		@brief Restore the index
+
+		@attention
+		Please call it after ExternalFs::init().
+	*/
+	static void init();
+
+	/*!
+		@brief Read the latest record
+
+		If the record has never been written or is corrupt, **data** is filled with ExternalFs::FILL_VALUE().
+
+		@param [in]  type  Please set a record type.
+		@param [in]  slot  Please set slot number of a motion.
+		@param [in]  index Please set index of a frame. (It is ignored for a header.)
+		@param [out] data  Please set buffer to store the record.
+		@param [in]  size  Please set buffer size.
+
+		@return Result
+		@retval false Argument error, the record has never been written, or the record is corrupt.
+	*/
+	static bool read(unsigned char type, unsigned char slot, unsigned char index, unsigned char data[], unsigned int size);
+
+	/*!
+		@brief Append a record
+
+		@param [in] type  Please set a record type.
+		@param [in] slot  Please set slot number of a motion.
+		@param [in] index Please set index of a frame. (It is ignored for a header.)
+		@param [in] data  Please set the record.
+		@param [in] size  Please set size of the record.
+
+		@return Result
+		@retval false Argument error, or the log is full.
+	*/
+	static bool append(unsigned char type, unsigned char slot, unsigned char index, const unsigned char data[], unsigned int size);
+
+	/*!
+		@brief Erase the header of a motion
+
+		A record of TYPE_ERASE is appended, so the header is not restored by the replay of the records before it.
+		The frames remain, but they are not read as a motion until a new header is appended.
+
+		@param [in] slot Please set slot number of a motion.
+
+		@return Result
+		@retval false Argument error, or the log is full.
+	*/
+	static bool erase(unsigned char slot);
+
+	/*!
+		@brief Do background work of the store
+
+		Runs a step of compaction, or writes a checkpoint when the log has been quiet for a while.
+		Usage assumption is to call the method when no motion is playing.
+	*/
+	static void idle();
+
+	/*!
+		@brief Dump the state and metrics of the store
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"generation": <integer>,
+			"log_end": <integer>,
+			"live_bytes": <integer>,
+			"compacting": <integer>,
+			"compactions": <integer>,
+			"checkpoints": <integer>,
+			"logical_bytes": <integer>,
+			"physical_bytes": <integer>,
+			"write_amplification_x100": <integer>,
+			"verified_records": <integer>,
+			"corrupt_records": <integer>,
+			"verify_usec_last": <integer>,
+			"verify_usec_max": <integer>
+		}
+		@endcode
+
+		@note
+		"physical_bytes" includes record heads, padding, copies by compaction and checkpoints.
+		"verify_usec_*" are the time to verify CRC-32 of a record.
+	*/
+	static void dump();
+};
+
+#endif // PLEN2_MOTION_STORE_H
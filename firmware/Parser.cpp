@@ -6,12 +6,86 @@
 	This software is released under the MIT License.
 	(See also : http://opensource.org/licenses/mit-license.php)
 */
-#include <ctype.h>
 #include <string.h>
 
 #include "Parser.h"
 
 
+namespace
+{
+	/*!
+		@note
+		The kernel below packs 4 characters into a word, the first character in the lowest byte,
+		and handles them as 4 lanes of 8 bits. Each lane is kept 7 bits before an addition,
+		so no carry runs over to the next lane.
+	*/
+	enum {
+		LANES_ONE   = 0x01010101,
+		LANES_LOW7  = 0x7F7F7F7F,
+		LANES_HIGH  = 0x80808080,
+		LANES_ZEROS = 0x30303030 //!< "0000"
+	};
+
+	/*!
+		@brief Pack characters into a word
+
+		Less than 4 characters are padded with heading "0",
+		which changes neither the value nor the validity.
+	*/
+	inline unsigned int pack(const char* bytes, unsigned char size)
+	{
+		if (size == 4)
+		{
+			return static_cast<unsigned char>(bytes[0])
+				| (static_cast<unsigned char>(bytes[1]) << 8)
+				| (static_cast<unsigned char>(bytes[2]) << 16)
+				| (static_cast<unsigned int>(static_cast<unsigned char>(bytes[3])) << 24);
+		}
+
+		unsigned int word = LANES_ZEROS;
+
+		for (unsigned char index = 0; index < size; index++)
+		{
+			word = (word >> 8) | (static_cast<unsigned int>(static_cast<unsigned char>(bytes[index])) << 24);
+		}
+
+		return word;
+	}
+
+	//! @brief Set bit 7 of the lanes whose character is "low" or more
+	inline unsigned int lanes_ge(unsigned int word_low7, unsigned char low)
+	{
+		return word_low7 + (0x80 - low) * LANES_ONE;
+	}
+
+	/*!
+		@brief Decide the lanes are hex characters
+
+		@return Bit 7 of each lane is set if the lane is a hex character.
+	*/
+	inline unsigned int lanes_hex(unsigned int word)
+	{
+		const unsigned int low7  = word & LANES_LOW7;
+		const unsigned int lower = low7 | (0x20 * LANES_ONE);
+
+		const unsigned int digit  = lanes_ge(low7, '0')  & ~lanes_ge(low7, '9' + 1);
+		const unsigned int letter = lanes_ge(lower, 'a') & ~lanes_ge(lower, 'f' + 1);
+
+		return (digit | letter) & ~word & LANES_HIGH;
+	}
+
+	//! @brief Convert the 4 hex characters of the word
+	inline unsigned int lanes_value(unsigned int word)
+	{
+		// Bit 6 is set only on the letters, which are the lower 4 bits + 9.
+		const unsigned int nibbles = (word & (0x0F * LANES_ONE)) + ((word >> 6) & LANES_ONE) * 9;
+		const unsigned int bytes   = ((nibbles & 0x000F000F) << 4) | ((nibbles >> 8) & 0x000F000F);
+
+		return ((bytes & 0xFF) << 8) | ((bytes >> 16) & 0xFF);
+	}
+}
+
+
 namespace Utility
 {
 
@@ -105,17 +179,17 @@ StringGroupParser::~StringGroupParser()
 
 bool StringGroupParser::parse(const char* input)
 {
-	unsigned char begin  = 0;
-	unsigned char middle = m_size / 2;
-	unsigned char end    = m_size;
+	/*!
+		@note
+		The range searched is [begin, end), so "end" never underflows
+		and "middle" never reaches m_size.
+	*/
+	unsigned char begin = 0;
+	unsigned char end   = m_size;
 
-	while (begin <= end)
+	while (begin < end)
 	{
-		if (strlen(input) != strlen(m_accept_strs[middle]))
-		{
-			m_index = -1;
-			return false;
-		}
+		const unsigned char middle = begin + (end - begin) / 2;
 
 		int result = strcasecmp(input, m_accept_strs[middle]);
 
@@ -127,18 +201,11 @@ bool StringGroupParser::parse(const char* input)
 
 		if (result > 0)
 		{
-			begin  = middle + 1;
-			middle = (begin + end) / 2;
-
-			continue;
+			begin = middle + 1;
 		}
-
-		if (result < 0)
+		else
 		{
-			end    = middle - 1;
-			middle = (begin + end) / 2;
-
-			continue;
+			end = middle;
 		}
 	}
 
@@ -162,14 +229,25 @@ HexStringParser::~HexStringParser()
 
 bool HexStringParser::parse(const char* input)
 {
-	do
+	unsigned int size = strlen(input);
+
+	if (size == 0)
+	{
+		m_index = -1;
+		return false;
+	}
+
+	// The heading characters are checked with padding, and the rest are checked 4 at a time.
+	unsigned char head = ((size - 1) & 3) + 1;
+
+	for (; size > 0; input += head, size -= head, head = 4)
 	{
-		if (isxdigit(*input++) == 0)
+		if (lanes_hex(pack(input, head)) != LANES_HIGH)
 		{
 			m_index = -1;
 			return false;
 		}
-	} while (*input != '\0');
+	}
 
 	m_index = 0;
 	return true;
@@ -180,6 +258,29 @@ bool HexStringParser::parse(const char* input)
 	@brief Convert hex string to an unsigned int
 */
 unsigned int hexbytes2uint(const char* bytes, unsigned char size)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	// The heading characters are converted with padding, and the rest are converted 4 at a time.
+	unsigned char head   = ((size - 1) & 3) + 1;
+	unsigned int  result = 0;
+
+	for (; size > 0; bytes += head, size -= head, head = 4)
+	{
+		result = (result << 16) | lanes_value(pack(bytes, head));
+	}
+
+	return result;
+}
+
+
+/*!
+	@brief Convert hex string to an unsigned int one character at a time
+*/
+unsigned int hexbytes2uintScalar(const char* bytes, unsigned char size)
 {
 	unsigned int result = 0;
 
@@ -22,14 +22,30 @@ namespace Utility
 	/*!
 		@brief Convert hex string to an unsigned int
 
+		Converts 4 characters at once in a 32-bit word. (SWAR : SIMD within a register)
+
 		@param [in] bytes Pointer of hex string buffer.
-		@param [in] size  Length of hex string buffer.
+		@param [in] size  Length of hex string buffer. (8 or less.)
 
 		@attention
 		The method does not validate arguments.
 	*/
 	unsigned int hexbytes2uint(const char* bytes, unsigned char size);
 
+	/*!
+		@brief Convert hex string to an unsigned int one character at a time
+
+		It is the reference implementation of hexbytes2uint(),
+		and both of them return the same value for any hex string.
+
+		@param [in] bytes Pointer of hex string buffer.
+		@param [in] size  Length of hex string buffer.
+
+		@attention
+		The method does not validate arguments.
+	*/
+	unsigned int hexbytes2uintScalar(const char* bytes, unsigned char size);
+
 	/*!
 		@brief Convert hex string to an int
 
@@ -0,0 +1,308 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "System.h"
+#include "JointController.h"
+#include "PoseStream.h"
+#include "Profiler.h"
+
+namespace
+{
+	using namespace PLEN2;
+
+	enum { TIMESTAMP_MASK = 0xFFFF };
+
+	const unsigned long ALL_JOINTS = (1UL << JointController::SUM) - 1;
+
+	//! @brief Decide time "a" is before time "b" on millis(), considering the wrap around
+	inline bool before(unsigned long a, unsigned long b)
+	{
+		return static_cast<long>(a - b) < 0;
+	}
+}
+
+
+PLEN2::PoseStream::PoseStream(JointController& joint_ctrl)
+	: m_joint_ctrl_ptr(&joint_ctrl)
+	, m_head(0)
+	, m_count(0)
+	, m_streaming(false)
+	, m_synchronized(false)
+	, m_holding(false)
+	, m_depth_ms(DEPTH_MS_DEFAULT)
+	, m_timestamp_last(0)
+	, m_offset_ms(0)
+	, m_received(0)
+	, m_late(0)
+	, m_overflows(0)
+	, m_underruns(0)
+{
+	// noop.
+}
+
+
+bool PLEN2::PoseStream::begin(unsigned int depth_ms)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("PoseStream::begin()"));
+	#endif
+
+	if (   (depth_ms < DEPTH_MS_MIN)
+		|| (depth_ms > DEPTH_MS_MAX) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment! : depth_ms = "));
+			System::debugSerial().println(depth_ms);
+		#endif
+
+		return false;
+	}
+
+	m_depth_ms     = depth_ms;
+	m_head         = 0;
+	m_count        = 0;
+	m_streaming    = true;
+	m_synchronized = false;
+	m_holding      = false;
+
+	m_received  = 0;
+	m_late      = 0;
+	m_overflows = 0;
+	m_underruns = 0;
+
+	return true;
+}
+
+
+void PLEN2::PoseStream::end()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("PoseStream::end()"));
+	#endif
+
+	m_streaming    = false;
+	m_synchronized = false;
+	m_holding      = false;
+	m_count        = 0;
+}
+
+
+bool PLEN2::PoseStream::streaming()
+{
+	return m_streaming;
+}
+
+
+bool PLEN2::PoseStream::push(unsigned int timestamp_ms, const int angle_diffs[JointController::SUM])
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("PoseStream::push()"));
+	#endif
+
+	if (!m_streaming)
+	{
+		begin(m_depth_ms);
+	}
+
+	m_received++;
+
+	// The timestamp is extended to 32 bits from the difference to the newest one.
+	const short step = static_cast<short>((timestamp_ms - m_timestamp_last) & TIMESTAMP_MASK);
+
+	const unsigned long timestamp = m_synchronized? (m_timestamp_last + step) : (timestamp_ms & TIMESTAMP_MASK);
+	const unsigned long now_ms    = millis();
+
+	/*!
+		@note
+		The held pose is moved to the current time when the stream restarts,
+		so the joints move from it to the new pose smoothly in the buffer depth.
+	*/
+	if (   (!m_synchronized)
+		|| (m_holding) )
+	{
+		m_offset_ms      = now_ms + m_depth_ms - timestamp;
+		m_timestamp_last = timestamp;
+		m_synchronized   = true;
+
+		if (m_holding)
+		{
+			m_pose(0).play_ms = now_ms;
+			m_holding         = false;
+		}
+	}
+	else if (step > 0)
+	{
+		m_timestamp_last = timestamp;
+	}
+
+	const unsigned long play_ms = timestamp + m_offset_ms;
+
+	if (before(play_ms, now_ms))
+	{
+		m_late++; // The jitter is over the buffer depth.
+
+		return false;
+	}
+
+	// A pose overtaken by the newer ones is inserted in the order of the time.
+	unsigned char index = m_count;
+
+	while (   (index > 0)
+		   && (!before(m_pose(index - 1).play_ms, play_ms)) )
+	{
+		if (m_pose(index - 1).play_ms == play_ms)
+		{
+			m_late++; // Duplicated.
+
+			return false;
+		}
+
+		index--;
+	}
+
+	if (m_count == BUFFER_LENGTH)
+	{
+		m_overflows++; // The host runs ahead of the buffer depth.
+
+		return false;
+	}
+
+	for (unsigned char moved = m_count; moved > index; moved--)
+	{
+		m_pose(moved) = m_pose(moved - 1);
+	}
+
+	m_count++;
+
+	Pose& pose = m_pose(index);
+
+	pose.play_ms = play_ms;
+
+	for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		pose.angle_diffs[joint_id] = angle_diffs[joint_id];
+	}
+
+	return true;
+}
+
+
+bool PLEN2::PoseStream::updatable()
+{
+	return (   (m_streaming)
+			&& (m_joint_ctrl_ptr->m_1cycle_finished) );
+}
+
+
+void PLEN2::PoseStream::update()
+{
+	#if DEBUG_HARD
+		volatile Utility::Profiler p(F("PoseStream::update()"));
+	#endif
+
+	m_joint_ctrl_ptr->m_1cycle_finished = false;
+
+	const unsigned long now_ms = millis();
+
+	while (   (m_count >= 2)
+		   && (!before(now_ms, m_pose(1).play_ms)) )
+	{
+		m_pop();
+	}
+
+	if (   (m_count == 0)
+		|| (before(now_ms, m_pose(0).play_ms))
+		|| (m_holding) )
+	{
+		return;
+	}
+
+	const Pose& from = m_pose(0);
+
+	int angle_diffs[JointController::SUM];
+
+	if (m_count == 1)
+	{
+		m_holding = true;
+		m_underruns++;
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			angle_diffs[joint_id] = from.angle_diffs[joint_id];
+		}
+	}
+	else
+	{
+		const Pose& to = m_pose(1);
+
+		const long elapsed_ms = now_ms - from.play_ms;
+		const long span_ms    = to.play_ms - from.play_ms;
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			angle_diffs[joint_id] = from.angle_diffs[joint_id]
+				+ (static_cast<long>(to.angle_diffs[joint_id] - from.angle_diffs[joint_id]) * elapsed_ms) / span_ms;
+		}
+	}
+
+	m_joint_ctrl_ptr->setAnglesDiff(angle_diffs, ALL_JOINTS);
+}
+
+
+void PLEN2::PoseStream::dump()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("PoseStream::dump()"));
+	#endif
+
+	System::outputSerial().println(F("{"));
+
+	System::outputSerial().print(F("\t\"streaming\": "));
+	System::outputSerial().print(static_cast<int>(m_streaming));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"depth_ms\": "));
+	System::outputSerial().print(m_depth_ms);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"buffered\": "));
+	System::outputSerial().print(static_cast<int>(m_count));
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"received\": "));
+	System::outputSerial().print(m_received);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"late\": "));
+	System::outputSerial().print(m_late);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"overflows\": "));
+	System::outputSerial().print(m_overflows);
+	System::outputSerial().println(F(","));
+
+	System::outputSerial().print(F("\t\"underruns\": "));
+	System::outputSerial().println(m_underruns);
+
+	System::outputSerial().println(F("}"));
+}
+
+
+PLEN2::PoseStream::Pose& PLEN2::PoseStream::m_pose(unsigned char index)
+{
+	return m_buffer[(m_head + index) % BUFFER_LENGTH];
+}
+
+
+void PLEN2::PoseStream::m_pop()
+{
+	m_head = (m_head + 1) % BUFFER_LENGTH;
+	m_count--;
+}
@@ -0,0 +1,174 @@
+/*!
+	@file      PoseStream.h
+	@brief     Real-time pose streaming with a jitter buffer.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_POSE_STREAM_H
+#define PLEN2_POSE_STREAM_H
+
+#include "JointController.h"
+#include "Motion.h"
+
+
+namespace PLEN2
+{
+	class PoseStream;
+}
+
+/*!
+	@brief Real-time pose streaming with a jitter buffer
+
+	A host sends poses stamped with its own clock.
+	Each pose is played at "timestamp + offset", where the offset is decided by the first pose
+	so that it is played after the buffer depth, and the poses are interpolated at the control rate.
+	So the jitter of the network doesn't reach the joints if the depth covers it and the interval of the poses,
+	and the latency added is the depth at most.
+	<br><br>
+	When the buffer runs out, the last pose is held and the underrun is counted.
+	The offset is decided again by the next pose, so the stream restarts with the depth.
+	A pose overtaken by the newer ones is inserted in the order of the time,
+	and a pose arriving after its play time is dropped as a late one.
+
+	@note
+	All angles are angle-diffs from the home positions, and have steps of degree 1/10.
+*/
+class PLEN2::PoseStream
+{
+public:
+	enum {
+		BUFFER_LENGTH = 16, //!< Max count of the poses buffered.
+
+		DEPTH_MS_MIN     = Motion::Frame::UPDATE_INTERVAL_MS,     //!< Min value of the buffer depth.
+		DEPTH_MS_DEFAULT = Motion::Frame::UPDATE_INTERVAL_MS * 3, //!< Default value of the buffer depth.
+
+		/*!
+			@brief Max value of the buffer depth
+
+			Poses sent at the control rate for the depth and the jitter have to fit in the buffer.
+		*/
+		DEPTH_MS_MAX = Motion::Frame::UPDATE_INTERVAL_MS * BUFFER_LENGTH / 2
+	};
+
+	/*!
+		@brief Constructor
+
+		@param [in] joint_ctrl An instance of joint controller.
+	*/
+	PoseStream(JointController& joint_ctrl);
+
+	/*!
+		@brief Begin streaming
+
+		The poses buffered are discarded.
+
+		@param [in] depth_ms Please set the buffer depth.
+
+		@return Result
+		@retval false The depth is out of the range.
+	*/
+	bool begin(unsigned int depth_ms);
+
+	/*!
+		@brief End streaming
+	*/
+	void end();
+
+	/*!
+		@brief Decide streaming has begun
+
+		@return Result
+	*/
+	bool streaming();
+
+	/*!
+		@brief Push a pose received
+
+		Streaming begins with the current depth if it has not begun.
+
+		@param [in] timestamp_ms Please set the timestamp of the host, which may wrap around at 16 bits.
+		@param [in] angle_diffs  Please set angle-diffs of all the joints.
+
+		@return Result
+		@retval false The pose is late, so it is dropped.
+	*/
+	bool push(unsigned int timestamp_ms, const int angle_diffs[JointController::SUM]);
+
+	/*!
+		@brief Decide the pose is updatable
+
+		@return Result
+	*/
+	bool updatable();
+
+	/*!
+		@brief Apply the pose interpolated at the current time
+	*/
+	void update();
+
+	/*!
+		@brief Dump the stream state and metrics
+
+		Outputs result like JSON format below.
+		@code
+		{
+			"streaming": <integer>,
+			"depth_ms": <integer>,
+			"buffered": <integer>,
+			"received": <integer>,
+			"late": <integer>,
+			"overflows": <integer>,
+			"underruns": <integer>
+		}
+		@endcode
+	*/
+	void dump();
+
+private:
+	/*!
+		@brief Pose buffered
+	*/
+	class Pose
+	{
+	public:
+		unsigned long play_ms;                        //!< Time to play on millis().
+		short         angle_diffs[JointController::SUM]; //!< Angle-diffs. (Saves RAM, and covers the joints' range.)
+	};
+
+	/*!
+		@brief Get the pose buffered
+
+		@param [in] index Please set index from the oldest pose.
+
+		@return Reference of the pose
+	*/
+	Pose& m_pose(unsigned char index);
+
+	/*!
+		@brief Drop the oldest pose
+	*/
+	void m_pop();
+
+	JointController* m_joint_ctrl_ptr;
+
+	Pose          m_buffer[BUFFER_LENGTH];
+	unsigned char m_head;
+	unsigned char m_count;
+
+	bool          m_streaming;
+	bool          m_synchronized; //!< The offset is decided.
+	bool          m_holding;      //!< The last pose is held because the buffer ran out.
+	unsigned int  m_depth_ms;
+	unsigned long m_timestamp_last;
+	unsigned long m_offset_ms;
+
+	unsigned long m_received;
+	unsigned long m_late;
+	unsigned long m_overflows;
+	unsigned long m_underruns;
+};
+
+#endif // PLEN2_POSE_STREAM_H
@@ -6,6 +6,7 @@
 	This software is released under the MIT License.
 	(See also : http://opensource.org/licenses/mit-license.php)
 */
+#include <ctype.h>
 #include <Arduino.h>
 
 #include "Parser.h"
@@ -13,85 +14,164 @@
 
 #include "System.h"
 #include "Profiler.h"
+#include "Checksum.h"
 
 namespace
 {
 	namespace Shared
 	{
-		const char* CONTROLLER_SYMBOL[] = {
+		constexpr const char* CONTROLLER_SYMBOL[] = {
 			"AD", // APPLY DIFF
 			"AN", // APPLY NATIVE
+			"AP", // APPLY POSE
+			"BS", // BALANCE STABILIZER
+			"CL", // CALIBRATION
+			"FP", // FOOT POSE
 			"HP", // HOME POSITION
+			"JB", // JITTER BUFFER
 			"MP", // Alias of PLAY MOTION, @attention It will obsolescent in firmware version 2.x.
 			"MS", // Alias of STOP MOTION, @attention It will obsolescent in firmware version 2.x.
+			"PF", // PLAY MOTION WITH FLAGS
+			"PG", // PLAY GAIT
 			"PM", // PLAY MOTION
+			"PS", // POSE STREAM
+			"RT", // RETIMING
 			"SM"  // STOP MOTION
 		};
 		const unsigned char CONTROLLER_ARGS_STORE_LENGTH[] = {
 			5,    // APPLY DIFF
 			5,    // APPLY NATIVE
+			60,   // APPLY POSE
+			2,    // BALANCE STABILIZER
+			2,    // CALIBRATION
+			14,   // FOOT POSE
 			0,    // HOME POSITION
+			4,    // JITTER BUFFER
 			2,    // PLAY MOTION, @attention It will obsolescent in firmware version 2.x.
 			0,    // STOP MOTION, @attention It will obsolescent in firmware version 2.x.
+			4,    // PLAY MOTION WITH FLAGS
+			0,    // PLAY GAIT
 			2,    // PLAY MOTION
+			58,   // POSE STREAM
+			2,    // RETIMING
 			0     // STOP MOTION
 		};
+		const char* CONTROLLER_ARGS_FIELDS[] = {
+			"23",    // APPLY DIFF
+			"23",    // APPLY NATIVE
+			"222333333333333333333", // APPLY POSE
+			"2",     // BALANCE STABILIZER
+			"2",     // CALIBRATION
+			"23333", // FOOT POSE
+			"",      // HOME POSITION
+			"4",     // JITTER BUFFER
+			"2",     // PLAY MOTION, @attention It will obsolescent in firmware version 2.x.
+			"",      // STOP MOTION, @attention It will obsolescent in firmware version 2.x.
+			"22",    // PLAY MOTION WITH FLAGS
+			"",      // PLAY GAIT
+			"2",     // PLAY MOTION
+			"4333333333333333333", // POSE STREAM
+			"2",     // RETIMING
+			""       // STOP MOTION
+		};
 
 		enum { CONTROLLER_SYMBOL_LENGTH = sizeof(CONTROLLER_SYMBOL) / sizeof(CONTROLLER_SYMBOL[0]) };
-		Utility::StringGroupParser controller_parser(CONTROLLER_SYMBOL, CONTROLLER_SYMBOL_LENGTH);
 
 
-		const char* INTERPRETER_SYMBOL[] = {
+		constexpr const char* INTERPRETER_SYMBOL[] = {
+			"PF", // PUSH CODE WITH FLAGS
 			"PO", // POP CODE
 			"PU", // PUSH CODE
 			"RI"  // RESET INTERPRETER
 		};
 		const unsigned char INTERPRETER_ARGS_STORE_LENGTH[] = {
+			6,    // PUSH CODE WITH FLAGS
 			0,    // POP CODE
 			4,    // PUSH CODE
 			0     // RESET INTERPRETER
 		};
+		const char* INTERPRETER_ARGS_FIELDS[] = {
+			"222", // PUSH CODE WITH FLAGS
+			"",    // POP CODE
+			"22",  // PUSH CODE
+			""     // RESET INTERPRETER
+		};
 
 		enum { INTERPRETER_SYMBOL_LENGTH = sizeof(INTERPRETER_SYMBOL) / sizeof(INTERPRETER_SYMBOL[0]) };
-		Utility::StringGroupParser interpreter_parser(INTERPRETER_SYMBOL, INTERPRETER_SYMBOL_LENGTH);
 
 
-		const char* SETTER_SYMBOL[] = {
+		constexpr const char* SETTER_SYMBOL[] = {
+			"GP", // GAIT PARAMETERS
 			"HO", // HOME
-			"IN", // INSTALL MOTION, Sugar syntax MH and MF, @attention It will obsolescent in firmware version 2.x.
+			"IN", // INSTALL MOTION
 			"JS", // JOINT SETTINGS
+			"LI", // LIMITS
 			"MA", // MAX
 			"MF", // MOTION FRAME
 			"MH", // MOTION HEADER
 			"MI"  // MIN
 		};
 		const unsigned char SETTER_ARGS_STORE_LENGTH[] = {
+			13,   // GAIT PARAMETERS
 			5,    // HOME
-			0,    // INSTALL MOTION, Sugar syntax of MH and MF, @attention It will obsolescent in firmware version 2.x.
+			30,   // INSTALL MOTION, (It is the header, and the frames are continued by the handler.)
 			0,    // RESET JOINT SETTINGS
+			10,   // LIMITS
 			5,    // MAX
 			104,  // MOTION FRAME
 			30,   // MOTION HEADER
 			5     // MIN
 		};
+		const char* SETTER_ARGS_FIELDS[] = {
+			"3343",                  // GAIT PARAMETERS
+			"23",                    // HOME
+			NULL,                    // INSTALL MOTION, (Binary frames have no continued arguments.)
+			"",                      // RESET JOINT SETTINGS
+			"244",                   // LIMITS
+			"23",                    // MAX
+			"224444444444444444444", // MOTION FRAME, (Only the joints are carried, and the rest is zero.)
+			"*",                     // MOTION HEADER
+			"23"                     // MIN
+		};
 
 		enum { SETTER_SYMBOL_LENGTH = sizeof(SETTER_SYMBOL) / sizeof(SETTER_SYMBOL[0]) };
-		Utility::StringGroupParser setter_parser(SETTER_SYMBOL, SETTER_SYMBOL_LENGTH);
 
 
-		const char* GETTER_SYMBOL[] = {
+		constexpr const char* GETTER_SYMBOL[] = {
+			"BS", // BALANCE STABILIZER
+			"FS", // FILE SYSTEM
+			"GP", // GAIT PARAMETERS
 			"JS", // JOINT SETTINGS
+			"MD", // MOTION DIRECTORY
 			"MO", // MOTION
+			"PS", // POSE STREAM
+			"ST", // STORE
 			"VI"  // VERSION INFORMATION
 		};
 		const unsigned char GETTER_ARGS_STORE_LENGTH[] = {
+			0,    // BALANCE STABILIZER
+			0,    // FILE SYSTEM
+			0,    // GAIT PARAMETERS
 			0,    // JOINT SETTINGS
+			0,    // MOTION DIRECTORY
 			2,    // MOTION
+			0,    // POSE STREAM
+			0,    // STORE
 			0     // VERSION INFORMATION
 		};
+		const char* GETTER_ARGS_FIELDS[] = {
+			"",   // BALANCE STABILIZER
+			"",   // FILE SYSTEM
+			"",   // GAIT PARAMETERS
+			"",   // JOINT SETTINGS
+			"",   // MOTION DIRECTORY
+			"2",  // MOTION
+			"",   // POSE STREAM
+			"",   // STORE
+			""    // VERSION INFORMATION
+		};
 
 		enum { GETTER_SYMBOL_LENGTH = sizeof(GETTER_SYMBOL) / sizeof(GETTER_SYMBOL[0]) };
-		Utility::StringGroupParser getter_parser(GETTER_SYMBOL, GETTER_SYMBOL_LENGTH);
 
 
 		/*!
@@ -101,14 +181,8 @@ namespace
 			> : Setter      [Priority 2]
 			< : Getter      [Priority 3]
 		*/
-		Utility::CharGroupParser header_parser("$#><");
-
-		Utility::AbstractParser* command_parser[] = {
-			&controller_parser,
-			&interpreter_parser,
-			&setter_parser,
-			&getter_parser
-		};
+		const char HEADER_SYMBOL[] = "$#><";
+		Utility::CharGroupParser header_parser(HEADER_SYMBOL);
 
 		const unsigned char* ARGS_STORE_LENGTH[] = {
 			CONTROLLER_ARGS_STORE_LENGTH,
@@ -117,6 +191,160 @@ namespace
 			GETTER_ARGS_STORE_LENGTH
 		};
 
+		constexpr const char* const* SYMBOL[] = {
+			CONTROLLER_SYMBOL,
+			INTERPRETER_SYMBOL,
+			SETTER_SYMBOL,
+			GETTER_SYMBOL
+		};
+
+		constexpr unsigned char SYMBOL_LENGTH[] = {
+			CONTROLLER_SYMBOL_LENGTH,
+			INTERPRETER_SYMBOL_LENGTH,
+			SETTER_SYMBOL_LENGTH,
+			GETTER_SYMBOL_LENGTH
+		};
+
+
+		/*!
+			@note
+			Each character is hex digits of an argument field, and a binary frame carries a field
+			of 2 digits as a byte and the others as a little endian int16.
+			"*" means the arguments are carried as they are, and NULL means the command is not available.
+		*/
+		const char** ARGS_FIELDS[] = {
+			CONTROLLER_ARGS_FIELDS,
+			INTERPRETER_ARGS_FIELDS,
+			SETTER_ARGS_FIELDS,
+			GETTER_ARGS_FIELDS
+		};
+
+		enum { HEADER_LENGTH = sizeof(HEADER_SYMBOL) - 1 };
+
+
+		/*!
+			@note
+			A command is looked up by a perfect hash of the header index and the two characters,
+			so parsing a command costs one table access and one comparison.
+			The table is generated at compile time, and the build fails if two commands collide.
+			(Please retune HASH_HEADER and HASH_FIRST when adding a command makes it fail.)
+		*/
+		enum {
+			HASH_TABLE_SIZE = 128, //!< It must be 2^N.
+			HASH_HEADER     = 16,
+			HASH_FIRST      = 35,
+			HASH_EMPTY      = 0xFF //!< Value of the slots which have no command.
+		};
+
+		constexpr unsigned char command_hash(unsigned char header_id, char first, char second)
+		{
+			// "& 0x1F" ignores the case of the letters.
+			return (header_id * HASH_HEADER + (first & 0x1F) * HASH_FIRST + (second & 0x1F)) & (HASH_TABLE_SIZE - 1);
+		}
+
+		//! @brief Get command id, which is "header index << 5 | command index", hashed to the slot
+		constexpr unsigned char slot_command(unsigned char slot, unsigned char header_id = 0, unsigned char cmd_id = 0)
+		{
+			return (header_id == HEADER_LENGTH)? HASH_EMPTY
+				: (cmd_id == SYMBOL_LENGTH[header_id])? slot_command(slot, header_id + 1, 0)
+				: (command_hash(header_id, SYMBOL[header_id][cmd_id][0], SYMBOL[header_id][cmd_id][1]) == slot)? ((header_id << 5) | cmd_id)
+				: slot_command(slot, header_id, cmd_id + 1);
+		}
+
+		//! @brief Get count of the commands hashed to the slot
+		constexpr unsigned char slot_count(unsigned char slot, unsigned char header_id = 0, unsigned char cmd_id = 0)
+		{
+			return (header_id == HEADER_LENGTH)? 0
+				: (cmd_id == SYMBOL_LENGTH[header_id])? slot_count(slot, header_id + 1, 0)
+				: (command_hash(header_id, SYMBOL[header_id][cmd_id][0], SYMBOL[header_id][cmd_id][1]) == slot) + slot_count(slot, header_id, cmd_id + 1);
+		}
+
+		constexpr bool hash_is_perfect(unsigned char slot = 0)
+		{
+			return (slot == HASH_TABLE_SIZE) || ((slot_count(slot) <= 1) && hash_is_perfect(slot + 1));
+		}
+
+		static_assert(hash_is_perfect(), "Commands collide in the hash table. Please retune HASH_HEADER and HASH_FIRST.");
+
+		//! @brief Get whether the command index of every header fits the lower 5 bits of command id
+		constexpr bool symbols_fit_command_id(unsigned char header_id = 0)
+		{
+			return (header_id == HEADER_LENGTH) || ((SYMBOL_LENGTH[header_id] <= 32) && symbols_fit_command_id(header_id + 1));
+		}
+
+		static_assert(symbols_fit_command_id(), "A header has over 32 commands, which command id can't index.");
+
+		template <unsigned char... Slots>
+		struct CommandTable
+		{
+			static const unsigned char COMMAND[sizeof...(Slots)];
+		};
+
+		template <unsigned char... Slots>
+		const unsigned char CommandTable<Slots...>::COMMAND[sizeof...(Slots)] = { slot_command(Slots)... };
+
+		//! @brief Make CommandTable<0, 1, ..., N - 1>
+		template <unsigned char N, unsigned char... Slots>
+		struct MakeCommandTable : MakeCommandTable<N - 1, N - 1, Slots...> {};
+
+		template <unsigned char... Slots>
+		struct MakeCommandTable<0, Slots...>
+		{
+			typedef CommandTable<Slots...> Type;
+		};
+
+		typedef MakeCommandTable<HASH_TABLE_SIZE>::Type COMMAND_TABLE;
+
+
+		/*!
+			@brief Parser class that accepts only the commands of the header given
+
+			It is the replacement of Utility::StringGroupParser,
+			and has no case sensitivity on parsing like it.
+		*/
+		class CommandParser : public Utility::AbstractParser
+		{
+		private:
+			const unsigned char m_header_id;
+
+		public:
+			CommandParser(unsigned char header_id)
+				: m_header_id(header_id)
+			{
+				// noop.
+			}
+
+			virtual bool parse(const char* input)
+			{
+				const unsigned char command = COMMAND_TABLE::COMMAND[command_hash(m_header_id, input[0], input[1])];
+
+				// The hash is decided only by the lower 5 bits, so the characters themselves are compared also.
+				if (   ((command >> 5) == m_header_id)
+					&& (toupper(input[0]) == SYMBOL[m_header_id][command & 0x1F][0])
+					&& (toupper(input[1]) == SYMBOL[m_header_id][command & 0x1F][1])
+					&& (input[2] == '\0') )
+				{
+					m_index = command & 0x1F;
+					return true;
+				}
+
+				m_index = -1;
+				return false;
+			}
+		};
+
+		CommandParser controller_parser(0);
+		CommandParser interpreter_parser(1);
+		CommandParser setter_parser(2);
+		CommandParser getter_parser(3);
+
+		Utility::AbstractParser* command_parser[] = {
+			&controller_parser,
+			&interpreter_parser,
+			&setter_parser,
+			&getter_parser
+		};
+
 
 		/*!
 			@note
@@ -143,15 +371,261 @@ void PLEN2::Protocol::m_abort()
 
 	m_store_length    = 1;
 	m_state           = READY;
-	m_installing      = false;
+	m_binary          = false;
+	m_buffer.position = 0;
+
+	m_acknowledge(STATUS_NACK_SYNTAX);
+}
+
+
+void PLEN2::Protocol::m_acknowledge(unsigned char status)
+{
+	m_status = STATUS_ACK;
+
+	if (!m_sequenced)
+	{
+		return;
+	}
+
+	m_sequenced = false;
+
+	if (m_reply_ptr == NULL)
+	{
+		return;
+	}
+
+	const char HEX_DIGIT[] = "0123456789ABCDEF";
+
+	const unsigned long held   = m_unreplied + max(m_reply_ptr->available(), 0);
+	const unsigned char credit = (held < m_pipeline_limit)? (m_pipeline_limit - held) : 0;
+
+	// The reply is written at once, so it is sent as a packet on TCP.
+	const char reply[] = {
+		SEQUENCE_START,
+		HEX_DIGIT[m_sequence >> 4], HEX_DIGIT[m_sequence & 0xF],
+		HEX_DIGIT[status >> 4],     HEX_DIGIT[status & 0xF],
+		HEX_DIGIT[credit >> 4],     HEX_DIGIT[credit & 0xF],
+		'\r', '\n'
+	};
+
+	m_reply_ptr->write(reinterpret_cast<const uint8_t*>(reply), sizeof(reply));
+}
+
+
+void PLEN2::Protocol::m_setStatus(unsigned char status)
+{
+	m_status = status;
+}
+
+
+void PLEN2::Protocol::m_continueArguments(unsigned char store_length)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("Protocol::m_continueArguments()"));
+	#endif
+
+
+	if (   (store_length == 0)
+		|| (store_length >= Buffer::LENGTH) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> bad argment : store_length = "));
+			System::debugSerial().println(static_cast<int>(store_length));
+		#endif
+
+		return;
+	}
+
+	m_state           = ARGUMENTS_INCOMING;
+	m_store_length    = store_length;
 	m_buffer.position = 0;
+
+	m_continuation++;
+}
+
+
+bool PLEN2::Protocol::m_acceptBinary()
+{
+	if (   (m_frame[0] == 0)
+		|| (m_frame[0] > BINARY_PAYLOAD_MAX + 1) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> error : bad frame length = "));
+			System::debugSerial().println(static_cast<int>(m_frame[0]));
+		#endif
+
+		m_binary = false;
+
+		return false;
+	}
+
+	if (m_frame_position < m_frame[0] + 3 /* := length, CRC */)
+	{
+		return false;
+	}
+
+	m_binary = false;
+
+	return m_dispatchBinary();
+}
+
+
+bool PLEN2::Protocol::m_dispatchBinary()
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("Protocol::m_dispatchBinary()"));
+	#endif
+
+
+	const unsigned char  length       = m_frame[0];
+	const unsigned char  header_id    = m_frame[1] >> 5;
+	const unsigned char  cmd_id       = m_frame[1] & 0x1F;
+	const unsigned char* payload      = m_frame + 2;
+	const unsigned char  payload_size = length - 1;
+	const unsigned int   crc          = m_frame[length + 1] | (m_frame[length + 2] << 8);
+
+	if (Utility::crc16(m_frame, length + 1) != crc)
+	{
+		#if DEBUG
+			System::debugSerial().println(F(">>> error : bad frame CRC."));
+		#endif
+
+		return false;
+	}
+
+	if (   (header_id >= Shared::HEADER_LENGTH)
+		|| (cmd_id >= Shared::SYMBOL_LENGTH[header_id])
+		|| (Shared::ARGS_FIELDS[header_id][cmd_id] == NULL) )
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> error : bad command id = "));
+			System::debugSerial().println(static_cast<int>(m_frame[1]));
+		#endif
+
+		return false;
+	}
+
+	const char*         fields       = Shared::ARGS_FIELDS[header_id][cmd_id];
+	const unsigned char store_length = Shared::ARGS_STORE_LENGTH[header_id][cmd_id];
+	unsigned char       consumed     = 0;
+
+	if (fields[0] == '*')
+	{
+		memcpy(m_buffer.data, payload, min(payload_size, store_length));
+		m_buffer.data[store_length] = '\0';
+
+		consumed = store_length;
+	}
+	else
+	{
+		/*!
+			@note
+			The fields are neither converted to the text nor copied, and m_argUint() and m_argInt() read the payload directly.
+			Their positions depend only on the command, so they are kept for the frames of the same command in a row.
+		*/
+		if (m_frame[1] != m_arg_command)
+		{
+			unsigned char offset = 0;
+
+			m_arg_payload_size = 0;
+
+			for (; *fields != '\0'; fields++)
+			{
+				const unsigned char digits = *fields - '0';
+
+				m_arg_index[offset] = m_arg_payload_size;
+
+				m_arg_payload_size += (digits <= 2)? 1 : 2;
+				offset             += digits;
+			}
+
+			m_arg_command = m_frame[1];
+		}
+
+		consumed      = m_arg_payload_size;
+		m_binary_args = true;
+	}
+
+	if (consumed != payload_size)
+	{
+		#if DEBUG
+			System::debugSerial().print(F(">>> error : bad payload size = "));
+			System::debugSerial().println(static_cast<int>(payload_size));
+		#endif
+
+		m_binary_args = false;
+
+		return false;
+	}
+
+	// The indices are set as if the command was received as text, so the handlers dispatched by afterHook() are the same.
+	m_header_id = header_id;
+	m_cmd_id    = cmd_id;
+
+	m_state           = READY;
+	m_store_length    = 1;
+	m_buffer.position = 0;
+
+	beforeHook();
+	afterHook();
+
+	m_binary_args = false;
+
+	return true;
+}
+
+
+unsigned int PLEN2::Protocol::m_binaryField(unsigned char offset, unsigned char digits)
+{
+	const unsigned char* field = m_frame + 2 /* := length, command id */ + m_arg_index[offset];
+
+	return (digits <= 2)? field[0] : (field[0] | (field[1] << 8));
+}
+
+
+unsigned int PLEN2::Protocol::m_argUint(unsigned char offset, unsigned char digits)
+{
+	if (m_binary_args)
+	{
+		return m_binaryField(offset, digits) & ((1U << (digits * 4)) - 1);
+	}
+
+	return Utility::hexbytes2uint(m_buffer.data + offset, digits);
+}
+
+
+int PLEN2::Protocol::m_argInt(unsigned char offset, unsigned char digits)
+{
+	if (m_binary_args)
+	{
+		const unsigned char shift = (sizeof(int) * 2 - digits) * 4;
+
+		return static_cast<int>(m_binaryField(offset, digits) << shift) >> shift;
+	}
+
+	return Utility::hexbytes2int(m_buffer.data + offset, digits);
 }
 
 
 PLEN2::Protocol::Protocol()
 	: m_store_length(1)
 	, m_state(READY)
-	, m_installing(false)
+	, m_header_id(0)
+	, m_cmd_id(0)
+	, m_continuation(0)
+	, m_feed_budget_usec(FEED_BUDGET_USEC_DEFAULT)
+	, m_binary(false)
+	, m_frame_position(0)
+	, m_binary_args(false)
+	, m_arg_command(0xFF) // Command ids are under 0x80, so it matches no frame.
+	, m_arg_payload_size(0)
+	, m_reply_ptr(NULL)
+	, m_pipeline_limit(PIPELINE_LIMIT_DEFAULT)
+	, m_unreplied(0)
+	, m_sequenced(false)
+	, m_sequence(0)
+	, m_sequence_digits(0)
+	, m_status(STATUS_ACK)
 {
 	m_parser[HEADER_INCOMING]    = &Shared::header_parser;
 	m_parser[COMMAND_INCOMING]   = Shared::command_parser[0];
@@ -166,10 +640,188 @@ void PLEN2::Protocol::readByte(char byte)
 	#endif
 
 
-	m_buffer.data[m_buffer.position] = byte;
-	(++m_buffer.position) &= (Buffer::LENGTH - 1);
+	// The last byte is kept for the terminator.
+	if (m_buffer.position >= Buffer::LENGTH - 1)
+	{
+		m_abort();
+
+		return;
+	}
+
+	m_buffer.data[m_buffer.position++] = byte;
+	m_buffer.data[m_buffer.position]   = '\0';
+}
+
+
+unsigned int PLEN2::Protocol::feed(const char data[], unsigned int size)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("Protocol::feed()"));
+	#endif
+
+
+	unsigned int position = 0;
+	unsigned int commands = 0;
+
+	while (position < size)
+	{
+		m_unreplied = size - position;
+
+		if (m_binary)
+		{
+			// The length is read alone, and the rest of the frame is copied at once.
+			const unsigned int needs  = (m_frame_position == 0)? 1 : (m_frame[0] + 3U - m_frame_position);
+			const unsigned int length = min(size - position, needs);
+
+			memcpy(m_frame + m_frame_position, data + position, length);
+
+			position         += length;
+			m_frame_position += length;
+			m_unreplied      -= length;
+
+			if (m_acceptBinary())
+			{
+				commands++;
+
+				m_acknowledge(m_status);
+			}
+			else if (!m_binary)
+			{
+				m_acknowledge(STATUS_NACK_FRAME);
+			}
+
+			continue;
+		}
+
+		if (m_sequence_digits > 0)
+		{
+			if (isxdigit(data[position]))
+			{
+				m_sequence = (m_sequence << 4) | Utility::hexbytes2uint(data + position, 1);
+				position++;
+
+				m_sequenced = (--m_sequence_digits == 0);
+
+				continue;
+			}
+
+			// The broken sequence number is ignored, and the character is analysed as usual.
+			m_sequence_digits = 0;
+		}
+
+		if (   (m_state == READY)
+			&& (m_buffer.position == 0)
+			&& (data[position] == SEQUENCE_START) )
+		{
+			// The command sequenced before has not come.
+			m_acknowledge(STATUS_NACK_SYNTAX);
+
+			m_sequence        = 0;
+			m_sequence_digits = 2;
+			position++;
+
+			continue;
+		}
+
+		if (   (m_state == READY)
+			&& (m_buffer.position == 0)
+			&& (static_cast<unsigned char>(data[position]) == BINARY_START) )
+		{
+			m_binary         = true;
+			m_frame_position = 0;
+			position++;
+
+			continue;
+		}
+
+		/*!
+			@note
+			The arguments are copied at once up to the length the state needs.
+			(A handler can leave characters in the buffer, so the length is calculated each time.)
+		*/
+		const unsigned int needs  = (m_buffer.position < m_store_length)? (m_store_length - m_buffer.position) : 1;
+		const unsigned int length = min(size - position, min(needs, Buffer::LENGTH - 1U - m_buffer.position));
+
+		// The buffer is full, so the token can't be a command. (The character is analysed again from READY.)
+		if (length == 0)
+		{
+			m_abort();
+
+			continue;
+		}
+
+		memcpy(m_buffer.data + m_buffer.position, data + position, length);
+
+		position          += length;
+		m_buffer.position += length;
+		m_unreplied       -= length;
+
+		m_buffer.data[m_buffer.position] = '\0';
+
+		if (accept())
+		{
+			transitState();
+
+			if (m_state == READY)
+			{
+				commands++;
+
+				m_acknowledge(m_status);
+			}
+		}
+	}
+
+	m_unreplied = 0;
+
+	return commands;
+}
+
+
+unsigned int PLEN2::Protocol::feed(Stream& stream)
+{
+	#if DEBUG
+		volatile Utility::Profiler p(F("Protocol::feed(Stream&)"));
+	#endif
+
+
+	const unsigned long begin_usec = micros();
+
+	char         block[FEED_BLOCK_SIZE];
+	unsigned int commands = 0;
+
+	m_reply_ptr = &stream;
 
-	m_buffer.data[m_buffer.position] = '\0';
+	do
+	{
+		const int available = stream.available();
+
+		if (available <= 0)
+		{
+			break;
+		}
+
+		const unsigned int size = stream.readBytes(block, min(available, static_cast<int>(FEED_BLOCK_SIZE)));
+
+		commands += feed(block, size);
+	}
+	while (micros() - begin_usec < m_feed_budget_usec);
+
+	// The stream is not kept, so the commands given by feed() of characters are never replied to it.
+	m_reply_ptr = NULL;
+
+	return commands;
+}
+
+
+void PLEN2::Protocol::setFeedBudget(unsigned long usec)
+{
+	m_feed_budget_usec = usec;
+}
+
+
+void PLEN2::Protocol::setPipelineLimit(unsigned char bytes)
+{
+	m_pipeline_limit = bytes;
 }
 
 
@@ -210,7 +862,8 @@ void PLEN2::Protocol::transitState()
 		case HEADER_INCOMING:
 		{
 			m_state = COMMAND_INCOMING;
-			m_parser[COMMAND_INCOMING] = Shared::command_parser[m_parser[HEADER_INCOMING]->index()];
+			m_header_id = m_parser[HEADER_INCOMING]->index();
+			m_parser[COMMAND_INCOMING] = Shared::command_parser[m_header_id];
 			m_store_length = 2;
 
 			break;
@@ -218,29 +871,22 @@ void PLEN2::Protocol::transitState()
 
 		case COMMAND_INCOMING:
 		{
-			m_state = ARGUMENTS_INCOMING;
+			m_state        = ARGUMENTS_INCOMING;
+			m_continuation = 0;
+			m_cmd_id       = m_parser[COMMAND_INCOMING]->index();
 
 			// Partial specialization for a command
-			if (m_parser[HEADER_INCOMING]->index() == 2 /* := Setter */)
+			if (m_header_id == 2 /* := Setter */)
 			{
-				// If accepted INSTALL MOTION command, replace SET MOTION HEADER command.
-				if (m_parser[COMMAND_INCOMING]->index() == 1 /* := INSTALL MOTION */)
-				{
-					m_parser[COMMAND_INCOMING]->parse("MH");
-					m_installing = true;
-				}
-
-				// If accepted SET MOTION HEADER command, change to no-validation mode.
-				if (m_parser[COMMAND_INCOMING]->index() == 5 /* := MOTION HEADER */)
+				// If accepted INSTALL MOTION or SET MOTION HEADER command, change to no-validation mode.
+				if (   (m_cmd_id == 2 /* := INSTALL MOTION */)
+					|| (m_cmd_id == 7 /* := MOTION HEADER */) )
 				{
 					m_parser[ARGUMENTS_INCOMING] = &Shared::nil_parser;
 				}
 			}
 
-			unsigned char header_id = m_parser[HEADER_INCOMING]->index();
-			unsigned char cmd_id    = m_parser[COMMAND_INCOMING]->index();
-
-			m_store_length = Shared::ARGS_STORE_LENGTH[header_id][cmd_id];
+			m_store_length = Shared::ARGS_STORE_LENGTH[m_header_id][m_cmd_id];
 
 			// If satisfy the following condition, transit READY state because the command has no arguments.
 			if (m_store_length == 0)
@@ -11,6 +11,8 @@
 #define PLEN2_PROTOCOL_H
 
 
+class Stream;
+
 namespace PLEN2
 {
 	class Protocol;
@@ -28,6 +30,30 @@ namespace Utility
 	so should override the event handler(s) with inheriting the class yourself.
 
 	Please see the virtual methods to get more details.
+	<br><br>
+	feed() also accepts binary frames, which begin with BINARY_START, in place of the text.
+	The layout is below. (Integers are little endian.)
+	@code
+	BINARY_START, <length of command id and payload : 1 byte>, <command id : 1 byte>, <payload>,
+	<CRC-16 of length, command id and payload : 2 bytes>
+	@endcode
+	Command id is "header index << 5 | command index", where the indices are the ones of the text protocol.
+	Payload carries each argument field of the text protocol in the same order,
+	a field of 2 hex digits as a byte and the others as an int16.
+	(MOTION HEADER is carried as the text itself, and INSTALL MOTION is not available.)
+	<br><br>
+	A command given to feed() may be prefixed by SEQUENCE_START and 2 hex digits of a sequence number.
+	The command is sequenced, and its result is replied to the stream fed, which is the channel it came from.
+	@code
+	@<sequence : 2 hex digits><status : 2 hex digits><pipeline credit : 2 hex digits>\r\n
+	@endcode
+	Status is STATUS_ACK or one of STATUS_NACK_*.
+	Pipeline credit is the pipeline limit less the bytes which the channel holds unreplied when the reply is sent,
+	which are the rest of the block read and the bytes available on the stream.
+	So a host which sends at most the credit after the reply, and no more until the next one,
+	never overruns the channel while the firmware is busy, for example writing to the flash.
+	(The reply of INSTALL MOTION is sent after the last frame, because its frames are the arguments continued.)
+	The commands without the prefix are not replied as before.
 */
 class PLEN2::Protocol
 {
@@ -56,7 +82,7 @@ protected:
 
 				@attention
 				The value is required at least more than BLE payload length (= 20 bytes),
-				and it should be defined 2^N length for processing the class with high speed.
+				and more than the longest arguments. (A token which doesn't fit is aborted.)
 			*/
 			LENGTH = 128
 		};
@@ -80,15 +106,132 @@ protected:
 	Buffer m_buffer;
 	State m_state;
 	unsigned char m_store_length;
-	bool m_installing;
+	unsigned char m_header_id;    //!< Index of the header incoming.
+	unsigned char m_cmd_id;       //!< Index of the command incoming.
+	unsigned char m_continuation; //!< Count of the arguments continued by m_continueArguments().
+	/*!
+		@attention
+		The parsers are shared by the instances, so their indices are valid only until another instance parses.
+		Please use m_header_id and m_cmd_id in the hooks instead.
+	*/
 	Utility::AbstractParser* m_parser[STATE_EOE];
+	unsigned long m_feed_budget_usec;
+
+	bool          m_binary;
+	unsigned char m_frame[68 /* := BINARY_PAYLOAD_MAX + 4 */];
+	unsigned char m_frame_position;
+
+	bool          m_binary_args;               //!< The arguments are given by a binary frame.
+	unsigned char m_arg_index[Buffer::LENGTH]; //!< Payload position of each offset in the text arguments.
+	unsigned char m_arg_command;               //!< Command id of the binary frame that m_arg_index is made for.
+	unsigned char m_arg_payload_size;          //!< Payload size of the command.
+
+	Stream*       m_reply_ptr;        //!< Channel of the command incoming. (It is set only in feed() of a stream.)
+	unsigned char m_pipeline_limit;   //!< Bytes of the commands unreplied that the channel can hold.
+	unsigned int  m_unreplied;        //!< Bytes of the block fed which are not analysed yet.
+	bool          m_sequenced;        //!< The command incoming has a sequence number.
+	unsigned char m_sequence;
+	unsigned char m_sequence_digits;  //!< Count of the digits of the sequence number to receive.
+	unsigned char m_status;
 
 	/*!
 		@brief Abort analysis
 	*/
 	void m_abort();
 
+	/*!
+		@brief Reply the result of the command completed, if it is sequenced
+
+		The credit replied is m_pipeline_limit less m_unreplied and the bytes available on the channel.
+
+		@param [in] status Please set the status.
+	*/
+	void m_acknowledge(unsigned char status);
+
+	/*!
+		@brief Set the status replied for the command
+
+		The handlers should call it when they reject the arguments.
+
+		@param [in] status Please set one of STATUS_NACK_*.
+	*/
+	void m_setStatus(unsigned char status);
+
+	/*!
+		@brief Continue the command with another arguments
+
+		A handler calls it to receive a sequence of the arguments for the command, like INSTALL MOTION,
+		and is dispatched again for each of them with m_continuation incremented.
+		(The command is completed when the handler doesn't call it.)
+
+		@param [in] store_length Please set length of the next arguments.
+	*/
+	void m_continueArguments(unsigned char store_length);
+
+	/*!
+		@brief Accept the binary frame received so far
+
+		@return Result
+		@retval true A command was dispatched.
+	*/
+	bool m_acceptBinary();
+
+	/*!
+		@brief Dispatch the binary frame received to the same handler as the text
+
+		@return Result
+		@retval false The frame is broken.
+	*/
+	bool m_dispatchBinary();
+
+	/*!
+		@brief Get an argument as an unsigned integer
+
+		The handlers should use it instead of reading the buffer,
+		so the same handler serves both of the text and binary frames.
+
+		@param [in] offset Please set offset of the field in the text arguments.
+		@param [in] digits Please set hex digits of the field.
+
+		@return Value of the field
+	*/
+	unsigned int m_argUint(unsigned char offset, unsigned char digits);
+
+	/*!
+		@brief Get an argument as a signed integer
+
+		@param [in] offset Please set offset of the field in the text arguments.
+		@param [in] digits Please set hex digits of the field. (The field is two's complement of the digits.)
+
+		@return Value of the field
+	*/
+	int m_argInt(unsigned char offset, unsigned char digits);
+
+	//! @brief Get a field of the binary payload, as a byte or an int16 in little endian.
+	unsigned int m_binaryField(unsigned char offset, unsigned char digits);
+
 public:
+	enum {
+		FEED_BLOCK_SIZE          = 64,   //!< Size of a block read from a stream at once. (bytes)
+		FEED_BUDGET_USEC_DEFAULT = 2000, //!< Default time budget of feed() for a stream. (usec)
+
+		BINARY_START       = 0xA5, //!< Start byte of a binary frame.
+		BINARY_PAYLOAD_MAX = 64,   //!< Max payload size of a binary frame. (bytes)
+
+		SEQUENCE_START         = '@',           //!< Start character of a sequence number, and of a reply.
+		PIPELINE_LIMIT_DEFAULT = Buffer::LENGTH //!< Default pipeline limit. (bytes)
+	};
+
+	/*!
+		@brief List of the statuses replied
+	*/
+	enum {
+		STATUS_ACK           = 0x00, //!< The command was done.
+		STATUS_NACK_SYNTAX   = 0x01, //!< The header, command or arguments were rejected by the parsers.
+		STATUS_NACK_FRAME    = 0x02, //!< The binary frame was broken.
+		STATUS_NACK_REJECTED = 0x03  //!< The arguments were rejected by the handler.
+	};
+
 	/*!
 		@brief Constructor
 	*/
@@ -100,12 +243,57 @@ public:
 	virtual ~Protocol() {}
 
 	/*!
-		@brief Read a character, and store it in the ring buffer
+		@brief Read a character, and store it in the buffer
+
+		If the buffer is full, the analysis is aborted instead of wrapping the buffer around.
 
 		@param [in] byte A character.
 	*/
 	void readByte(char byte);
 
+	/*!
+		@brief Analyse a block of characters
+
+		The method is equivalent to readByte(), accept() and transitState() for each character,
+		but copies the characters which a token still needs at once.
+		A token split between blocks is continued by the next call.
+
+		@param [in] data Please set the characters.
+		@param [in] size Please set count of the characters.
+
+		@return Count of the commands completed.
+	*/
+	unsigned int feed(const char data[], unsigned int size);
+
+	/*!
+		@brief Analyse the characters available on a stream
+
+		Reads the stream by blocks until it has no character or the time budget runs out,
+		so a whole command is analysed in one iteration of the main loop.
+
+		@param [in] stream Please set the stream to read.
+
+		@return Count of the commands completed.
+	*/
+	unsigned int feed(Stream& stream);
+
+	/*!
+		@brief Set the time budget of feed() for a stream
+
+		@param [in] usec Please set the budget. (usec)
+	*/
+	void setFeedBudget(unsigned long usec);
+
+	/*!
+		@brief Set the pipeline limit which the credits replied to the host are taken from
+
+		It should be at most the size of the receive buffer of the channel,
+		because the channel holds the commands pipelined while the firmware is busy.
+
+		@param [in] bytes Please set the limit. (bytes)
+	*/
+	void setPipelineLimit(unsigned char bytes);
+
 	/*!
 		@brief Accept buffered string considering internal state
 
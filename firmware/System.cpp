@@ -18,7 +18,9 @@
 #include "Pin.h"
 #include "System.h"
 #include "ExternalFs.h"
+#include "MotionPack.h"
 #include "Profiler.h"
+#include <StreamString.h>
 #if BLE_SERIAL
 	#include <SoftwareSerial.h>
 	SoftwareSerial BLESerial(PLEN2::Pin::BLE_RX(), PLEN2::Pin::BLE_TX()); // RX, TX
@@ -39,6 +41,16 @@ static bool servers_started = false;
 
 WiFiServer tcp_server(23);
 WiFiClient serverClient;
+
+#define PACK_TIMEOUT_MS 2000
+WiFiServer pack_server(24);
+WiFiClient pack_client;
+int pack_mode = 0; // 'E' or 'I' after the client sends it.
+unsigned long pack_last_msec = 0;
+bool pack_upload_refused = false;
+bool motion_playing = false;
+// A pack is refused while a motion is playing (only imports), or while another pack is transferred over TCP.
+const char* PACK_BUSY_JSON = "{\n\t\"result\": false,\n\t\"reason\": \"busy\"\n}\n";
 Ticker smartconfig_tricker;
 
 String robot_name = "JRobot-" + String(ESP.getChipId());
@@ -214,6 +226,7 @@ void handleFileUpload(){
   } else if(upload.status == UPLOAD_FILE_END){
     if(fsUploadFile)
       fsUploadFile.close();
+    PLEN2::ExternalFs::invalidate();
     PLEN2_SYSTEM_SERIAL.print("handleFileUpload Size: "); PLEN2_SYSTEM_SERIAL.println(upload.totalSize);
   }
 }
@@ -274,6 +287,112 @@ void handleFileList() {
   httpServer.send(200, "text/json", output);
 }
 
+void handleMotionExport(){
+  if(pack_mode != 0){
+    httpServer.send(409, "text/json", PACK_BUSY_JSON);
+    return;
+  }
+  unsigned char buffer[PLEN2::MotionPack::CHUNK_SIZE];
+  unsigned int length;
+  httpServer.setContentLength(PLEN2::MotionPack::beginExport());
+  httpServer.send(200, "application/octet-stream", "");
+  WiFiClient client = httpServer.client();
+  while((length = PLEN2::MotionPack::readChunk(buffer, sizeof(buffer))) > 0)
+    client.write(buffer, length);
+  PLEN2::MotionPack::end();
+  PLEN2::MotionPack::dump(PLEN2_SYSTEM_SERIAL);
+}
+
+void handleMotionImportResult(){
+  if(pack_upload_refused){
+    httpServer.send(409, "text/json", PACK_BUSY_JSON);
+    return;
+  }
+  StreamString json;
+  PLEN2::MotionPack::dump(json);
+  httpServer.send(PLEN2::MotionPack::importFinished() ? 200 : 400, "text/json", json);
+}
+
+void handleMotionImport(){
+  if(httpServer.uri() != "/motions") return;
+  HTTPUpload& upload = httpServer.upload();
+  if(upload.status == UPLOAD_FILE_START){
+    // A motion playing might be rewritten, so the import is refused.
+    pack_upload_refused = motion_playing || (pack_mode != 0);
+    if(!pack_upload_refused) PLEN2::MotionPack::beginImport();
+  } else if(pack_upload_refused){
+    return;
+  } else if(upload.status == UPLOAD_FILE_WRITE){
+    PLEN2::MotionPack::writeChunk(upload.buf, upload.currentSize);
+  } else if(upload.status == UPLOAD_FILE_END || upload.status == UPLOAD_FILE_ABORTED){
+    PLEN2::MotionPack::end();
+    PLEN2::MotionPack::dump(PLEN2_SYSTEM_SERIAL);
+  }
+}
+
+void finishPackClient(){
+  PLEN2::MotionPack::end();
+  if(pack_mode == 'I') PLEN2::MotionPack::dump(pack_client);
+  PLEN2::MotionPack::dump(PLEN2_SYSTEM_SERIAL);
+  pack_client.stop();
+  pack_mode = 0;
+}
+
+/*!
+  @brief Transfer a motion pack over TCP
+
+  A client sends 'E' to receive the pack of the installed motions,
+  or sends 'I' followed by a pack to install it, and receives the result.
+  A chunk is transferred for each call, so the main loop is never blocked by a transfer.
+  An import is refused while a motion is playing.
+*/
+void handlePackClient(){
+  if(!pack_client){
+    if(!pack_server.hasClient()) return;
+    pack_client = pack_server.available();
+    pack_mode = 0;
+    pack_last_msec = millis();
+  }
+  const bool timeout = (millis() - pack_last_msec >= PACK_TIMEOUT_MS);
+  if(pack_mode == 0){
+    if(!pack_client.available()){
+      if(timeout || !pack_client.connected()) pack_client.stop();
+      return;
+    }
+    pack_mode = pack_client.read();
+    pack_last_msec = millis();
+    if(pack_mode == 'E'){
+      PLEN2::MotionPack::beginExport();
+    } else if((pack_mode == 'I') && !motion_playing){
+      PLEN2::MotionPack::beginImport();
+    } else {
+      if(pack_mode == 'I') pack_client.print(PACK_BUSY_JSON);
+      pack_client.stop();
+      pack_mode = 0;
+    }
+    return;
+  }
+  unsigned char buffer[PLEN2::MotionPack::CHUNK_SIZE];
+  if(pack_mode == 'E'){
+    unsigned int length = pack_client.connected() ? PLEN2::MotionPack::readChunk(buffer, sizeof(buffer)) : 0;
+    if(length == 0){
+      finishPackClient();
+      return;
+    }
+    pack_client.write(buffer, length);
+    return;
+  }
+  if(pack_client.available()){
+    int length = pack_client.read(buffer, sizeof(buffer));
+    if(length > 0){
+      pack_last_msec = millis();
+      if(!PLEN2::MotionPack::writeChunk(buffer, length) || PLEN2::MotionPack::importFinished()) finishPackClient();
+    }
+  } else if(timeout || !pack_client.connected()){
+    finishPackClient();
+  }
+}
+
 void PLEN2::System::smart_config()
 {
 	static int cnt = 0;
@@ -296,6 +415,9 @@ void PLEN2::System::smart_config()
             //first callback is called after the request has ended with all parsed arguments
             //second callback handles file uploads at that location
             httpServer.on("/edit", HTTP_POST, [](){ httpServer.send(200, "text/plain", ""); }, handleFileUpload);
+            //download or upload the installed motions as a binary motion pack
+            httpServer.on("/motions", HTTP_GET, handleMotionExport);
+            httpServer.on("/motions", HTTP_POST, handleMotionImportResult, handleMotionImport);
 
             //called when the url is not defined here
             //use it to load content from SPIFFS
@@ -320,6 +442,7 @@ void PLEN2::System::smart_config()
             outputSerial().println("HTTPUpdateServer ready! Open http://192.168.4.1/update in your browser\n");
             tcp_server.begin();  
 	        tcp_server.setNoDelay(true);
+            pack_server.begin();
 		}
 	  udp.beginPacketMulticast(broadcastIp, BROADCAST_PORT, WiFi.localIP());
 		udp.write(robot_name.c_str(), robot_name.length());
@@ -340,6 +463,7 @@ void PLEN2::System::smart_config()
 			fp_syscfg.println(WiFi.psk().c_str());
 			fp_syscfg.close();
 			fp_syscfg = SPIFFS.open(SYSCFG_FILE, "r");
+			ExternalFs::invalidate();
 		}
 		update_cfg = false;
 	}
@@ -353,11 +477,14 @@ void PLEN2::System::smart_config()
 }
 
 
-void PLEN2::System::handleClient()
+void PLEN2::System::handleClient(bool playing)
 {
+	motion_playing = playing;
+
 	if (servers_started)
 	{
 	    httpServer.handleClient();
+	    handlePackClient();
 	}
 }
 
@@ -392,6 +519,11 @@ char PLEN2::System::tcp_read()
     return serverClient.read();
 }
 
+Stream& PLEN2::System::tcpClient()
+{
+    return serverClient;
+}
+
 Stream& PLEN2::System::BLESerial()
 {
 	return PLEN2_SYSTEM_SERIAL;
@@ -98,6 +98,14 @@ public:
 
     static char tcp_read();
 
+	/*!
+		@brief Get the stream of the TCP client connected
+
+		@attention
+		Please call it after tcp_available() returns true.
+	*/
+	static Stream& tcpClient();
+
     static bool tcp_connected();
 
 	static void setup_smartconfig();
@@ -108,7 +116,12 @@ public:
 	
 	static void dump();
 
-    static void handleClient();
+	/*!
+		@brief Serve the clients of HTTP and of the motion pack
+
+		@param [in] playing Please set whether a motion is playing. The motion packs are not imported while it is true.
+	*/
+    static void handleClient(bool playing);
 };
 
 #endif // PLEN2_SYSTEM_H
@@ -0,0 +1,215 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <stdlib.h>
+
+#include "Trigonometry.h"
+
+
+namespace
+{
+	namespace Shared
+	{
+		enum {
+			TABLE_BITS   = 6,
+			TABLE_LENGTH = (1 << TABLE_BITS) + 1,
+			QUARTER      = 0x4000,
+			FRACTION     = 14 - TABLE_BITS
+		};
+
+		//! @brief sin(0) - sin(90[deg]) with 64 divisions, in Q15.
+		PROGMEM const short SIN_TABLE[TABLE_LENGTH] = {
+			    0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+			 6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+			12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+			18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+			23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+			27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+			30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+			32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+			32767
+		};
+
+		int quarter_sin(unsigned int angle)
+		{
+			unsigned int index    = angle >> FRACTION;
+			unsigned int fraction = angle & ((1 << FRACTION) - 1);
+
+			int base = static_cast<short>(pgm_read_word(&SIN_TABLE[index]));
+
+			if (fraction == 0)
+			{
+				return base;
+			}
+
+			int next = static_cast<short>(pgm_read_word(&SIN_TABLE[index + 1]));
+
+			return base + (((next - base) * static_cast<int>(fraction)) >> FRACTION);
+		}
+
+
+		enum {
+			CORDIC_ITERATIONS = 14,
+			CORDIC_NORMALIZED = 0x100000
+		};
+
+		//! @brief atan(2^-i) expressed by binary angle.
+		PROGMEM const short ATAN_TABLE[CORDIC_ITERATIONS] = {
+			8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1
+		};
+	}
+}
+
+
+namespace Utility
+{
+
+/*!
+	@brief Get sine of a binary angle
+*/
+int sin_q15(unsigned int angle)
+{
+	angle &= (BINARY_ANGLE_1 - 1);
+
+	unsigned int in_quarter = angle & (Shared::QUARTER - 1);
+
+	switch (angle / Shared::QUARTER)
+	{
+		case 0:  return  Shared::quarter_sin(in_quarter);
+		case 1:  return  Shared::quarter_sin(Shared::QUARTER - in_quarter);
+		case 2:  return -Shared::quarter_sin(in_quarter);
+		default: return -Shared::quarter_sin(Shared::QUARTER - in_quarter);
+	}
+}
+
+
+/*!
+	@brief Get cosine of a binary angle
+*/
+int cos_q15(unsigned int angle)
+{
+	return sin_q15(angle + Shared::QUARTER);
+}
+
+
+/*!
+	@brief Get arc tangent of y/x
+*/
+int atan2_binary(long y, long x)
+{
+	if ((x == 0) && (y == 0))
+	{
+		return 0;
+	}
+
+	int angle = 0;
+
+	// Rotate the vector to the right half plane.
+	if (x < 0)
+	{
+		long temp = x;
+
+		if (y >= 0)
+		{
+			x     =  y;
+			y     = -temp;
+			angle =  Shared::QUARTER;
+		}
+		else
+		{
+			x     = -y;
+			y     =  temp;
+			angle = -Shared::QUARTER;
+		}
+	}
+
+	// Scale up the vector to keep precision of the shifts.
+	while ((labs(x) | labs(y)) < Shared::CORDIC_NORMALIZED)
+	{
+		x <<= 1;
+		y <<= 1;
+	}
+
+	for (char index = 0; index < Shared::CORDIC_ITERATIONS; index++)
+	{
+		long x_shifted = x >> index;
+		long y_shifted = y >> index;
+
+		if (y > 0)
+		{
+			x     += y_shifted;
+			y     -= x_shifted;
+			angle += static_cast<short>(pgm_read_word(&Shared::ATAN_TABLE[index]));
+		}
+		else
+		{
+			x     -= y_shifted;
+			y     += x_shifted;
+			angle -= static_cast<short>(pgm_read_word(&Shared::ATAN_TABLE[index]));
+		}
+	}
+
+	return angle;
+}
+
+
+/*!
+	@brief Get integer square root
+*/
+unsigned long isqrt(unsigned long value)
+{
+	unsigned long result = 0;
+	unsigned long bit    = 1UL << (sizeof(unsigned long) * 8 - 2);
+
+	while (bit > value)
+	{
+		bit >>= 2;
+	}
+
+	while (bit != 0)
+	{
+		if (value >= result + bit)
+		{
+			value  -= result + bit;
+			result  = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return result;
+}
+
+
+/*!
+	@brief Convert a signed binary angle to an angle that has steps of degree 1/10
+*/
+int binary_to_deg10(int angle)
+{
+	long scaled = static_cast<long>(angle) * 3600;
+
+	return static_cast<int>((scaled + ((scaled >= 0)? 0x8000 : -0x8000)) / BINARY_ANGLE_1);
+}
+
+
+/*!
+	@brief Convert an angle that has steps of degree 1/10 to a binary angle
+*/
+unsigned int deg10_to_binary(int angle)
+{
+	long scaled = (static_cast<long>(angle) * BINARY_ANGLE_1) / 3600;
+
+	return static_cast<unsigned int>(scaled) & (BINARY_ANGLE_1 - 1);
+}
+
+} // end of namespace "Utility".
@@ -0,0 +1,86 @@
+/*!
+	@file      Trigonometry.h
+	@brief     Provide fixed-point trigonometric utilities.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef UTILITY_TRIGONOMETRY_H
+#define UTILITY_TRIGONOMETRY_H
+
+
+namespace Utility
+{
+	enum {
+		Q15_ONE        = 32767,  //!< Value of 1.0 expressed by Q15 fixed-point.
+		BINARY_ANGLE_1 = 0x10000 //!< One revolution expressed by binary angle.
+	};
+
+	/*!
+		@brief Get sine of a binary angle
+
+		@param [in] angle Binary angle. (0x0000 - 0xFFFF is mapped to 0 - 360[deg].)
+
+		@return Sine value expressed by Q15 fixed-point.
+
+		@note
+		The method uses a quarter-wave table with linear interpolation,
+		so the error is less than 5/32767.
+	*/
+	int sin_q15(unsigned int angle);
+
+	/*!
+		@brief Get cosine of a binary angle
+
+		@param [in] angle Binary angle. (0x0000 - 0xFFFF is mapped to 0 - 360[deg].)
+
+		@return Cosine value expressed by Q15 fixed-point.
+	*/
+	int cos_q15(unsigned int angle);
+
+	/*!
+		@brief Get arc tangent of y/x
+
+		The method runs CORDIC in vectoring mode, so there is no division and no floating-point.
+
+		@param [in] y Y coordinate.
+		@param [in] x X coordinate.
+
+		@return Signed binary angle. (-0x8000 - 0x7FFF is mapped to -180 - 180[deg].)
+
+		@attention
+		Absolute values of the arguments should be less than 0x10000000.
+	*/
+	int atan2_binary(long y, long x);
+
+	/*!
+		@brief Get integer square root
+
+		@param [in] value Value you want to get the square root.
+
+		@return floor(sqrt(value))
+	*/
+	unsigned long isqrt(unsigned long value);
+
+	/*!
+		@brief Convert a signed binary angle to an angle that has steps of degree 1/10
+
+		@param [in] angle Signed binary angle.
+
+		@return Angle that has steps of degree 1/10.
+	*/
+	int binary_to_deg10(int angle);
+
+	/*!
+		@brief Convert an angle that has steps of degree 1/10 to a binary angle
+
+		@param [in] angle Angle that has steps of degree 1/10.
+
+		@return Binary angle.
+	*/
+	unsigned int deg10_to_binary(int angle);
+}
+
+#endif // UTILITY_TRIGONOMETRY_H
@@ -14,6 +14,8 @@
 #include "JointController.h"
 #include "Motion.h"
 #include "MotionController.h"
+#include "GaitGenerator.h"
+#include "LegKinematics.h"
 #include "Interpreter.h"
 #include "Pin.h"
 #include "Parser.h"
@@ -21,9 +23,14 @@
 #include "System.h"
 #include "Profiler.h"
 #include "ExternalFs.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+#include "PoseStream.h"
 
 #if MPU_6050
 	#include "AccelerationGyroSensor.h"
+	#include "BalanceStabilizer.h"
 	#include "Soul.h"
 #endif
 
@@ -37,9 +44,12 @@ namespace
 	JointController  joint_ctrl;
 	MotionController motion_ctrl(joint_ctrl);
 	Interpreter      interpreter(motion_ctrl);
+	GaitGenerator    gait;
+	PoseStream       pose_stream(joint_ctrl);
 
 	#if MPU_6050
 		AccelerationGyroSensor gyroSensor;
+		BalanceStabilizer      stabilizer(gyroSensor);
 		Soul                   soul(gyroSensor, motion_ctrl);
 	#endif
 
@@ -56,6 +66,10 @@ namespace
 
 		static void (Application::**EVENT_HANDLER[])();
 
+		enum {
+			INSTALL_FRAME_LENGTH = 100 //!< Length of a frame of INSTALL MOTION. (MOTION FRAME without the slot and the frame index.)
+		};
+
 		Motion::Header    m_header_tmp;
 		Motion::Frame     m_frame_tmp;
 		Interpreter::Code m_code_tmp;
@@ -66,16 +80,16 @@ namespace
 				volatile Utility::Profiler p(F("Application::applyDiff()"));
 
 				System::debugSerial().print(F(">>> joint_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> angle_diff : "));
-				System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 2, 3));
+				System::debugSerial().println(m_argInt(2, 3));
 			#endif
 
-			joint_ctrl.setAngleDiff(
-				Utility::hexbytes2uint(m_buffer.data, 2),
-				Utility::hexbytes2int(m_buffer.data + 2, 3)
-			);
+			if (!joint_ctrl.setAngleDiff(m_argUint(0, 2), m_argInt(2, 3)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
 		}
 
 		void apply()
@@ -84,16 +98,141 @@ namespace
 				volatile Utility::Profiler p(F("Application::apply()"));
             
 				System::debugSerial().print(F(">>> joint_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> angle : "));
-				System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 2, 3));
+				System::debugSerial().println(m_argInt(2, 3));
 			#endif
 
-			joint_ctrl.setAngle(
-				Utility::hexbytes2uint(m_buffer.data, 2),
-				Utility::hexbytes2int(m_buffer.data + 2, 3)
-			);
+			if (!joint_ctrl.setAngle(m_argUint(0, 2), m_argInt(2, 3)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		/*!
+			@brief Apply angle-diffs of all the joints at once
+
+			The arguments are a 6 digits joint mask, whose bit N is joint id N,
+			and the angle-diffs of joint id 0 to SUM - 1. (The angle-diffs of the joints masked out are ignored.)
+		*/
+		void applyPose()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::applyPose()"));
+			#endif
+
+			const unsigned long mask =
+				  (static_cast<unsigned long>(m_argUint(0, 2)) << 16)
+				| (static_cast<unsigned long>(m_argUint(2, 2)) << 8)
+				|  static_cast<unsigned long>(m_argUint(4, 2));
+
+			int angle_diffs[JointController::SUM];
+
+			for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+			{
+				angle_diffs[joint_id] = m_argInt(6 + joint_id * 3, 3);
+			}
+
+			#if DEBUG_LESS
+				System::debugSerial().print(F(">>> mask : "));
+				System::debugSerial().println(mask, HEX);
+			#endif
+
+			if (!joint_ctrl.setAnglesDiff(angle_diffs, mask))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		void balanceStabilizer()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::balanceStabilizer()"));
+
+				System::debugSerial().print(F(">>> enabled : "));
+				System::debugSerial().println(m_argUint(0, 2));
+			#endif
+
+			#if MPU_6050
+				stabilizer.enable(m_argUint(0, 2) != 0);
+			#endif
+		}
+
+		/*!
+			@brief Control the calibration transaction
+
+			The argument means 0 : abort, 1 : begin, 2 : commit.
+		*/
+		void calibration()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::calibration()"));
+
+				System::debugSerial().print(F(">>> operation : "));
+				System::debugSerial().println(m_argUint(0, 2));
+			#endif
+
+			switch (m_argUint(0, 2))
+			{
+				case 0:
+				{
+					joint_ctrl.abortCalibration();
+
+					break;
+				}
+
+				case 1:
+				{
+					joint_ctrl.beginCalibration();
+
+					break;
+				}
+
+				case 2:
+				{
+					if (!joint_ctrl.commitCalibration())
+					{
+						m_setStatus(STATUS_NACK_REJECTED);
+					}
+
+					break;
+				}
+			}
+		}
+
+		void applyFootPose()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::applyFootPose()"));
+
+				System::debugSerial().print(F(">>> leg : "));
+				System::debugSerial().println(m_argUint(0, 2));
+
+				System::debugSerial().print(F(">>> x : "));
+				System::debugSerial().println(m_argInt(2, 3));
+
+				System::debugSerial().print(F(">>> y : "));
+				System::debugSerial().println(m_argInt(5, 3));
+
+				System::debugSerial().print(F(">>> z : "));
+				System::debugSerial().println(m_argInt(8, 3));
+
+				System::debugSerial().print(F(">>> yaw : "));
+				System::debugSerial().println(m_argInt(11, 3));
+			#endif
+
+			LegKinematics::FootPose pose;
+
+			pose.x   = m_argInt(2, 3);
+			pose.y   = m_argInt(5, 3);
+			pose.z   = m_argInt(8, 3);
+			pose.yaw = m_argInt(11, 3);
+
+			if (!LegKinematics::apply(joint_ctrl, m_argUint(0, 2), pose))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
 		}
 
 		void homePosition()
@@ -102,21 +241,124 @@ namespace
 				volatile Utility::Profiler p(F("Application::homePosition()"));
 			#endif
 
+			pose_stream.end();
+
+			// Reloading the settings drops the ones edited under calibration, so the joints only go home.
+			if (joint_ctrl.calibrating())
+			{
+				for (char joint_id = 0; joint_id < JointController::SUM; joint_id++)
+				{
+					joint_ctrl.setAngle(joint_id, joint_ctrl.getHomeAngle(joint_id));
+				}
+
+				return;
+			}
+
 			joint_ctrl.loadSettings();
 		}
 
+		/*!
+			@brief Set the buffer depth of the pose stream, and begin streaming
+
+			The argument is the depth in milliseconds, and 0 ends streaming.
+		*/
+		void setJitterBuffer()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::setJitterBuffer()"));
+
+				System::debugSerial().print(F(">>> depth_ms : "));
+				System::debugSerial().println(m_argUint(0, 4));
+			#endif
+
+			if (m_argUint(0, 4) == 0)
+			{
+				pose_stream.end();
+			}
+			else if (!pose_stream.begin(m_argUint(0, 4)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
 		void playMotion()
 		{
 			#if DEBUG_LESS
 				volatile Utility::Profiler p(F("Application::playMotion()"));
 
 				System::debugSerial().print(F(">>> slot : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 			#endif
 
-			motion_ctrl.play(
-				Utility::hexbytes2uint(m_buffer.data, 2)
-			);
+			if (!motion_ctrl.play(m_argUint(0, 2)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		void playMotionWithFlags()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::playMotionWithFlags()"));
+
+				System::debugSerial().print(F(">>> slot : "));
+				System::debugSerial().println(m_argUint(0, 2));
+
+				System::debugSerial().print(F(">>> flags : "));
+				System::debugSerial().println(m_argUint(2, 2));
+			#endif
+
+			if (!motion_ctrl.play(m_argUint(0, 2), m_argUint(2, 2)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		void playGait()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::playGait()"));
+			#endif
+
+			motion_ctrl.play(gait);
+		}
+
+		/*!
+			@brief Push a pose to the pose stream
+
+			The arguments are a 4 digits timestamp in milliseconds of the host,
+			and the angle-diffs of joint id 0 to SUM - 1.
+		*/
+		void streamPose()
+		{
+			#if DEBUG_HARD
+				volatile Utility::Profiler p(F("Application::streamPose()"));
+			#endif
+
+			int angle_diffs[JointController::SUM];
+
+			for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+			{
+				angle_diffs[joint_id] = m_argInt(4 + joint_id * 3, 3);
+			}
+
+			// A late pose is replied, so the host can learn the depth is short.
+			if (!pose_stream.push(m_argUint(0, 4), angle_diffs))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		void setRetiming()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::setRetiming()"));
+
+				System::debugSerial().print(F(">>> enabled : "));
+				System::debugSerial().println(m_argUint(0, 2));
+			#endif
+
+			motion_ctrl.setRetiming(m_argUint(0, 2) != 0);
 		}
 
 		void stopMotion()
@@ -143,14 +385,37 @@ namespace
 				volatile Utility::Profiler p(F("Application::pushCode()"));
 
 				System::debugSerial().print(F(">>> slot : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
+
+				System::debugSerial().print(F(">>> loop_count : "));
+				System::debugSerial().println(m_argUint(2, 2));
+			#endif
+
+			m_code_tmp.slot       = m_argUint(0, 2);
+			m_code_tmp.loop_count = m_argUint(2, 2) - 1;
+			m_code_tmp.flags      = 0;
+
+			interpreter.pushCode(m_code_tmp);
+		}
+
+		void pushCodeWithFlags()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::pushCodeWithFlags()"));
+
+				System::debugSerial().print(F(">>> slot : "));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> loop_count : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 2, 2));
+				System::debugSerial().println(m_argUint(2, 2));
+
+				System::debugSerial().print(F(">>> flags : "));
+				System::debugSerial().println(m_argUint(4, 2));
 			#endif
 
-			m_code_tmp.slot       = Utility::hexbytes2uint(m_buffer.data, 2);
-			m_code_tmp.loop_count = Utility::hexbytes2uint(m_buffer.data + 2, 2) - 1;
+			m_code_tmp.slot       = m_argUint(0, 2);
+			m_code_tmp.loop_count = m_argUint(2, 2) - 1;
+			m_code_tmp.flags      = m_argUint(4, 2);
 
 			interpreter.pushCode(m_code_tmp);
 		}
@@ -164,22 +429,119 @@ namespace
 			interpreter.reset();
 		}
 
+		void setGaitParameters()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::setGaitParameters()"));
+
+				System::debugSerial().print(F(">>> step_length : "));
+				System::debugSerial().println(m_argInt(0, 3));
+
+				System::debugSerial().print(F(">>> height : "));
+				System::debugSerial().println(m_argInt(3, 3));
+
+				System::debugSerial().print(F(">>> period_ms : "));
+				System::debugSerial().println(m_argUint(6, 4));
+
+				System::debugSerial().print(F(">>> turn_rate : "));
+				System::debugSerial().println(m_argInt(10, 3));
+			#endif
+
+			GaitGenerator::Parameters params;
+
+			params.step_length = m_argInt(0, 3);
+			params.height      = m_argInt(3, 3);
+			params.period_ms   = m_argUint(6, 4);
+			params.turn_rate   = m_argInt(10, 3);
+
+			if (!gait.setParameters(params))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
 		void setHome()
 		{
 			#if DEBUG_LESS
 				volatile Utility::Profiler p(F("Application::setHome()"));
 
 				System::debugSerial().print(F(">>> joint_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> angle : "));
-				System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 2, 3));
+				System::debugSerial().println(m_argInt(2, 3));
 			#endif
 
-			joint_ctrl.setHomeAngle(
-				Utility::hexbytes2uint(m_buffer.data, 2),
-				Utility::hexbytes2int(m_buffer.data + 2, 3)
-			);
+			if (!joint_ctrl.setHomeAngle(m_argUint(0, 2), m_argInt(2, 3)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		/*!
+			@brief Install a motion at once
+
+			The arguments are the ones of MOTION HEADER, and are continued by the frames.
+			Each frame is the arguments of MOTION FRAME without the slot and the frame index.
+			The motion is staged, and is written by a transaction when the last frame is received.
+		The stage is shared by the channels, so the install is rejected while another channel is installing.
+		*/
+		void installMotion()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::installMotion()"));
+			#endif
+
+			if (m_continuation == 0)
+			{
+				if (!parseMotionHeader())
+				{
+					m_setStatus(STATUS_NACK_SYNTAX);
+
+					return;
+				}
+
+				if (!MotionInstaller::begin(m_header_tmp, this))
+				{
+					m_setStatus(STATUS_NACK_REJECTED);
+
+					return;
+				}
+
+				m_continueArguments(INSTALL_FRAME_LENGTH);
+
+				return;
+			}
+
+			#if DEBUG_LESS
+				System::debugSerial().print(F(">>> frame_id : "));
+				System::debugSerial().println(m_continuation - 1);
+			#endif
+
+			m_frame_tmp.index              = m_continuation - 1;
+			m_frame_tmp.transition_time_ms = m_argUint(0, 4);
+
+			for (char device_id = 0; device_id < JointController::SUM; device_id++)
+			{
+				m_frame_tmp.joint_angle[device_id] = m_argInt(4 + device_id * 4, 4);
+			}
+
+			if (!MotionInstaller::stage(m_frame_tmp, this))
+			{
+				MotionInstaller::abort(this);
+				m_setStatus(STATUS_NACK_REJECTED);
+
+				return;
+			}
+
+			if (!MotionInstaller::staged())
+			{
+				m_continueArguments(INSTALL_FRAME_LENGTH);
+			}
+			else if (!MotionInstaller::commit(this))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
 		}
 
 		void setJointSettings()
@@ -191,22 +553,43 @@ namespace
 			joint_ctrl.resetSettings();
 		}
 
+		void setLimits()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::setLimits()"));
+
+				System::debugSerial().print(F(">>> joint_id : "));
+				System::debugSerial().println(m_argUint(0, 2));
+
+				System::debugSerial().print(F(">>> velocity : "));
+				System::debugSerial().println(m_argUint(2, 4));
+
+				System::debugSerial().print(F(">>> acceleration : "));
+				System::debugSerial().println(m_argUint(6, 4));
+			#endif
+
+			if (!joint_ctrl.setMotionLimits(m_argUint(0, 2), m_argUint(2, 4), m_argUint(6, 4)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
 		void setMax()
 		{
 			#if DEBUG_LESS
 				volatile Utility::Profiler p(F("Application::setMax()"));
 
 				System::debugSerial().print(F(">>> joint_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> angle : "));
-				System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 2, 3));
+				System::debugSerial().println(m_argInt(2, 3));
 			#endif
 
-			joint_ctrl.setMaxAngle(
-				Utility::hexbytes2uint(m_buffer.data, 2),
-				Utility::hexbytes2int(m_buffer.data + 2, 3)
-			);
+			if (!joint_ctrl.setMaxAngle(m_argUint(0, 2), m_argInt(2, 3)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
 		}
 
 		void setMotionFrame()
@@ -215,67 +598,45 @@ namespace
 				volatile Utility::Profiler p(F("Application::setMotionFrame()"));
 
 				System::debugSerial().print(F(">>> slot : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> frame_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 2, 2));
+				System::debugSerial().println(m_argUint(2, 2));
 
 				System::debugSerial().print(F(">>> transition_time_ms : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 4, 4));
+				System::debugSerial().println(m_argUint(4, 4));
 
 				for (int device_id = 0; device_id < JointController::SUM; device_id++)
 				{
 					System::debugSerial().print(F(">>> output["));
 					System::debugSerial().print(device_id);
 					System::debugSerial().print(F("] : "));
-					System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 8 + device_id * 4, 4));
+					System::debugSerial().println(m_argInt(8 + device_id * 4, 4));
 				}
 			#endif
 
-			m_frame_tmp.transition_time_ms = Utility::hexbytes2uint(m_buffer.data + 4, 4);
+			m_frame_tmp.transition_time_ms = m_argUint(4, 4);
 
 			for (char device_id = 0; device_id < JointController::SUM; device_id++)
 			{
-				m_frame_tmp.joint_angle[device_id] = Utility::hexbytes2int(m_buffer.data + 8 + device_id * 4, 4);
+				m_frame_tmp.joint_angle[device_id] = m_argInt(8 + device_id * 4, 4);
 			}
 
-			if (m_installing)
-			{
-				if (m_frame_tmp.index < m_header_tmp.frame_length)
-				{
-					m_frame_tmp.set(m_header_tmp.slot);
-					m_frame_tmp.index++;
-				}
+			m_frame_tmp.index = m_argUint(2, 2);
 
-				if (m_frame_tmp.index == m_header_tmp.frame_length)
-				{
-					m_installing = false;
-				}
-				else
-				{
-					readByte('>');
-					accept();
-					transitState();
-
-					readByte('m');
-					readByte('f');
-					accept();
-					transitState();
-
-					readByte('0'); // dummy
-					readByte('0'); // dummy
-					readByte('0'); // dummy
-					readByte('0'); // dummy
-				}
-			}
-			else
+			if (!m_frame_tmp.set(m_argUint(0, 2)))
 			{
-				m_frame_tmp.index = Utility::hexbytes2uint(m_buffer.data + 2, 2);
-				m_frame_tmp.set(Utility::hexbytes2uint(m_buffer.data, 2));
+				m_setStatus(STATUS_NACK_REJECTED);
 			}
 		}
 
-		void setMotionHeader()
+		/*!
+			@brief Parse the arguments of MOTION HEADER to m_header_tmp
+
+			@return Result
+			@retval false The arguments except the name are not hex digits.
+		*/
+		bool parseMotionHeader()
 		{
 			strncpy(m_header_tmp.name, m_buffer.data + 2, 20);
 			m_header_tmp.name[20] = '\0';
@@ -284,35 +645,35 @@ namespace
 			if (   !(m_parser[ARGUMENTS_INCOMING]->parse(m_buffer.data))
 				|| !(m_parser[ARGUMENTS_INCOMING]->parse(m_buffer.data + 22)) )
 			{
-				return;
+				return false;
 			}
 
 			#if DEBUG_LESS
-				volatile Utility::Profiler p(F("Application::setMotionHeader()"));
+				volatile Utility::Profiler p(F("Application::parseMotionHeader()"));
 
 				System::debugSerial().print(F(">>> slot : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> name : "));
 				System::debugSerial().println(m_header_tmp.name);
 
 				System::debugSerial().print(F(">>> func : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 22, 2));
+				System::debugSerial().println(m_argUint(22, 2));
 
 				System::debugSerial().print(F(">>> arg0 : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 24, 2));
+				System::debugSerial().println(m_argUint(24, 2));
 
 				System::debugSerial().print(F(">>> arg1 : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 26, 2));
+				System::debugSerial().println(m_argUint(26, 2));
 
 				System::debugSerial().print(F(">>> frame_length : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data + 28, 2));
+				System::debugSerial().println(m_argUint(28, 2));
 			#endif
 
-			m_header_tmp.slot         = Utility::hexbytes2uint(m_buffer.data, 2);
-			m_header_tmp.frame_length = Utility::hexbytes2uint(m_buffer.data + 28, 2);
+			m_header_tmp.slot         = m_argUint(0, 2);
+			m_header_tmp.frame_length = m_argUint(28, 2);
 
-			switch (Utility::hexbytes2uint(m_buffer.data + 22, 2))
+			switch (m_argUint(22, 2))
 			{
 				case 0:
 				{
@@ -326,8 +687,8 @@ namespace
 				{
 					m_header_tmp.use_loop   = 1;
 					m_header_tmp.use_jump   = 0;
-					m_header_tmp.loop_begin = Utility::hexbytes2uint(m_buffer.data + 24, 2);
-					m_header_tmp.loop_end   = Utility::hexbytes2uint(m_buffer.data + 26, 2);
+					m_header_tmp.loop_begin = m_argUint(24, 2);
+					m_header_tmp.loop_end   = m_argUint(26, 2);
 
 					break;
 				}
@@ -336,31 +697,27 @@ namespace
 				{
 					m_header_tmp.use_loop  = 0;
 					m_header_tmp.use_jump  = 1;
-					m_header_tmp.jump_slot = Utility::hexbytes2uint(m_buffer.data + 24, 2);
+					m_header_tmp.jump_slot = m_argUint(24, 2);
 
 					break;
 				}
 			}
 
-			m_header_tmp.set();
+			return true;
+		}
 
-			if (m_installing == true)
+		void setMotionHeader()
+		{
+			if (!parseMotionHeader())
 			{
-				readByte('>');
-				accept();
-				transitState();
+				m_setStatus(STATUS_NACK_SYNTAX);
 
-				readByte('m');
-				readByte('f');
-				accept();
-				transitState();
-
-				readByte('0'); // dummy
-				readByte('0'); // dummy
-				readByte('0'); // dummy
-				readByte('0'); // dummy
+				return;
+			}
 
-				m_frame_tmp.index = 0;
+			if (!m_header_tmp.set())
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
 			}
 		}
 
@@ -370,16 +727,45 @@ namespace
 				volatile Utility::Profiler p(F("Application::setMin()"));
 
 				System::debugSerial().print(F(">>> joint_id : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 
 				System::debugSerial().print(F(">>> angle : "));
-				System::debugSerial().println(Utility::hexbytes2int(m_buffer.data + 2, 3));
+				System::debugSerial().println(m_argInt(2, 3));
 			#endif
 
-			joint_ctrl.setMinAngle(
-				Utility::hexbytes2uint(m_buffer.data, 2),
-				Utility::hexbytes2int(m_buffer.data + 2, 3)
-			);
+			if (!joint_ctrl.setMinAngle(m_argUint(0, 2), m_argInt(2, 3)))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+
+		void getBalanceStabilizer()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getBalanceStabilizer()"));
+			#endif
+
+			#if MPU_6050
+				stabilizer.dump();
+			#endif
+		}
+
+		void getFileSystem()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getFileSystem()"));
+			#endif
+
+			ExternalFs::dump();
+		}
+
+		void getGaitParameters()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getGaitParameters()"));
+			#endif
+
+			gait.dump();
 		}
 
 		void getJointSettings()
@@ -391,20 +777,47 @@ namespace
 			joint_ctrl.dump();
 		}
 
+		void getMotionDirectory()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getMotionDirectory()"));
+			#endif
+
+			MotionDirectory::dump();
+		}
+
 		void getMotion()
 		{
 			#if DEBUG_LESS
 				volatile Utility::Profiler p(F("Application::getMotion()"));
 
 				System::debugSerial().print(F(">>> slot : "));
-				System::debugSerial().println(Utility::hexbytes2uint(m_buffer.data, 2));
+				System::debugSerial().println(m_argUint(0, 2));
 			#endif
 
 			motion_ctrl.dump(
-				Utility::hexbytes2uint(m_buffer.data, 2)
+				m_argUint(0, 2)
 			);
 		}
 
+		void getPoseStream()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getPoseStream()"));
+			#endif
+
+			pose_stream.dump();
+		}
+
+		void getStore()
+		{
+			#if DEBUG_LESS
+				volatile Utility::Profiler p(F("Application::getStore()"));
+			#endif
+
+			MotionStore::dump();
+		}
+
 		void getVersionInformation()
 		{
 			#if DEBUG_LESS
@@ -423,10 +836,7 @@ namespace
 
 			if (m_state == HEADER_INCOMING)
 			{
-				unsigned char header_id = m_parser[HEADER_INCOMING ]->index();
-				unsigned char cmd_id    = m_parser[COMMAND_INCOMING]->index();
-
-				(this->*EVENT_HANDLER[header_id][cmd_id])();
+				(this->*EVENT_HANDLER[m_header_id][m_cmd_id])();
 
 				#if MPU_6050
 					soul.userActionInputed();
@@ -438,23 +848,35 @@ namespace
 	void (Application::*Application::CONTROLLER_EVENT_HANDLER[])() = {
 		&Application::applyDiff,
 		&Application::apply,
+		&Application::applyPose,
+		&Application::balanceStabilizer,
+		&Application::calibration,
+		&Application::applyFootPose,
 		&Application::homePosition,
+		&Application::setJitterBuffer,
 		&Application::playMotion,
 		&Application::stopMotion,
+		&Application::playMotionWithFlags,
+		&Application::playGait,
 		&Application::playMotion,
+		&Application::streamPose,
+		&Application::setRetiming,
 		&Application::stopMotion
 	};
 
 	void (Application::*Application::INTERPRETER_EVENT_HANDLER[])() = {
+		&Application::pushCodeWithFlags,
 		&Application::popCode,
 		&Application::pushCode,
 		&Application::resetInterpreter
 	};
 
 	void (Application::*Application::SETTER_EVENT_HANDLER[])() = {
+		&Application::setGaitParameters,
 		&Application::setHome,
-		&Application::setMotionHeader, // sanity check.
+		&Application::installMotion,
 		&Application::setJointSettings,
+		&Application::setLimits,
 		&Application::setMax,
 		&Application::setMotionFrame,
 		&Application::setMotionHeader,
@@ -462,8 +884,14 @@ namespace
 	};
 
 	void (Application::*Application::GETTER_EVENT_HANDLER[])() = {
+		&Application::getBalanceStabilizer,
+		&Application::getFileSystem,
+		&Application::getGaitParameters,
 		&Application::getJointSettings,
+		&Application::getMotionDirectory,
 		&Application::getMotion,
+		&Application::getPoseStream,
+		&Application::getStore,
 		&Application::getVersionInformation
 	};
 
@@ -474,7 +902,18 @@ namespace
 		Application::GETTER_EVENT_HANDLER
 	};
 
-	Application app;
+	/*!
+		The application instances of the input channels
+
+		Each channel has its own parser state and buffer,
+		so commands arriving on the channels at once never interleave.
+		The instances share the handlers through the static tables above.
+
+		@note
+		The BLE module shares the USB serial, which System::BLESerial() returns, so it is the serial channel.
+	*/
+	Application app_serial;
+	Application app_tcp;
 }
 
 
@@ -491,6 +930,9 @@ void setup()
 {
 	volatile PLEN2::System system;
 	ExternalFs::init();
+	MotionStore::init();
+	Motion::migrate();
+	MotionDirectory::init();
 
 	joint_ctrl.Init();
 	joint_ctrl.loadSettings();
@@ -504,6 +946,8 @@ void setup()
 			(Generally, it is going to success setup() inserts 3000[msec] delays.)
 		*/
 		delay(3000);
+
+		motion_ctrl.attachStabilizer(stabilizer);
 	#endif
 
 	#if DEBUG
@@ -547,44 +991,33 @@ void loop()
 			}
 		}
 	}
-
-	if (PLEN2::System::BLESerial().available())
+	else
 	{
-		app.readByte(PLEN2::System::BLESerial().read());
-
-		if (app.accept())
+		// The stream is paused while a motion is playing, so the both don't move the joints at once.
+		if (pose_stream.updatable())
 		{
-			app.transitState();
-
+			pose_stream.update();
 		}
-	} else { // USB or BLe not both
-		if (PLEN2::System::SystemSerial().available())
-		{
-			app.readByte(PLEN2::System::SystemSerial().read());
 
-			if (app.accept())
-			{
-				app.transitState();
+		MotionStore::idle();
+	}
 
-			}
-		}
+	/*!
+		@note
+		The streams are drained by blocks under the time budget of Protocol::feed(),
+		so a whole command arrives in one iteration instead of a character per iteration.
+		Each channel is fed once per iteration, so a busy channel can't starve the others.
+	*/
+	if (PLEN2::System::SystemSerial().available())
+	{
+		app_serial.feed(PLEN2::System::SystemSerial());
 	}
 	if (PLEN2::System::tcp_available())
 	{
-	#if DEBUG_LESS
-	    uint8_t c = PLEN2::System::tcp_read();
-     	    PLEN2::System::outputSerial().write(c);
-     	    app.readByte(c);
-        #else
-            app.readByte(PLEN2::System::tcp_read());
-        #endif
-	    if (app.accept())
-	    {
-	        app.transitState();
-	    }
+	    app_tcp.feed(PLEN2::System::tcpClient());
 	}
 
-	PLEN2::System::handleClient();
+	PLEN2::System::handleClient(motion_ctrl.playing());
 	#if MPU_6050
 		soul.log();
 		soul.action();
@@ -0,0 +1,237 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "Checksum.h"
+#include "ExternalFs.h"
+#include "JointController.h"
+#include "Protocol.h"
+
+#include "Host.h"
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		APPLY_POSE = 0 << 5 | 2, //!< Command id of APPLY POSE, in the binary frames.
+
+		ALL_JOINTS = (1UL << JointController::SUM) - 1
+	};
+
+	/*!
+		@brief Protocol which applies the poses given by APPLY POSE, as Application::applyPose() does
+	*/
+	class Applier : public Protocol
+	{
+	public:
+		JointController& joint_ctrl;
+
+		Applier(JointController& joint_ctrl_)
+			: joint_ctrl(joint_ctrl_)
+		{
+			// noop.
+		}
+
+		virtual void afterHook()
+		{
+			if (   (m_state != READY)
+				|| (m_header_id != 0)
+				|| (m_cmd_id != 2 /* := APPLY POSE */) )
+			{
+				return;
+			}
+
+			const unsigned long mask =
+				  (static_cast<unsigned long>(m_argUint(0, 2)) << 16)
+				| (static_cast<unsigned long>(m_argUint(2, 2)) << 8)
+				|  static_cast<unsigned long>(m_argUint(4, 2));
+
+			int angle_diffs[JointController::SUM];
+
+			for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+			{
+				angle_diffs[joint_id] = m_argInt(6 + joint_id * 3, 3);
+			}
+
+			if (!joint_ctrl.setAnglesDiff(angle_diffs, mask))
+			{
+				m_setStatus(STATUS_NACK_REJECTED);
+			}
+		}
+	};
+
+	//! @brief Get the angle-diff of the joint in the poses of the tests, which differs on each joint.
+	int angle_diff(int joint_id, int scale)
+	{
+		return scale * (joint_id + 1) * ((joint_id % 2)? -1 : 1);
+	}
+
+	//! @brief Make the text command of the pose, with the sequence number.
+	std::string text(unsigned char sequence, unsigned long mask, int scale)
+	{
+		char command[128];
+		int  length = snprintf(command, sizeof(command), "@%02X$AP%06lX", sequence, mask);
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			length += snprintf(command + length, sizeof(command) - length, "%03X", angle_diff(joint_id, scale) & 0xFFF);
+		}
+
+		return command;
+	}
+
+	//! @brief Make the binary frame of the pose, with the sequence number.
+	std::string binary(unsigned char sequence, unsigned long mask, int scale)
+	{
+		std::string body;
+		body += static_cast<char>(3 + JointController::SUM * 2 + 1);
+		body += static_cast<char>(APPLY_POSE);
+		body += static_cast<char>(mask >> 16);
+		body += static_cast<char>(mask >> 8);
+		body += static_cast<char>(mask);
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			body += static_cast<char>(angle_diff(joint_id, scale) & 0xFF);
+			body += static_cast<char>(angle_diff(joint_id, scale) >> 8);
+		}
+
+		const unsigned int crc = Utility::crc16(reinterpret_cast<const unsigned char*>(body.data()), body.size());
+
+		char header[4];
+		snprintf(header, sizeof(header), "@%02X", sequence);
+
+		return header + std::string(1, static_cast<char>(Protocol::BINARY_START)) + body
+			+ static_cast<char>(crc & 0xFF) + static_cast<char>(crc >> 8);
+	}
+
+	//! @brief Feed the command, and get the reply to it.
+	std::string reply(Protocol& protocol, const std::string& command)
+	{
+		Host::StringStream channel;
+		channel.input = command;
+
+		protocol.feed(channel);
+
+		return channel.output;
+	}
+
+	/*!
+		@brief Get the PWM buffer of the pose
+
+		Each joint of the mask has the angle-diff of the scale, and the others have the PWM width of "previous".
+		It is the buffer which the next tick of JointController::updateAngle() outputs.
+	*/
+	void expected(JointController& joint_ctrl, unsigned long mask, int scale, const int previous[JointController::SUM], int pwms[JointController::SUM])
+	{
+		int buffer[JointController::SUM];
+		memcpy(buffer, JointController::m_pwms, sizeof(buffer));
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			joint_ctrl.setAngleDiff(joint_id, angle_diff(joint_id, scale));
+
+			pwms[joint_id] = (mask & (1UL << joint_id))? JointController::m_pwms[joint_id] : previous[joint_id];
+		}
+
+		memcpy(JointController::m_pwms, buffer, sizeof(buffer));
+	}
+
+	bool buffered(const int pwms[JointController::SUM])
+	{
+		return (memcmp(pwms, JointController::m_pwms, sizeof(JointController::m_pwms)) == 0);
+	}
+
+	void boot(JointController& joint_ctrl)
+	{
+		Host::makeFsRoot("apply_pose");
+
+		ExternalFs::de_init();
+		ExternalFs::init();
+
+		joint_ctrl.resetSettings();
+	}
+}
+
+
+TEST(allJointsAreAppliedInOneTick)
+{
+	JointController joint_ctrl;
+	Applier         applier(joint_ctrl);
+
+	boot(joint_ctrl);
+
+	int home[JointController::SUM];
+	int pwms[JointController::SUM];
+
+	memcpy(home, JointController::m_pwms, sizeof(home));
+
+	// One command drives all the joints, and a joint which doesn't move from the home is not left.
+	expected(joint_ctrl, ALL_JOINTS, 20, home, pwms);
+
+	CHECK(reply(applier, text(0x01, ALL_JOINTS, 20)) == "@010080\r\n");
+	CHECK(buffered(pwms));
+
+	for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		CHECK(pwms[joint_id] != home[joint_id]);
+	}
+
+	// The binary frame carries the same pose.
+	int previous[JointController::SUM];
+	memcpy(previous, JointController::m_pwms, sizeof(previous));
+
+	expected(joint_ctrl, ALL_JOINTS, -30, previous, pwms);
+
+	CHECK(reply(applier, binary(0x02, ALL_JOINTS, -30)) == "@020080\r\n");
+	CHECK(buffered(pwms));
+
+	// The joints masked out keep their angles.
+	const unsigned long LEFT_LEG = 0x0001FC;
+
+	memcpy(previous, JointController::m_pwms, sizeof(previous));
+	expected(joint_ctrl, LEFT_LEG, 10, previous, pwms);
+
+	CHECK(reply(applier, text(0x03, LEFT_LEG, 10)) == "@030080\r\n");
+	CHECK(buffered(pwms));
+	CHECK_EQUAL(previous[JointController::SUM - 1], JointController::m_pwms[JointController::SUM - 1]);
+}
+
+
+TEST(rejectedPoseLeavesThePose)
+{
+	JointController joint_ctrl;
+	Applier         applier(joint_ctrl);
+
+	boot(joint_ctrl);
+
+	int pose[JointController::SUM];
+
+	CHECK(reply(applier, text(0x10, ALL_JOINTS, 20)) == "@100080\r\n");
+	memcpy(pose, JointController::m_pwms, sizeof(pose));
+
+	// A bit of the mask over the joints rejects the whole pose, so no joint of it is applied.
+	const unsigned long MASKS[] = { ALL_JOINTS | (1UL << JointController::SUM), 1UL << 23, 0x000001 | (1UL << 20) };
+
+	for (unsigned int index = 0; index < sizeof(MASKS) / sizeof(MASKS[0]); index++)
+	{
+		CHECK(reply(applier, text(0x11, MASKS[index], -30)) == "@110380\r\n");
+		CHECK(buffered(pose));
+
+		CHECK(reply(applier, binary(0x12, MASKS[index], -30)) == "@120380\r\n");
+		CHECK(buffered(pose));
+	}
+
+	// The next pose is applied.
+	CHECK(reply(applier, text(0x13, ALL_JOINTS, -30)) == "@130080\r\n");
+	CHECK(!buffered(pose));
+}
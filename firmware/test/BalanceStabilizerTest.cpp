@@ -0,0 +1,260 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <Wire.h>
+#include <math.h>
+
+#include "AccelerationGyroSensor.h"
+#include "BalanceStabilizer.h"
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		ONE_G      = 16384, //!< Acceleration of the gravity. (LSB, at +/-2g full scale.)
+		OFFSET_MAX = 100,   //!< := BalanceStabilizer::OFFSET_MAX()
+
+		RIGHT_BEGIN = JointController::RIGHT_SHOULDER_PITCH
+	};
+
+	/*!
+		@brief Controller which exposes the angle-diffs interpolated
+
+		They are the output of the motion, before the offsets of the stabilizer are added.
+	*/
+	class Controller : public MotionController
+	{
+	public:
+		Controller(JointController& joint_ctrl)
+			: MotionController(joint_ctrl)
+		{
+		}
+
+		int angleDiff(unsigned char joint_id) const
+		{
+			return static_cast<int>(m_current_fixed_points[joint_id] >> 16 /* := PRECISION */);
+		}
+	};
+
+	/*!
+		@brief Set the values that the stubbed MPU-6050 gives
+
+		They are the registers from ACCEL_XOUT_H, which are big endian. (The temperature between them is 0.)
+	*/
+	void set_sensor(int acc_x, int acc_y, int acc_z, int gyro_roll, int gyro_pitch)
+	{
+		const int values[] = { acc_x, acc_y, acc_z, 0, gyro_roll, gyro_pitch, 0 };
+
+		for (unsigned int index = 0; index < sizeof(values) / sizeof(values[0]); index++)
+		{
+			Wire.reply[index * 2]     = static_cast<uint16_t>(values[index]) >> 8;
+			Wire.reply[index * 2 + 1] = static_cast<uint16_t>(values[index]) & 0xFF;
+		}
+	}
+
+	//! @brief Tilt the sensor around the pitch axis, from standing upright. (Degree.)
+	void tilt_pitch(double degree)
+	{
+		set_sensor(
+			static_cast<int>(ONE_G * sin(degree * M_PI / 180)), 0, static_cast<int>(ONE_G * cos(degree * M_PI / 180)),
+			0, 0
+		);
+	}
+
+	void boot()
+	{
+		ExternalFs::de_init();
+		ExternalFs::init();
+		MotionStore::init();
+		Motion::migrate();
+		MotionDirectory::init();
+	}
+}
+
+
+TEST(offsetsOpposeTheTilt)
+{
+	AccelerationGyroSensor sensor;
+	BalanceStabilizer      stabilizer(sensor);
+
+	tilt_pitch(0);
+	stabilizer.enable(true);
+
+	// The tilt forward is corrected backward, and the right side is mirrored.
+	tilt_pitch(5);
+	stabilizer.update();
+
+	const int* offsets = stabilizer.offsets();
+
+	CHECK(offsets[JointController::LEFT_FOOT_PITCH] < 0);
+	CHECK_EQUAL(offsets[JointController::LEFT_FOOT_PITCH] / 2, offsets[JointController::LEFT_THIGH_PITCH]);
+	CHECK_EQUAL(-offsets[JointController::LEFT_FOOT_PITCH], offsets[RIGHT_BEGIN + JointController::LEFT_FOOT_PITCH]);
+	CHECK_EQUAL(-offsets[JointController::LEFT_THIGH_PITCH], offsets[RIGHT_BEGIN + JointController::LEFT_THIGH_PITCH]);
+	CHECK_EQUAL(0, offsets[JointController::LEFT_FOOT_ROLL]);
+
+	// The P term is tilt [deg/10] / 2, within the error of the binary angle.
+	CHECK(abs(offsets[JointController::LEFT_FOOT_PITCH] + 25) <= 1);
+
+	tilt_pitch(-5);
+	stabilizer.update();
+
+	CHECK(offsets[JointController::LEFT_FOOT_PITCH] > 0);
+
+	// The roll is corrected on the roll joints only.
+	set_sensor(0, ONE_G / 10, ONE_G, 0, 0);
+	stabilizer.update();
+
+	CHECK(offsets[JointController::LEFT_FOOT_ROLL] < 0);
+	CHECK_EQUAL(offsets[JointController::LEFT_FOOT_ROLL] / 2, offsets[JointController::LEFT_THIGH_ROLL]);
+	CHECK_EQUAL(-offsets[JointController::LEFT_FOOT_ROLL], offsets[RIGHT_BEGIN + JointController::LEFT_FOOT_ROLL]);
+	CHECK_EQUAL(0, offsets[JointController::LEFT_FOOT_PITCH]);
+
+	// The angular velocity is damped without any tilt. (131 LSB is 1 [deg/sec].)
+	set_sensor(0, 0, ONE_G, 0, 131 * 100);
+	stabilizer.update();
+
+	CHECK(offsets[JointController::LEFT_FOOT_PITCH] < 0);
+	CHECK_EQUAL(-(16 * 1000 >> 8), offsets[JointController::LEFT_FOOT_PITCH]);
+}
+
+
+TEST(offsetsAreBounded)
+{
+	AccelerationGyroSensor sensor;
+	BalanceStabilizer      stabilizer(sensor);
+
+	tilt_pitch(0);
+	stabilizer.enable(true);
+
+	const int* offsets = stabilizer.offsets();
+
+	for (int degree = -180; degree <= 180; degree += 15)
+	{
+		tilt_pitch(degree);
+		stabilizer.update();
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			CHECK(abs(offsets[joint_id]) <= OFFSET_MAX);
+		}
+
+		CHECK(abs(offsets[JointController::LEFT_THIGH_PITCH]) <= OFFSET_MAX / 2);
+	}
+
+	// The tilt of 90 [deg] is clamped, even if the gyro at its full scale damps it.
+	set_sensor(ONE_G, -ONE_G, 0, 32767, -32768);
+	stabilizer.update();
+
+	CHECK_EQUAL(-OFFSET_MAX, offsets[JointController::LEFT_FOOT_PITCH]);
+	CHECK_EQUAL(OFFSET_MAX, offsets[JointController::LEFT_FOOT_ROLL]);
+	CHECK_EQUAL(-OFFSET_MAX / 2, offsets[JointController::LEFT_THIGH_PITCH]);
+	CHECK_EQUAL(OFFSET_MAX, offsets[RIGHT_BEGIN + JointController::LEFT_FOOT_PITCH]);
+
+	// Disabling clears the offsets, and the sensor is not sampled.
+	stabilizer.enable(false);
+	stabilizer.update();
+
+	for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+	{
+		CHECK_EQUAL(0, offsets[joint_id]);
+	}
+}
+
+
+TEST(offsetsAreAddedToTheMotion)
+{
+	Host::makeFsRoot("stabilizer_motion");
+	boot();
+
+	// The legs move from frame to frame, so the offsets are added to the angles interpolated.
+	Motion::Header header;
+	header.init();
+	header.slot         = 0;
+	header.frame_length = 3;
+
+	MotionInstaller::begin(header);
+
+	for (unsigned char index = 0; index < header.frame_length; index++)
+	{
+		Motion::Frame frame;
+		memset(&frame, 0, sizeof(frame));
+
+		frame.index              = index;
+		frame.transition_time_ms = 200;
+		frame.joint_angle[JointController::LEFT_FOOT_PITCH]                = 100 * (index + 1);
+		frame.joint_angle[RIGHT_BEGIN + JointController::LEFT_THIGH_PITCH] = -50 * (index + 1);
+
+		MotionInstaller::stage(frame);
+	}
+
+	CHECK(MotionInstaller::commit());
+
+	JointController        joint_ctrl;
+	AccelerationGyroSensor sensor;
+	BalanceStabilizer      stabilizer(sensor);
+	Controller             controller(joint_ctrl);
+
+	joint_ctrl.resetSettings();
+	controller.attachStabilizer(stabilizer);
+
+	tilt_pitch(0);
+	stabilizer.enable(true);
+	tilt_pitch(3);
+
+	CHECK(controller.play(0));
+
+	int ticks = 0;
+
+	while (controller.playing() && (ticks < 100))
+	{
+		if (controller.updatingFinished())
+		{
+			if (!controller.nextFrameLoadable())
+			{
+				break;
+			}
+
+			controller.loadNextFrame();
+
+			continue;
+		}
+
+		controller.updateFrame();
+		ticks++;
+
+		int pwms[JointController::SUM];
+		memcpy(pwms, JointController::m_pwms, sizeof(pwms));
+
+		const int* offsets = stabilizer.offsets();
+
+		CHECK(offsets[JointController::LEFT_FOOT_PITCH] < 0);
+
+		// Each joint is driven to the angle of the motion plus the offset, as setAngleDiff() does.
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			joint_ctrl.setAngleDiff(joint_id, controller.angleDiff(joint_id) + offsets[joint_id]);
+
+			CHECK_EQUAL(JointController::m_pwms[joint_id], pwms[joint_id]);
+		}
+	}
+
+	CHECK(ticks > 10);
+
+	controller.stop();
+}
@@ -0,0 +1,91 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+// The tables of the protocol are read by Commands.h, so Protocol.cpp is built here in place of the library.
+#include "Protocol.cpp"
+#include "Commands.h"
+
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+TEST(textAndBinaryDecodeTheSameArguments)
+{
+	srand(1);
+
+	for (int header_id = 0; header_id < Commands::HEADER_SUM; header_id++)
+	{
+		for (int cmd_id = 0; cmd_id < Commands::count(header_id); cmd_id++)
+		{
+			if (!Commands::binaryAvailable(header_id, cmd_id))
+			{
+				continue;
+			}
+
+			Commands::Dispatcher text_protocol;
+			Commands::Dispatcher binary_protocol;
+
+			text_protocol.recording   = true;
+			binary_protocol.recording = true;
+
+			for (int count = 0; count < 256; count++)
+			{
+				std::string text;
+				std::string binary;
+
+				Commands::pair(header_id, cmd_id, text, binary);
+
+				CHECK_EQUAL(1, text_protocol.feed(text.data(), text.size()));
+				CHECK_EQUAL(1, binary_protocol.feed(binary.data(), binary.size()));
+			}
+
+			// Each field is read by m_argUint() and m_argInt(), so every value of both is compared.
+			CHECK_EQUAL(256, binary_protocol.dispatched);
+			CHECK_EQUAL(text_protocol.arguments.size(), binary_protocol.arguments.size());
+			CHECK(text_protocol.arguments == binary_protocol.arguments);
+		}
+	}
+}
+
+
+TEST(binaryFieldsAreSignExtended)
+{
+	Commands::Dispatcher text_protocol;
+	Commands::Dispatcher binary_protocol;
+
+	text_protocol.recording   = true;
+	binary_protocol.recording = true;
+
+	// APPLY NATIVE of device 0x0A, at the edges of the 3 digits field.
+	const char* const TEXTS[]   = { "$AN0A7FF", "$AN0A800", "$AN0AFFF", "$AN0A000" };
+	const char* const PAYLOADS[] = { "\x0A\xFF\x07", "\x0A\x00\x08", "\x0A\xFF\x0F", "\x0A\x00\x00" };
+
+	for (int index = 0; index < 4; index++)
+	{
+		const std::string text(TEXTS[index]);
+
+		text_protocol.feed(text.data(), text.size());
+
+		const std::string binary = Commands::frame(0, 1 /* := APPLY NATIVE */, std::string(PAYLOADS[index], 3));
+
+		binary_protocol.feed(binary.data(), binary.size());
+	}
+
+	const int EXPECTED[] = {
+		0x0A, 0x0A, 0x7FF,  0x7FF,
+		0x0A, 0x0A, 0x800, -0x800,
+		0x0A, 0x0A, 0xFFF, -1,
+		0x0A, 0x0A, 0x000,  0
+	};
+
+	CHECK(text_protocol.arguments == std::vector<int>(EXPECTED, EXPECTED + 16));
+	CHECK(binary_protocol.arguments == text_protocol.arguments);
+}
@@ -0,0 +1,74 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "Checksum.h"
+
+#include "Test.h"
+
+
+namespace
+{
+	const unsigned char CHECK_INPUT[] = "123456789";
+
+	//! @brief Get CRC-16 a bit at a time, as the reference of the table.
+	unsigned int crc16_bitwise(const unsigned char data[], unsigned int size)
+	{
+		unsigned int crc = 0xFFFF;
+
+		for (unsigned int index = 0; index < size; index++)
+		{
+			crc ^= data[index] << 8;
+
+			for (int bit = 0; bit < 8; bit++)
+			{
+				crc = ((crc & 0x8000)? ((crc << 1) ^ 0x1021) : (crc << 1)) & 0xFFFF;
+			}
+		}
+
+		return crc;
+	}
+}
+
+
+TEST(crc32CheckValue)
+{
+	CHECK_EQUAL(0xCBF43926UL, Utility::crc32(CHECK_INPUT, 9));
+	CHECK_EQUAL(0x00000000UL, Utility::crc32(CHECK_INPUT, 0));
+
+	// The result of the preceding bytes continues the checksum.
+	CHECK_EQUAL(0xCBF43926UL, Utility::crc32(CHECK_INPUT + 4, 5, Utility::crc32(CHECK_INPUT, 4)));
+}
+
+
+TEST(crc16CheckValue)
+{
+	CHECK_EQUAL(0x29B1, Utility::crc16(CHECK_INPUT, 9));
+	CHECK_EQUAL(0x29B1, Utility::crc16(CHECK_INPUT + 4, 5, Utility::crc16(CHECK_INPUT, 4)));
+}
+
+
+TEST(crc16MatchesBitwise)
+{
+	unsigned char data[68];
+
+	srand(1);
+
+	for (int count = 0; count < 10000; count++)
+	{
+		const unsigned int size = rand() % sizeof(data);
+
+		for (unsigned int index = 0; index < size; index++)
+		{
+			data[index] = rand();
+		}
+
+		CHECK_EQUAL(crc16_bitwise(data, size), Utility::crc16(data, size));
+	}
+}
@@ -0,0 +1,80 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <strings.h>
+
+// CommandParser and its tables are in the anonymous namespace, so Protocol.cpp is built here in place of the library.
+#include "Protocol.cpp"
+
+#include "Test.h"
+
+
+namespace
+{
+	//! @brief Search the commands of the header from the head, as the reference of CommandParser.
+	int linear_search(int header_id, const char* input)
+	{
+		for (int cmd_id = 0; cmd_id < Shared::SYMBOL_LENGTH[header_id]; cmd_id++)
+		{
+			if (strcasecmp(input, Shared::SYMBOL[header_id][cmd_id]) == 0)
+			{
+				return cmd_id;
+			}
+		}
+
+		return -1;
+	}
+
+	void check_command(int header_id, const char* input)
+	{
+		Shared::CommandParser parser(header_id);
+		const int expected = linear_search(header_id, input);
+
+		CHECK_EQUAL(expected >= 0, parser.parse(input));
+		CHECK_EQUAL(expected, parser.index());
+	}
+}
+
+
+TEST(commandParserMatchesLinearSearch)
+{
+	for (int header_id = 0; header_id < Shared::HEADER_LENGTH; header_id++)
+	{
+		// Every printable string of 2 characters, and the shorter ones.
+		check_command(header_id, "");
+
+		for (int first = ' '; first <= '~'; first++)
+		{
+			const char single[] = { static_cast<char>(first), '\0' };
+
+			check_command(header_id, single);
+
+			for (int second = ' '; second <= '~'; second++)
+			{
+				const char input[] = { static_cast<char>(first), static_cast<char>(second), '\0' };
+
+				check_command(header_id, input);
+			}
+		}
+	}
+}
+
+
+TEST(commandParserRejectsLongerInputs)
+{
+	for (int header_id = 0; header_id < Shared::HEADER_LENGTH; header_id++)
+	{
+		for (int cmd_id = 0; cmd_id < Shared::SYMBOL_LENGTH[header_id]; cmd_id++)
+		{
+			const std::string input = std::string(Shared::SYMBOL[header_id][cmd_id]) + "0";
+
+			check_command(header_id, input.c_str());
+		}
+	}
+}
@@ -0,0 +1,354 @@
+/*!
+	@file      Commands.h
+	@brief     Generator of the commands of the protocol, and a dispatcher that checks them.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+
+	@attention
+	The file reads the tables of the protocol in its anonymous namespace,
+	so please include it after "Protocol.cpp" in the same translation unit.
+*/
+
+#pragma once
+
+#ifndef PLEN2_TEST_COMMANDS_H
+#define PLEN2_TEST_COMMANDS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "Checksum.h"
+#include "Parser.h"
+#include "Protocol.h"
+
+
+namespace Commands
+{
+	enum {
+		HEADER_SUM           = Shared::HEADER_LENGTH,
+		INSTALL_HEADER_ID    = 2, //!< Header index of INSTALL MOTION.
+		INSTALL_CMD_ID       = 2, //!< Command index of INSTALL MOTION.
+		INSTALL_FRAME_LENGTH = 100,
+		INSTALL_FRAMES_MAX   = 20
+	};
+
+	//! @brief Get count of the commands of the header given.
+	inline int count(int header_id)
+	{
+		return Shared::SYMBOL_LENGTH[header_id];
+	}
+
+	//! @brief Get name of a command, e.g. "$AD".
+	inline std::string name(int header_id, int cmd_id)
+	{
+		return std::string(1, Shared::HEADER_SYMBOL[header_id]) + Shared::SYMBOL[header_id][cmd_id];
+	}
+
+	//! @brief Get whether the command is available as a binary frame.
+	inline bool binaryAvailable(int header_id, int cmd_id)
+	{
+		return (Shared::ARGS_FIELDS[header_id][cmd_id] != NULL);
+	}
+
+	inline int pick(int range)
+	{
+		return rand() % range;
+	}
+
+	inline std::string hex(int digits)
+	{
+		static const char DIGITS[] = "0123456789ABCDEFabcdef";
+
+		std::string result;
+
+		for (int count = 0; count < digits; count++)
+		{
+			result += DIGITS[pick(sizeof(DIGITS) - 1)];
+		}
+
+		return result;
+	}
+
+	inline std::string hex_byte(unsigned int value)
+	{
+		char result[3];
+		snprintf(result, sizeof(result), "%02X", value & 0xFF);
+
+		return result;
+	}
+
+	/*!
+		@brief Make a text command with random arguments
+
+		INSTALL MOTION is followed by 1 to 20 frames,
+		and the count of them is added to **frames** if it is given.
+	*/
+	inline std::string text(int header_id, int cmd_id, long* frames = NULL)
+	{
+		std::string result = name(header_id, cmd_id);
+
+		if (   (header_id == INSTALL_HEADER_ID)
+			&& (cmd_id == INSTALL_CMD_ID) )
+		{
+			const int frame_length = 1 + pick(INSTALL_FRAMES_MAX);
+
+			result += hex_byte(pick(90));              // Slot.
+			result += std::string(20, 'a' + pick(26)); // Name.
+			result += hex(6);                          // Extra, jump and loop.
+			result += hex_byte(frame_length);
+
+			for (int count = 0; count < frame_length; count++)
+			{
+				result += hex(INSTALL_FRAME_LENGTH);
+			}
+
+			if (frames != NULL)
+			{
+				*frames += frame_length;
+			}
+
+			return result;
+		}
+
+		const int   store_length = Shared::ARGS_STORE_LENGTH[header_id][cmd_id];
+		const char* fields       = Shared::ARGS_FIELDS[header_id][cmd_id];
+
+		if (   (fields != NULL)
+			&& (fields[0] == '*') )
+		{
+			result += hex(2);
+
+			for (int count = 2; count < store_length; count++)
+			{
+				result += static_cast<char>(' ' + pick(95));
+			}
+
+			return result;
+		}
+
+		return result + hex(store_length);
+	}
+
+	//! @brief Make a binary frame of the command and the payload given.
+	inline std::string frame(int header_id, int cmd_id, const std::string& payload)
+	{
+		std::string body;
+		body += static_cast<char>(payload.size() + 1);
+		body += static_cast<char>((header_id << 5) | cmd_id);
+		body += payload;
+
+		const unsigned int crc = Utility::crc16(reinterpret_cast<const unsigned char*>(body.data()), body.size());
+
+		return std::string(1, static_cast<char>(PLEN2::Protocol::BINARY_START)) + body
+			+ static_cast<char>(crc & 0xFF) + static_cast<char>(crc >> 8);
+	}
+
+	/*!
+		@brief Make a text command and a binary frame which have the same random arguments
+
+		@attention
+		Please give a command available as a binary frame.
+	*/
+	inline void pair(int header_id, int cmd_id, std::string& text, std::string& binary)
+	{
+		const char* fields = Shared::ARGS_FIELDS[header_id][cmd_id];
+		std::string payload;
+
+		text = name(header_id, cmd_id);
+
+		if (fields[0] == '*')
+		{
+			payload = hex(2);
+
+			for (int count = 2; count < Shared::ARGS_STORE_LENGTH[header_id][cmd_id]; count++)
+			{
+				payload += static_cast<char>(' ' + pick(95));
+			}
+
+			text += payload;
+		}
+		else
+		{
+			for (; *fields != '\0'; fields++)
+			{
+				const int          digits = *fields - '0';
+				const unsigned int value  = pick(1 << (digits * 4));
+				char               field[8];
+
+				snprintf(field, sizeof(field), "%0*X", digits, value);
+				text += field;
+
+				payload += static_cast<char>(value & 0xFF);
+
+				if (digits > 2)
+				{
+					payload += static_cast<char>(value >> 8);
+				}
+			}
+
+			// The text carries every argument, and the rest of a binary frame is zero. (e.g. MOTION FRAME)
+			text.resize(3 + Shared::ARGS_STORE_LENGTH[header_id][cmd_id], '0');
+		}
+
+		binary = frame(header_id, cmd_id, payload);
+	}
+
+	/*!
+		@brief Make a binary frame with random arguments
+
+		@attention
+		Please give a command available as a binary frame.
+	*/
+	inline std::string binary(int header_id, int cmd_id)
+	{
+		std::string text;
+		std::string result;
+
+		pair(header_id, cmd_id, text, result);
+
+		return result;
+	}
+
+	/*!
+		@brief Make a command picked at random
+
+		@param [out] frames      Count of the frames of INSTALL MOTION is added to it.
+		@param [in]  use_binary  Please set true to make binary frames too.
+	*/
+	inline std::string any(long& frames, bool use_binary)
+	{
+		const int header_id = pick(HEADER_SUM);
+		const int cmd_id    = pick(count(header_id));
+
+		if (   (use_binary)
+			&& (pick(2))
+			&& (binaryAvailable(header_id, cmd_id)) )
+		{
+			return binary(header_id, cmd_id);
+		}
+
+		return text(header_id, cmd_id, &frames);
+	}
+
+
+	/*!
+		@brief Protocol which reads the arguments of each command dispatched, as the application does
+
+		INSTALL MOTION continues its arguments for the frames, so it is dispatched once for each of them.
+		A command out of the tables aborts the process.
+	*/
+	class Dispatcher : public PLEN2::Protocol
+	{
+	public:
+		long dispatched;
+		long sink;
+
+		bool             recording; //!< Record the arguments read to **arguments**.
+		std::vector<int> arguments;
+
+		Dispatcher()
+			: dispatched(0)
+			, sink(0)
+			, recording(false)
+			, m_frames(0)
+		{
+			// noop.
+		}
+
+		//! @brief Get whether no command is incoming.
+		bool ready() const
+		{
+			return (m_state == READY);
+		}
+
+		virtual void afterHook()
+		{
+			if (m_state != READY)
+			{
+				return;
+			}
+
+			if (   (m_header_id >= HEADER_SUM)
+				|| (m_cmd_id >= count(m_header_id)) )
+			{
+				printf("bad dispatch : header %d, command %d\n", m_header_id, m_cmd_id);
+				abort();
+			}
+
+			dispatched++;
+
+			if (   (m_header_id == INSTALL_HEADER_ID)
+				&& (m_cmd_id == INSTALL_CMD_ID) )
+			{
+				installMotion();
+
+				return;
+			}
+
+			const char* fields = Shared::ARGS_FIELDS[m_header_id][m_cmd_id];
+
+			if (fields == NULL)
+			{
+				return;
+			}
+
+			if (fields[0] == '*')
+			{
+				sink += strlen(m_buffer.data);
+
+				if (recording)
+				{
+					arguments.insert(arguments.end(), m_buffer.data, m_buffer.data + strlen(m_buffer.data));
+				}
+
+				return;
+			}
+
+			for (unsigned char offset = 0; *fields != '\0'; offset += *fields - '0', fields++)
+			{
+				const unsigned char digits = *fields - '0';
+
+				sink += (digits == 2)? m_argUint(offset, digits) : m_argInt(offset, digits);
+
+				if (recording)
+				{
+					arguments.push_back(m_argUint(offset, digits));
+					arguments.push_back(m_argInt(offset, digits));
+				}
+			}
+		}
+
+	private:
+		unsigned int m_frames;
+
+		void installMotion()
+		{
+			if (m_continuation == 0)
+			{
+				m_frames = Utility::hexbytes2uint(m_buffer.data + 28, 2);
+
+				if (   (m_frames >= 1)
+					&& (m_frames <= INSTALL_FRAMES_MAX) )
+				{
+					m_continueArguments(INSTALL_FRAME_LENGTH);
+				}
+
+				return;
+			}
+
+			for (unsigned char offset = 0; offset < INSTALL_FRAME_LENGTH; offset += 4)
+			{
+				sink += m_argInt(offset, 4);
+			}
+
+			if (m_continuation < m_frames)
+			{
+				m_continueArguments(INSTALL_FRAME_LENGTH);
+			}
+		}
+	};
+}
+
+#endif // PLEN2_TEST_COMMANDS_H
@@ -0,0 +1,273 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+
+#include "Test.h"
+
+extern File fp_motion;
+
+using namespace PLEN2;
+
+
+namespace
+{
+	/*!
+		@brief Limit of the file size, which makes the host file system fail to grow a file
+
+		A file can't grow over the limit, as a SPIFFS which has no free block.
+	*/
+	class FileSizeLimit
+	{
+	private:
+		struct rlimit m_previous;
+
+	public:
+		FileSizeLimit(rlim_t size)
+		{
+			signal(SIGXFSZ, SIG_IGN);
+			getrlimit(RLIMIT_FSIZE, &m_previous);
+
+			struct rlimit limit = m_previous;
+			limit.rlim_cur = size;
+			setrlimit(RLIMIT_FSIZE, &limit);
+		}
+
+		~FileSizeLimit()
+		{
+			setrlimit(RLIMIT_FSIZE, &m_previous);
+		}
+	};
+
+	/*!
+		@brief Get a metric of the file system
+
+		@param [in] name Please set the name of the metric in the output of ExternalFs::dump().
+	*/
+	unsigned long metric(const char* name)
+	{
+		Host::output().clear();
+		ExternalFs::dump();
+
+		const std::string key = std::string("\"") + name + "\": ";
+		const size_t position = Host::output().output.find(key);
+
+		return (position == std::string::npos)? 0 : strtoul(Host::output().output.c_str() + position + key.size(), NULL, 10);
+	}
+
+	void fill(unsigned char data[], unsigned int size, unsigned char seed)
+	{
+		for (unsigned int index = 0; index < size; index++)
+		{
+			data[index] = seed + index;
+		}
+	}
+}
+
+
+TEST(commitSucceedsWithoutLimit)
+{
+	Host::makeFsRoot("external_fs_commit");
+
+	File fp = SPIFFS.open("/joint_cfg.bin", "w+");
+	unsigned char data[64];
+
+	fill(data, sizeof(data), 1);
+
+	CHECK(ExternalFs::begin(fp));
+	ExternalFs::write(0x2000, sizeof(data), data, fp);
+	ExternalFs::write(0, sizeof(data), data, fp);
+	CHECK(ExternalFs::commit());
+
+	fp.close();
+}
+
+
+TEST(commitReportsWriteBackFailure)
+{
+	Host::makeFsRoot("external_fs_write_back");
+
+	File fp = SPIFFS.open("/joint_cfg.bin", "w+");
+	unsigned char data[64];
+
+	fill(data, sizeof(data), 1);
+
+	{
+		FileSizeLimit limit(0x1000);
+
+		// The page is written back at commit().
+		CHECK(ExternalFs::begin(fp));
+		ExternalFs::write(0x2000, sizeof(data), data, fp);
+		CHECK(!ExternalFs::commit());
+
+		// The page is written back on the way, as the next write goes out of it, and the last page succeeds.
+		CHECK(ExternalFs::begin(fp));
+		ExternalFs::write(0x2000, sizeof(data), data, fp);
+		ExternalFs::write(0, sizeof(data), data, fp);
+		CHECK(!ExternalFs::commit());
+
+		// The failure is not carried to the next transaction.
+		CHECK(ExternalFs::begin(fp));
+		ExternalFs::write(0x100, sizeof(data), data, fp);
+		CHECK(ExternalFs::commit());
+
+		// Nor to a write out of a transaction.
+		CHECK_EQUAL(0, ExternalFs::write(0x3000, sizeof(data), data, fp));
+		CHECK_EQUAL(1, ExternalFs::write(0x200, sizeof(data), data, fp));
+	}
+
+	fp.close();
+}
+
+
+TEST(installFailsWhenTheLogCantGrow)
+{
+	Host::makeFsRoot("external_fs_install");
+
+	ExternalFs::de_init();
+	ExternalFs::init();
+	MotionStore::init();
+	Motion::migrate();
+	MotionDirectory::init();
+
+	Motion::Header header;
+	Motion::Frame  frame;
+
+	memset(&header, 0, sizeof(header));
+	memset(&frame, 0, sizeof(frame));
+
+	header.slot         = 3;
+	header.frame_length = Motion::Header::FRAMELENGTH_MAX;
+
+	{
+		FileSizeLimit limit(fp_motion.size());
+
+		CHECK(MotionInstaller::begin(header));
+
+		for (unsigned char index = 0; index < header.frame_length; index++)
+		{
+			frame.index = index;
+			CHECK(MotionInstaller::stage(frame));
+		}
+
+		CHECK(!MotionInstaller::commit());
+	}
+
+	// The motion is not installed after a reboot.
+	ExternalFs::de_init();
+	ExternalFs::init();
+	MotionStore::init();
+	MotionDirectory::init();
+
+	CHECK(!MotionDirectory::get(3, header));
+}
+
+
+TEST(headerSetFailsWhenTheLogCantGrow)
+{
+	Host::makeFsRoot("external_fs_header");
+
+	ExternalFs::de_init();
+	ExternalFs::init();
+	MotionStore::init();
+	Motion::migrate();
+	MotionDirectory::init();
+
+	Motion::Header header;
+
+	memset(&header, 0, sizeof(header));
+
+	header.slot         = 4;
+	header.frame_length = 1;
+
+	{
+		FileSizeLimit limit(fp_motion.size());
+
+		CHECK(!header.set());
+		CHECK(!ExternalFs::inTransaction());
+	}
+
+	ExternalFs::de_init();
+	ExternalFs::init();
+	MotionStore::init();
+
+	CHECK(!header.get());
+}
+
+
+TEST(readReturnsTheWholeCount)
+{
+	Host::makeFsRoot("external_fs_read");
+
+	File fp = SPIFFS.open("/joint_cfg.bin", "w+");
+	unsigned char data[1024];
+	unsigned char read_data[1024];
+
+	fill(data, sizeof(data), 1);
+	ExternalFs::write(0, sizeof(data), data, fp);
+
+	// The counts which were narrowed to -1 or another count by a char.
+	const unsigned int SIZES[] = { 255, 256, 511, 767, 1023 };
+
+	for (unsigned int index = 0; index < sizeof(SIZES) / sizeof(SIZES[0]); index++)
+	{
+		CHECK_EQUAL(SIZES[index], ExternalFs::read(0, SIZES[index], read_data, fp));
+		CHECK(memcmp(read_data, data, SIZES[index]) == 0);
+	}
+
+	fp.close();
+
+	CHECK_EQUAL(-1, ExternalFs::read(0, 16, read_data, fp));
+}
+
+
+TEST(readAheadCacheHitRate)
+{
+	Host::makeFsRoot("external_fs_cache");
+
+	File fp = SPIFFS.open("/joint_cfg.bin", "w+");
+	unsigned char data[4 * 256 /* := ExternalFs::PAGE_SIZE() */];
+	unsigned char read_data[16];
+
+	fill(data, sizeof(data), 1);
+	ExternalFs::write(0, sizeof(data), data, fp);
+	ExternalFs::invalidate();
+
+	const unsigned long hits   = metric("cache_hits");
+	const unsigned long misses = metric("cache_misses");
+
+	// Small sequential reads, as a record is read, cost one physical read per page.
+	for (unsigned int address = 0; address < sizeof(data); address += sizeof(read_data))
+	{
+		CHECK_EQUAL(sizeof(read_data), ExternalFs::read(address, sizeof(read_data), read_data, fp));
+		CHECK(memcmp(read_data, data + address, sizeof(read_data)) == 0);
+	}
+
+	CHECK_EQUAL(4, metric("cache_misses") - misses);
+	CHECK_EQUAL(sizeof(data) / sizeof(read_data) - 4, metric("cache_hits") - hits);
+
+	// A read over the end of the file reads only the page cached, and the rest is the fill value.
+	CHECK_EQUAL(sizeof(read_data), ExternalFs::read(sizeof(data) - 8, sizeof(read_data), read_data, fp));
+	CHECK_EQUAL(ExternalFs::FILL_VALUE(), read_data[8]);
+	CHECK_EQUAL(4, metric("cache_misses") - misses);
+
+	// A write discards the page cached.
+	ExternalFs::write(0x300, sizeof(read_data), read_data, fp);
+	ExternalFs::read(0x300, sizeof(read_data), read_data, fp);
+	CHECK_EQUAL(5, metric("cache_misses") - misses);
+
+	fp.close();
+}
@@ -0,0 +1,81 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <math.h>
+
+#include "GaitGenerator.h"
+#include "Motion.h"
+#include "Trigonometry.h"
+
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		ITERATIONS = 1 << 22
+	};
+
+	const double BINARY_ANGLE_TO_RAD = 2 * M_PI / Utility::BINARY_ANGLE_1;
+}
+
+
+TEST(trigonometry)
+{
+	// The angles are walked by an odd step, so every entry of the table and the fractions between them are read.
+	Test::benchmark("sin_q15", ITERATIONS, [&](unsigned long count) {
+		Test::keep(Utility::sin_q15(count * 40503));
+	});
+
+	Test::benchmark("sin() of libm, in Q15", ITERATIONS, [&](unsigned long count) {
+		Test::keep(static_cast<int>(sin((count * 40503 & 0xFFFF) * BINARY_ANGLE_TO_RAD) * Utility::Q15_ONE));
+	});
+
+	Test::benchmark("atan2_binary", ITERATIONS, [&](unsigned long count) {
+		Test::keep(Utility::atan2_binary(static_cast<long>(count & 0xFFF) - 0x800, static_cast<long>(count >> 12 & 0xFFF) - 0x800));
+	});
+
+	Test::benchmark("atan2() of libm, in binary angle", ITERATIONS, [&](unsigned long count) {
+		Test::keep(static_cast<int>(atan2(static_cast<double>(count & 0xFFF) - 0x800, static_cast<double>(count >> 12 & 0xFFF) - 0x800) / BINARY_ANGLE_TO_RAD));
+	});
+
+	int sin_error_max = 0;
+
+	for (unsigned int angle = 0; angle < Utility::BINARY_ANGLE_1; angle++)
+	{
+		const int expected = static_cast<int>(lround(sin(angle * BINARY_ANGLE_TO_RAD) * Utility::Q15_ONE));
+
+		sin_error_max = max(sin_error_max, abs(Utility::sin_q15(angle) - expected));
+	}
+
+	printf("  sin_q15 : max error %d / %d\n", sin_error_max, Utility::Q15_ONE);
+}
+
+
+TEST(generate)
+{
+	GaitGenerator gait;
+	Motion::Frame frame;
+
+	gait.start();
+
+	// A keyframe is generated for each transition, so the cost is paid once in KEYFRAMES_PER_PERIOD of the period.
+	const double nsec = Test::benchmark("GaitGenerator::generate()", ITERATIONS / 4, [&](unsigned long) {
+		gait.generate(frame);
+		Test::keep(frame.joint_angle[0]);
+	});
+
+	const GaitGenerator::Parameters& params = gait.getParameters();
+
+	printf("  %d keyframes in %u [ms] : %.4f%% of the period\n",
+		static_cast<int>(GaitGenerator::KEYFRAMES_PER_PERIOD), params.period_ms,
+		nsec * GaitGenerator::KEYFRAMES_PER_PERIOD / (params.period_ms * 1e6) * 100);
+}
@@ -0,0 +1,291 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "System.h"
+#include "Profiler.h"
+#include "Host.h"
+
+HardwareSerial Serial;
+TwoWire        Wire;
+
+
+namespace
+{
+	//! @brief Stream which has no input, and discards the output
+	class NullStream : public Stream
+	{
+	public:
+		virtual int available()         { return 0; }
+		virtual int read()              { return -1; }
+		virtual int peek()              { return -1; }
+		virtual size_t write(uint8_t)   { return 1; }
+		using Print::write;
+	};
+
+	Host::StringStream output_stream;
+	NullStream         null_stream;
+
+	unsigned long long clock_offset_usec  = 0;
+	bool               clock_stopped      = false;
+	unsigned long long clock_stopped_usec = 0;
+
+	unsigned long long real_usec()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		return now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+	}
+
+	unsigned long long now_usec()
+	{
+		return (clock_stopped? clock_stopped_usec : real_usec()) + clock_offset_usec;
+	}
+
+	size_t print_format(Print& print, const char* format, ...)
+	{
+		char buffer[64];
+
+		va_list args;
+		va_start(args, format);
+		const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+
+		return print.write(reinterpret_cast<const uint8_t*>(buffer), min(length, static_cast<int>(sizeof(buffer)) - 1));
+	}
+
+	size_t print_integer(Print& print, unsigned long value, bool negative, int base)
+	{
+		if (base == HEX)
+		{
+			return print_format(print, "%lX", value);
+		}
+
+		return print_format(print, negative? "-%lu" : "%lu", value);
+	}
+}
+
+
+unsigned long millis()
+{
+	return now_usec() / 1000;
+}
+
+unsigned long micros()
+{
+	return now_usec();
+}
+
+void delay(unsigned long)
+{
+	// noop. (The tests don't wait for the hardware.)
+}
+
+void yield()
+{
+	// noop.
+}
+
+long random(long max_value)
+{
+	return (max_value <= 0)? 0 : (rand() % max_value);
+}
+
+long random(long min_value, long max_value)
+{
+	return min_value + random(max_value - min_value);
+}
+
+long map(long value, long from_low, long from_high, long to_low, long to_high)
+{
+	return (value - from_low) * (to_high - to_low) / (from_high - from_low) + to_low;
+}
+
+int analogRead(int)
+{
+	return 1023;
+}
+
+
+size_t Print::write(const uint8_t* data, size_t size)
+{
+	size_t result = 0;
+
+	for (size_t index = 0; index < size; index++)
+	{
+		result += write(data[index]);
+	}
+
+	return result;
+}
+
+size_t Print::write(const char* string)
+{
+	return write(reinterpret_cast<const uint8_t*>(string), strlen(string));
+}
+
+size_t Print::print(const __FlashStringHelper* string) { return write(reinterpret_cast<const char*>(string)); }
+size_t Print::print(const char* string)                { return write(string); }
+size_t Print::print(char value)                        { return write(static_cast<uint8_t>(value)); }
+size_t Print::print(int value, int base)               { return print(static_cast<long>(value), base); }
+size_t Print::print(unsigned int value, int base)      { return print(static_cast<unsigned long>(value), base); }
+size_t Print::print(unsigned long value, int base)     { return print_integer(*this, value, false, base); }
+size_t Print::print(double value, int digits)          { return print_format(*this, "%.*f", digits, value); }
+
+size_t Print::print(long value, int base)
+{
+	if (base == HEX)
+	{
+		return print_integer(*this, static_cast<unsigned long>(value), false, base);
+	}
+
+	return print_integer(*this, (value < 0)? -static_cast<unsigned long>(value) : value, value < 0, base);
+}
+
+size_t Print::println(const __FlashStringHelper* string) { return print(string) + println(); }
+size_t Print::println(const char* string)                { return print(string) + println(); }
+size_t Print::println(char value)                        { return print(value) + println(); }
+size_t Print::println(int value, int base)               { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base)      { return print(value, base) + println(); }
+size_t Print::println(long value, int base)              { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base)     { return print(value, base) + println(); }
+size_t Print::println(double value, int digits)          { return print(value, digits) + println(); }
+size_t Print::println()                                  { return write("\r\n"); }
+
+
+size_t Stream::readBytes(char buffer[], size_t size)
+{
+	return readBytes(reinterpret_cast<uint8_t*>(buffer), size);
+}
+
+size_t Stream::readBytes(uint8_t buffer[], size_t size)
+{
+	size_t count = 0;
+
+	for (int data; (count < size) && ((data = read()) >= 0); count++)
+	{
+		buffer[count] = static_cast<uint8_t>(data);
+	}
+
+	return count;
+}
+
+
+size_t HardwareSerial::write(uint8_t data)
+{
+	return fwrite(&data, 1, 1, stdout);
+}
+
+
+Host::StringStream& Host::output()
+{
+	return output_stream;
+}
+
+
+void Host::advanceClock(unsigned long msec)
+{
+	clock_offset_usec += msec * 1000ULL;
+}
+
+
+void Host::stopClock(bool stopped)
+{
+	if (stopped == clock_stopped)
+	{
+		return;
+	}
+
+	// The clock restarts from the time it stopped at, so it never goes back.
+	if (stopped)
+	{
+		clock_stopped_usec = real_usec();
+	}
+	else
+	{
+		clock_offset_usec = clock_offset_usec + clock_stopped_usec - real_usec();
+	}
+
+	clock_stopped = stopped;
+}
+
+
+std::string Host::makeFsRoot(const char* name)
+{
+	const std::string path = std::string("/tmp/plen2_test/") + name;
+
+	mkdir("/tmp/plen2_test", 0755);
+	mkdir(path.c_str(), 0755);
+
+	// The files of the tests before are removed.
+	const char* FILES[] = {
+		"/motion.bin", "/motion_log.bin", "/motion_log.tmp", "/motion_idx.bin", "/joint_cfg.bin", "/sys_cfg.bin"
+	};
+
+	for (unsigned int index = 0; index < sizeof(FILES) / sizeof(FILES[0]); index++)
+	{
+		unlink((path + FILES[index]).c_str());
+	}
+
+	setenv("PLEN2_FS_ROOT", path.c_str(), 1);
+
+	return path;
+}
+
+
+PLEN2::System::System()
+{
+	// noop.
+}
+
+Stream& PLEN2::System::BLESerial()    { return null_stream; }
+Stream& PLEN2::System::SystemSerial() { return null_stream; }
+Stream& PLEN2::System::inputSerial()  { return null_stream; }
+Stream& PLEN2::System::outputSerial() { return output_stream; }
+Stream& PLEN2::System::tcpClient()    { return null_stream; }
+
+Stream& PLEN2::System::debugSerial()
+{
+	static const bool enabled = (getenv("PLEN2_DEBUG") != NULL);
+
+	return enabled? static_cast<Stream&>(Serial) : static_cast<Stream&>(null_stream);
+}
+
+bool PLEN2::System::tcp_available() { return false; }
+char PLEN2::System::tcp_read()      { return -1; }
+bool PLEN2::System::tcp_connected() { return false; }
+
+void PLEN2::System::setup_smartconfig() {}
+void PLEN2::System::smart_config()      {}
+void PLEN2::System::StartAp()           {}
+void PLEN2::System::dump()              {}
+void PLEN2::System::handleClient(bool)  {}
+
+
+/*!
+	@note
+	The profiler is silent on the host, because DEBUG_LESS makes many methods profiled.
+*/
+Utility::Profiler::Profiler(const __FlashStringHelper*)
+{
+	// noop.
+}
+
+Utility::Profiler::~Profiler()
+{
+	// noop.
+}
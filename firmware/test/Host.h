@@ -0,0 +1,104 @@
+/*!
+	@file      Host.h
+	@brief     Host side of the Arduino core and the system, to run the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_TEST_HOST_H
+#define PLEN2_TEST_HOST_H
+
+#include <Arduino.h>
+
+
+namespace Host
+{
+	/*!
+		@brief Stream of the host
+
+		Reads give the characters pushed by input(), and writes are stored to output().
+	*/
+	class StringStream : public Stream
+	{
+	public:
+		std::string input;
+		std::string output;
+
+		StringStream()
+			: m_position(0)
+		{
+			// noop.
+		}
+
+		virtual int available()
+		{
+			return input.size() - m_position;
+		}
+
+		virtual int read()
+		{
+			return (m_position < input.size())? static_cast<unsigned char>(input[m_position++]) : -1;
+		}
+
+		virtual int peek()
+		{
+			return (m_position < input.size())? static_cast<unsigned char>(input[m_position]) : -1;
+		}
+
+		virtual size_t write(uint8_t data)
+		{
+			output.push_back(static_cast<char>(data));
+
+			return 1;
+		}
+
+		using Print::write;
+
+		void clear()
+		{
+			input.clear();
+			output.clear();
+			m_position = 0;
+		}
+
+	private:
+		size_t m_position;
+	};
+
+	/*!
+		@brief Get the stream given by System::outputSerial()
+
+		The output of the firmware is stored to it, so the tests can check it.
+		(The output of System::debugSerial() is discarded unless environment variable "PLEN2_DEBUG" is set.)
+	*/
+	StringStream& output();
+
+	/*!
+		@brief Advance millis() and micros(), as the time passes
+
+		@param [in] msec Please set the time. (msec)
+	*/
+	void advanceClock(unsigned long msec);
+
+	/*!
+		@brief Stop or restart millis() and micros()
+
+		While the clock is stopped, only advanceClock() moves it, so a test of the timing is exact.
+
+		@param [in] stopped Please set true to stop the clock.
+	*/
+	void stopClock(bool stopped);
+
+	/*!
+		@brief Make a directory for the files of the host file system, and set it to "PLEN2_FS_ROOT"
+
+		@param [in] name Please set the name of the test. (It must be unique among the tests.)
+
+		@return Path of the directory. (The files of the firmware are removed from it.)
+	*/
+	std::string makeFsRoot(const char* name);
+}
+
+#endif // PLEN2_TEST_HOST_H
@@ -0,0 +1,121 @@
+/*!
+	@file      Kinematics.h
+	@brief     Double-precision reference of the leg kinematics.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_TEST_KINEMATICS_H
+#define PLEN2_TEST_KINEMATICS_H
+
+#include <math.h>
+
+#include "LegKinematics.h"
+
+
+namespace Kinematics
+{
+	typedef PLEN2::LegKinematics LegKinematics;
+
+	const double DEG10_TO_RAD = M_PI / 1800;
+
+	/*!
+		@brief Joint angles of a leg in double precision
+
+		The members are the same as LegKinematics::LegAngles. (Steps of degree 1/10.)
+	*/
+	class Angles
+	{
+	public:
+		double thigh_yaw;
+		double thigh_roll;
+		double thigh_pitch;
+		double knee_pitch;
+		double foot_pitch;
+		double foot_roll;
+	};
+
+	//! @brief Foot position in double precision. (1/10 [mm])
+	class Position
+	{
+	public:
+		double x;
+		double y;
+		double z;
+	};
+
+	/*!
+		@brief Solve the left leg in double precision, as the reference of LegKinematics::solve()
+
+		It follows the same geometry with sin(), atan2(), sqrt() and acos() of libm.
+	*/
+	inline bool solve(const LegKinematics::FootPose& pose, Angles& angles)
+	{
+		if (pose.z <= 0)
+		{
+			return false;
+		}
+
+		const double yaw = pose.yaw * DEG10_TO_RAD;
+
+		const double x = pose.x * cos(yaw) + pose.y * sin(yaw);
+		const double y = pose.y * cos(yaw) - pose.x * sin(yaw);
+		const double z = pose.z;
+
+		const double roll       = atan2(y, z);
+		const double z_sagittal = sqrt(y * y + z * z);
+		const double distance   = sqrt(x * x + z_sagittal * z_sagittal);
+
+		if (   (distance > LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH)
+			|| (distance < fabs(static_cast<double>(LegKinematics::THIGH_LENGTH - LegKinematics::SHIN_LENGTH))) )
+		{
+			return false;
+		}
+
+		const double cosine = (distance * distance
+			- static_cast<double>(LegKinematics::THIGH_LENGTH) * LegKinematics::THIGH_LENGTH
+			- static_cast<double>(LegKinematics::SHIN_LENGTH)  * LegKinematics::SHIN_LENGTH)
+			/ (2.0 * LegKinematics::THIGH_LENGTH * LegKinematics::SHIN_LENGTH);
+
+		const double knee  = acos(fmax(-1.0, fmin(1.0, cosine)));
+		const double alpha = atan2(LegKinematics::SHIN_LENGTH * sin(knee), LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH * cos(knee));
+		const double hip   = atan2(x, z_sagittal) + alpha;
+
+		angles.thigh_yaw   = pose.yaw;
+		angles.thigh_roll  = roll / DEG10_TO_RAD;
+		angles.thigh_pitch = hip / DEG10_TO_RAD;
+		angles.knee_pitch  = -knee / DEG10_TO_RAD;
+		angles.foot_pitch  = -(angles.thigh_pitch + angles.knee_pitch);
+		angles.foot_roll   = -angles.thigh_roll;
+
+		return true;
+	}
+
+	/*!
+		@brief Get the foot position of the left leg from its joint angles
+
+		The inverse of solve(), so the position error of the fixed-point angles is measured in the space of the foot.
+	*/
+	inline Position forward(double thigh_yaw, double thigh_roll, double thigh_pitch, double knee_pitch)
+	{
+		const double hip  = thigh_pitch * DEG10_TO_RAD;
+		const double shin = (thigh_pitch + knee_pitch) * DEG10_TO_RAD;
+		const double roll = thigh_roll * DEG10_TO_RAD;
+		const double yaw  = thigh_yaw * DEG10_TO_RAD;
+
+		const double x          = LegKinematics::THIGH_LENGTH * sin(hip) + LegKinematics::SHIN_LENGTH * sin(shin);
+		const double z_sagittal = LegKinematics::THIGH_LENGTH * cos(hip) + LegKinematics::SHIN_LENGTH * cos(shin);
+		const double y          = z_sagittal * sin(roll);
+
+		Position result;
+		result.x = x * cos(yaw) - y * sin(yaw);
+		result.y = y * cos(yaw) + x * sin(yaw);
+		result.z = z_sagittal * cos(roll);
+
+		return result;
+	}
+}
+
+#endif // PLEN2_TEST_KINEMATICS_H
@@ -0,0 +1,56 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "LegKinematics.h"
+
+#include "Kinematics.h"
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		POSE_LENGTH = 256, //!< Count of the poses solved in turn. (It must be 2^N.)
+		ITERATIONS  = 1 << 21
+	};
+}
+
+
+TEST(solvesPerSecond)
+{
+	// Reachable poses around the stance, as a gait places the feet.
+	LegKinematics::FootPose poses[POSE_LENGTH];
+
+	srand(1);
+
+	for (int index = 0; index < POSE_LENGTH; index++)
+	{
+		poses[index].x   = rand() % 401 - 200;
+		poses[index].y   = rand() % 201 - 100;
+		poses[index].z   = 550 + rand() % 201;
+		poses[index].yaw = rand() % 601 - 300;
+	}
+
+	LegKinematics::LegAngles angles;
+	Kinematics::Angles       reference;
+
+	Test::benchmark("LegKinematics::solve()", ITERATIONS, [&](unsigned long count) {
+		Test::keep(LegKinematics::solve(poses[count & (POSE_LENGTH - 1)], angles));
+		Test::keep(angles.knee_pitch);
+	});
+
+	// The host has an FPU, unlike the ESP8266 which emulates double precision, so the reference is only the scale of the host.
+	Test::benchmark("Kinematics::solve() in double precision", ITERATIONS, [&](unsigned long count) {
+		Test::keep(Kinematics::solve(poses[count & (POSE_LENGTH - 1)], reference));
+		Test::keep(reference.knee_pitch);
+	});
+}
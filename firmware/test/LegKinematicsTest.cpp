@@ -0,0 +1,182 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <math.h>
+
+#include "LegKinematics.h"
+
+#include "Kinematics.h"
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		POSES = 200000,
+
+		BOUNDARY_MARGIN = 4, //!< Distance from the limits of the reach where the solvers may disagree. (1/10 [mm])
+
+		POSITION_ERROR_MAX = 5,  //!< Max distance between the pose and the foot placed by the angles solved. (1/10 [mm])
+		ANGLE_ERROR_MAX    = 15, //!< Max error of the angles out of the singular poses. (Steps of degree 1/10.)
+
+		/*!
+			@brief Limits of the singular poses
+
+			A straight or folded knee, and a foot near the height of the hip, turn a small error of the position into a large error of the angles.
+			So the angles are compared only out of them, and the positions are compared everywhere.
+		*/
+		KNEE_MIN       = 300,
+		KNEE_MAX       = 1500,
+		SAGITTAL_MIN_Z = 200
+	};
+
+	//! @brief Make a foot pose at random, which covers the reach of the leg and some out of it.
+	void random_pose(LegKinematics::FootPose& pose)
+	{
+		pose.x   = rand() % 1601 - 800;
+		pose.y   = rand() % 1201 - 600;
+		pose.z   = rand() % 900;
+		pose.yaw = rand() % 1801 - 900;
+	}
+
+	double distance(const Kinematics::Position& position, const LegKinematics::FootPose& pose)
+	{
+		return sqrt(
+			  (position.x - pose.x) * (position.x - pose.x)
+			+ (position.y - pose.y) * (position.y - pose.y)
+			+ (position.z - pose.z) * (position.z - pose.z)
+		);
+	}
+
+	double reach(const LegKinematics::FootPose& pose)
+	{
+		return sqrt(static_cast<double>(pose.x) * pose.x + static_cast<double>(pose.y) * pose.y + static_cast<double>(pose.z) * pose.z);
+	}
+}
+
+
+TEST(referenceRoundTrips)
+{
+	srand(1);
+
+	for (int count = 0; count < POSES; count++)
+	{
+		LegKinematics::FootPose pose;
+		Kinematics::Angles      angles;
+
+		random_pose(pose);
+
+		if (Kinematics::solve(pose, angles))
+		{
+			const Kinematics::Position position = Kinematics::forward(angles.thigh_yaw, angles.thigh_roll, angles.thigh_pitch, angles.knee_pitch);
+
+			CHECK(distance(position, pose) < 1e-6);
+			CHECK(fabs(angles.thigh_pitch + angles.knee_pitch + angles.foot_pitch) < 1e-9); // The sole is parallel to the ground.
+		}
+	}
+}
+
+
+TEST(solveMatchesReference)
+{
+	double angle_error_max    = 0;
+	double position_error_max = 0;
+	long   solved             = 0;
+	long   compared           = 0;
+
+	srand(1);
+
+	for (int count = 0; count < POSES; count++)
+	{
+		LegKinematics::FootPose   pose;
+		LegKinematics::LegAngles  angles;
+		Kinematics::Angles        expected;
+
+		random_pose(pose);
+
+		const bool result   = LegKinematics::solve(pose, angles);
+		const bool reliable = (fabs(reach(pose) - (LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH)) > BOUNDARY_MARGIN);
+
+		if (!Kinematics::solve(pose, expected))
+		{
+			CHECK(!result || !reliable);
+
+			continue;
+		}
+
+		if (!result)
+		{
+			CHECK(!reliable);
+
+			continue;
+		}
+
+		solved++;
+
+		const Kinematics::Position position = Kinematics::forward(angles.thigh_yaw, angles.thigh_roll, angles.thigh_pitch, angles.knee_pitch);
+
+		position_error_max = max(position_error_max, distance(position, pose));
+
+		const double z_sagittal = pose.z / cos(expected.thigh_roll * Kinematics::DEG10_TO_RAD);
+
+		if (   (-expected.knee_pitch < KNEE_MIN)
+			|| (-expected.knee_pitch > KNEE_MAX)
+			|| (z_sagittal < SAGITTAL_MIN_Z) )
+		{
+			continue;
+		}
+
+		compared++;
+
+		const double errors[] = {
+			fabs(angles.thigh_yaw   - expected.thigh_yaw),
+			fabs(angles.thigh_roll  - expected.thigh_roll),
+			fabs(angles.thigh_pitch - expected.thigh_pitch),
+			fabs(angles.knee_pitch  - expected.knee_pitch),
+			fabs(angles.foot_pitch  - expected.foot_pitch),
+			fabs(angles.foot_roll   - expected.foot_roll)
+		};
+
+		for (unsigned int index = 0; index < sizeof(errors) / sizeof(errors[0]); index++)
+		{
+			angle_error_max = max(angle_error_max, errors[index]);
+		}
+	}
+
+	printf("  %ld poses solved : max error %.2f [1/10 mm] of the foot\n", solved, position_error_max);
+	printf("  %ld poses out of the singular poses : max error %.2f [deg/10] of the angles\n", compared, angle_error_max);
+
+	CHECK(solved > POSES / 4);
+	CHECK(compared > solved / 2);
+	CHECK(position_error_max < POSITION_ERROR_MAX);
+	CHECK(angle_error_max < ANGLE_ERROR_MAX);
+}
+
+
+TEST(unreachablePosesAreRejected)
+{
+	LegKinematics::FootPose  pose = { 0, 0, 0, 0 };
+	LegKinematics::LegAngles angles;
+
+	CHECK(!LegKinematics::solve(pose, angles)); // The foot is at the hip.
+
+	pose.z = -400;
+	CHECK(!LegKinematics::solve(pose, angles)); // The foot is above the hip.
+
+	pose.z = LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH + BOUNDARY_MARGIN;
+	CHECK(!LegKinematics::solve(pose, angles));
+
+	pose.z = LegKinematics::THIGH_LENGTH + LegKinematics::SHIN_LENGTH;
+	CHECK(LegKinematics::solve(pose, angles)); // The straight leg, within the error of CORDIC.
+	CHECK(abs(angles.thigh_pitch) <= 1);
+	CHECK_EQUAL(0, angles.knee_pitch);
+	CHECK(abs(angles.foot_pitch) <= 1);
+}
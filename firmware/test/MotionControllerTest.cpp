@@ -0,0 +1,320 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <math.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	/*!
+		@brief Motion controller which exposes the frame loaded
+	*/
+	class Player : public MotionController
+	{
+	public:
+		Player(JointController& joint_ctrl)
+			: MotionController(joint_ctrl)
+		{
+		}
+
+		const Motion::Frame& next() { return *m_frame_next_ptr; }
+
+		unsigned char transitionCount() const { return m_transition_count; }
+
+		//! @brief Get the time that the limits of the joints allow for the transition between the postures given.
+		unsigned long limitedTime(const Motion::Frame& current, const Motion::Frame& next)
+		{
+			*m_frame_current_ptr = current;
+			*m_frame_next_ptr    = next;
+
+			return m_limitedTransitionTime();
+		}
+	};
+
+	void boot()
+	{
+		ExternalFs::de_init();
+		ExternalFs::init();
+		MotionStore::init();
+		Motion::migrate();
+		MotionDirectory::init();
+	}
+
+	/*!
+		@brief Install a motion which has the index of each frame as the angle of the left shoulder pitch
+
+		The angle is multiplied by 10, so a frame is told from the posture before playing.
+	*/
+	void install(Motion::Header& header, unsigned int transition_time_ms = 100)
+	{
+		MotionInstaller::begin(header);
+
+		for (unsigned char index = 0; index < header.frame_length; index++)
+		{
+			Motion::Frame frame;
+			memset(&frame, 0, sizeof(frame));
+
+			frame.index              = index;
+			frame.transition_time_ms = transition_time_ms;
+			frame.joint_angle[JointController::LEFT_SHOULDER_PITCH] = (header.slot * 100) + (index + 1) * 10;
+
+			MotionInstaller::stage(frame);
+		}
+
+		MotionInstaller::commit();
+	}
+
+	void make_header(Motion::Header& header, unsigned char slot, unsigned char frame_length)
+	{
+		header.init();
+		header.slot         = slot;
+		header.frame_length = frame_length;
+	}
+
+	//! @brief Make a posture which has the angle given at the joint given, and 0 at the others.
+	void make_posture(Motion::Frame& frame, unsigned char joint_id, int angle)
+	{
+		memset(&frame, 0, sizeof(frame));
+
+		frame.joint_angle[joint_id] = angle;
+	}
+
+	/*!
+		@brief Time of the rest-to-rest profile of a joint in double precision, as the reference of m_limitedTransitionTime()
+
+		The distance is steps of degree 1/10, and the limits are its steps per second and per second^2.
+	*/
+	double profile_time_ms(double distance, double velocity, double acceleration)
+	{
+		if (distance == 0)
+		{
+			return 0;
+		}
+
+		// The joint reaches its max velocity at the half of the distance, and the profile is a trapezoid beyond it.
+		if (distance >= velocity * velocity / acceleration)
+		{
+			return (distance / velocity + velocity / acceleration) * 1000;
+		}
+
+		return 2 * sqrt(distance / acceleration) * 1000;
+	}
+
+	//! @brief Play the frames given, and get the marks of the frames loaded.
+	std::vector<int> walk(Player& player, unsigned char slot, unsigned char flags, unsigned char joint_id, int count)
+	{
+		std::vector<int> marks;
+
+		player.play(slot, flags);
+
+		for (int loaded = 0; loaded < count; loaded++)
+		{
+			marks.push_back(player.next().joint_angle[joint_id]);
+
+			if (!player.nextFrameLoadable())
+			{
+				break;
+			}
+
+			player.loadNextFrame();
+		}
+
+		player.stop();
+
+		return marks;
+	}
+}
+
+
+TEST(reverseLoopRunsOverTheSameFrames)
+{
+	Host::makeFsRoot("controller_loop");
+	boot();
+
+	Motion::Header header;
+	make_header(header, 0, 6);
+	header.use_loop   = 1;
+	header.loop_begin = 1;
+	header.loop_end   = 3;
+	header.loop_count = 255;
+	install(header);
+
+	JointController joint_ctrl;
+	Player          player(joint_ctrl);
+
+	const int FORWARD[] = { 10, 20, 30, 40, 20, 30, 40, 20, 30, 40 };
+	const int REVERSE[] = { 60, 50, 40, 30, 20, 40, 30, 20, 40, 30 };
+
+	CHECK(walk(player, 0, 0, JointController::LEFT_SHOULDER_PITCH, 10) == std::vector<int>(FORWARD, FORWARD + 10));
+	CHECK(walk(player, 0, MotionController::PLAY_REVERSE, JointController::LEFT_SHOULDER_PITCH, 10) == std::vector<int>(REVERSE, REVERSE + 10));
+}
+
+
+TEST(reverseLoopEndsByLoopCount)
+{
+	Host::makeFsRoot("controller_loop_count");
+	boot();
+
+	Motion::Header header;
+	make_header(header, 0, 5);
+	header.use_loop   = 1;
+	header.loop_begin = 0;
+	header.loop_end   = 1;
+	header.loop_count = 1;
+	install(header);
+
+	JointController joint_ctrl;
+	Player          player(joint_ctrl);
+
+	const int REVERSE[] = { 50, 40, 30, 20, 10, 20, 10 };
+
+	CHECK(walk(player, 0, MotionController::PLAY_REVERSE, JointController::LEFT_SHOULDER_PITCH, 20) == std::vector<int>(REVERSE, REVERSE + 7));
+}
+
+
+TEST(flagsAreKeptAcrossJump)
+{
+	Host::makeFsRoot("controller_jump");
+	boot();
+
+	Motion::Header header;
+	make_header(header, 1, 2);
+	install(header);
+
+	make_header(header, 0, 3);
+	header.use_jump  = 1;
+	header.jump_slot = 1;
+	install(header);
+
+	JointController joint_ctrl;
+	Player          player(joint_ctrl);
+
+	const int FORWARD[] = { 10, 20, 30, 110, 120 };
+	const int MIRROR[]  = { -10, -20, -30, -110, -120 };
+	const int REVERSE[] = { 30, 20, 10, 120, 110 };
+
+	CHECK(walk(player, 0, 0, JointController::LEFT_SHOULDER_PITCH, 10) == std::vector<int>(FORWARD, FORWARD + 5));
+	CHECK(walk(player, 0, MotionController::PLAY_MIRROR, JointController::RIGHT_SHOULDER_PITCH, 10) == std::vector<int>(MIRROR, MIRROR + 5));
+	CHECK(walk(player, 0, MotionController::PLAY_REVERSE, JointController::LEFT_SHOULDER_PITCH, 10) == std::vector<int>(REVERSE, REVERSE + 5));
+}
+
+
+TEST(limitedTimeFollowsTrapezoidAndTriangle)
+{
+	Host::makeFsRoot("controller_limits");
+	boot();
+
+	JointController joint_ctrl;
+	Player          player(joint_ctrl);
+	Motion::Frame   current;
+	Motion::Frame   next;
+
+	// The defaults reach the max velocity of 4000 [1/10 deg/s] in 100 [ms] over 200 steps, which parts the profiles at 400 steps.
+	make_posture(current, JointController::LEFT_SHOULDER_PITCH, 0);
+
+	make_posture(next, JointController::LEFT_SHOULDER_PITCH, 0);
+	CHECK_EQUAL(0, player.limitedTime(current, next));
+
+	make_posture(next, JointController::LEFT_SHOULDER_PITCH, 100);
+	CHECK_EQUAL(100, player.limitedTime(current, next)); // Triangle : 2 * sqrt(100 / 40000) [s]
+
+	make_posture(next, JointController::LEFT_SHOULDER_PITCH, 400);
+	CHECK_EQUAL(200, player.limitedTime(current, next)); // Both profiles meet.
+
+	make_posture(next, JointController::LEFT_SHOULDER_PITCH, -1000);
+	CHECK_EQUAL(350, player.limitedTime(current, next)); // Trapezoid : 1000 / 4000 + 4000 / 40000 [s]
+
+	// The slowest joint limits the transition.
+	CHECK(joint_ctrl.setMotionLimits(JointController::RIGHT_FOOT_ROLL, 1000, 2000));
+
+	next.joint_angle[JointController::RIGHT_FOOT_ROLL] = 100;
+	CHECK_EQUAL(446, player.limitedTime(current, next)); // Triangle : 2 * sqrt(100 / 2000) [s], by the integer square root
+
+	next.joint_angle[JointController::RIGHT_FOOT_ROLL] = 900;
+	CHECK_EQUAL(1400, player.limitedTime(current, next)); // Trapezoid : 900 / 1000 + 1000 / 2000 [s]
+
+	// The integer profile stays within the rounding of the reference, up to the widest limits.
+	srand(1);
+
+	for (int count = 0; count < 100000; count++)
+	{
+		const int angle        = rand() % 3601 - 1800;
+		const int velocity     = 1 + rand() % 0xFFFF;
+		const int acceleration = 1 + rand() % 0xFFFF;
+
+		CHECK(joint_ctrl.setMotionLimits(JointController::LEFT_SHOULDER_PITCH, velocity, acceleration));
+		make_posture(next, JointController::LEFT_SHOULDER_PITCH, angle);
+
+		const double expected = profile_time_ms(abs(angle), velocity, acceleration);
+		const double actual   = player.limitedTime(current, next);
+
+		CHECK((actual <= expected + 1e-6) && (actual >= expected - 2));
+	}
+}
+
+
+TEST(transitionCountIsClampedToTheCounter)
+{
+	Host::makeFsRoot("controller_count");
+	boot();
+
+	// Each motion has a time, and the count of the updates is clamped to 1..255. (It wrapped over 255, and got 0 under 40 [ms].)
+	const unsigned int TIMES[]  = { 0, 20, 40, 80, 10200, 10239, 10240, 12000, 65535 };
+	const int          COUNTS[] = { 1,  1,  1,  2,   255,   255,   255,   255,   255 };
+	const int          LENGTH   = sizeof(TIMES) / sizeof(TIMES[0]);
+
+	Motion::Header header;
+
+	for (int slot = 0; slot < LENGTH; slot++)
+	{
+		make_header(header, slot, 1);
+		install(header, TIMES[slot]);
+	}
+
+	JointController joint_ctrl;
+	Player          player(joint_ctrl);
+
+	for (int slot = 0; slot < LENGTH; slot++)
+	{
+		player.play(slot, 0);
+		CHECK(player.playing());
+		CHECK_EQUAL(COUNTS[slot], player.transitionCount());
+		player.stop();
+	}
+
+	/*
+		Retiming stretches a short transition to the limits, and rounds it up to the updates.
+		(The frame of slot 8 is 810 steps from the posture before playing, so the trapezoid takes 302.5 [ms].)
+		Stopping keeps the posture reached, so each case starts from a new controller.
+	*/
+	make_header(header, 8, 1);
+	install(header, 100);
+
+	Player planned(joint_ctrl);
+
+	planned.play(8, 0);
+	CHECK_EQUAL(2, planned.transitionCount());
+
+	Player retimed(joint_ctrl);
+
+	retimed.setRetiming(true);
+	retimed.play(8, 0);
+	CHECK_EQUAL(8, retimed.transitionCount());
+}
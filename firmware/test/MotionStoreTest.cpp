@@ -0,0 +1,978 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <map>
+#include <unistd.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionPack.h"
+#include "MotionStore.h"
+
+#include "Test.h"
+
+extern File fp_motion;
+
+using namespace PLEN2;
+
+
+namespace
+{
+	/*!
+		@brief Boot the storage, as the firmware does in setup()
+	*/
+	void boot()
+	{
+		ExternalFs::de_init();
+		ExternalFs::init();
+		MotionStore::init();
+		Motion::migrate();
+		MotionDirectory::init();
+	}
+
+	std::string read_file(const std::string& path)
+	{
+		std::string result;
+		FILE* fp = fopen(path.c_str(), "rb");
+
+		if (fp != NULL)
+		{
+			char buffer[4096];
+
+			for (size_t size; (size = fread(buffer, 1, sizeof(buffer), fp)) > 0; )
+			{
+				result.append(buffer, size);
+			}
+
+			fclose(fp);
+		}
+
+		return result;
+	}
+
+	void make_header(Motion::Header& header, unsigned char slot, unsigned char frame_length)
+	{
+		memset(&header, 0, sizeof(header));
+
+		header.slot         = slot;
+		header.frame_length = frame_length;
+		header.loop_count   = 255;
+		snprintf(header.name, Motion::Header::NAME_LENGTH, "motion %d", slot);
+	}
+
+	/*!
+		@note
+		The tail bytes which the layout version 1 never stored are set to the fill value,
+		so the frame is the same after the migration.
+	*/
+	void make_frame(Motion::Frame& frame, unsigned char slot, unsigned char index)
+	{
+		memset(&frame, ExternalFs::FILL_VALUE(), sizeof(frame));
+
+		frame.index              = index;
+		frame.transition_time_ms = 100 + index;
+
+		for (int joint = 0; joint < JointController::SUM; joint++)
+		{
+			frame.joint_angle[joint] = (slot * 7 + index * 13 + joint * 17) % 1600 - 800;
+		}
+
+		frame.device_value[0] = slot;
+		frame.device_value[1] = index;
+	}
+
+	/*!
+		@brief Write a record with the splitting of the layout version 1
+
+		It is the writer of Legacy::read() in Motion.cpp.
+	*/
+	void write_legacy(File fp, unsigned int chunk, unsigned int size, const void* record)
+	{
+		const unsigned int CHUNK_SIZE = 32;
+		const unsigned int PIECE_SIZE = 30;
+
+		const unsigned char* data = static_cast<const unsigned char*>(record);
+		const unsigned int chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		for (unsigned int count = 0; count < chunks; count++)
+		{
+			unsigned int piece_size = PIECE_SIZE;
+
+			if (   (count == chunks - 1)
+				&& (size % CHUNK_SIZE) )
+			{
+				piece_size = size % CHUNK_SIZE;
+			}
+
+			piece_size = min(piece_size, size - count * PIECE_SIZE);
+
+			ExternalFs::write((chunk + count) * CHUNK_SIZE, piece_size, data + count * PIECE_SIZE, fp);
+		}
+	}
+
+	/*!
+		@brief Make the motion file of the layout version 1 which has the motions given
+
+		The file is formatted as the firmware of the layout version 1 did,
+		which wrote blocks of BUF_SIZE bytes whose first byte is 1 and the rest are 0.
+	*/
+	void make_legacy_file(const unsigned char slots[], const unsigned char frame_lengths[], int count)
+	{
+		const unsigned int CHUNK_SIZE    = 32;
+		const unsigned int CHUNKS_HEADER = (sizeof(Motion::Header) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		const unsigned int CHUNKS_FRAME  = (sizeof(Motion::Frame) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		const unsigned int CHUNKS_MOTION = CHUNKS_HEADER + CHUNKS_FRAME * Motion::Header::FRAMELENGTH_MAX;
+
+		File fp = SPIFFS.open(MOTION_FILE_LEGACY, "w+");
+
+		unsigned char block[BUF_SIZE] = { 1 };
+
+		for (unsigned int address = 0; address < Motion::SLOT_END * CHUNKS_MOTION * CHUNK_SIZE; address += BUF_SIZE)
+		{
+			ExternalFs::write(address, BUF_SIZE, block, fp);
+		}
+
+		for (int motion = 0; motion < count; motion++)
+		{
+			Motion::Header header;
+			make_header(header, slots[motion], frame_lengths[motion]);
+			write_legacy(fp, slots[motion] * CHUNKS_MOTION, sizeof(header), &header);
+
+			for (unsigned char index = 0; index < frame_lengths[motion]; index++)
+			{
+				Motion::Frame frame;
+				make_frame(frame, slots[motion], index);
+				write_legacy(fp, slots[motion] * CHUNKS_MOTION + CHUNKS_HEADER + index * CHUNKS_FRAME, sizeof(frame), &frame);
+			}
+		}
+
+		fp.close();
+		ExternalFs::invalidate();
+	}
+
+	void check_motion(unsigned char slot, unsigned char frame_length)
+	{
+		Motion::Header expected_header;
+		Motion::Header header;
+
+		make_header(expected_header, slot, frame_length);
+		header.slot = slot;
+
+		CHECK(header.get());
+		CHECK(memcmp(&header, &expected_header, sizeof(header)) == 0);
+
+		for (unsigned char index = 0; index < frame_length; index++)
+		{
+			Motion::Frame expected_frame;
+			Motion::Frame frame;
+
+			make_frame(expected_frame, slot, index);
+			frame.index = index;
+
+			CHECK(frame.get(slot));
+			CHECK(memcmp(&frame, &expected_frame, sizeof(frame)) == 0);
+		}
+	}
+
+	void install(unsigned char slot, unsigned char frame_length)
+	{
+		Motion::Header header;
+		make_header(header, slot, frame_length);
+
+		CHECK(MotionInstaller::begin(header));
+
+		for (unsigned char index = 0; index < frame_length; index++)
+		{
+			Motion::Frame frame;
+			make_frame(frame, slot, index);
+
+			CHECK(MotionInstaller::stage(frame));
+		}
+
+		CHECK(MotionInstaller::commit());
+	}
+
+	/*!
+		@brief Find the latest record of the log
+
+		@return Position of the record, or -1 if it is not found.
+	*/
+	long find_record(const std::string& log, unsigned char type, unsigned char slot, unsigned char index)
+	{
+		const unsigned int ALIGNMENT = 16;
+		long result = -1;
+
+		for (unsigned int position = ALIGNMENT; position + 4 <= log.size(); position += ALIGNMENT)
+		{
+			if (   (static_cast<unsigned char>(log[position]) == 0xA5 /* := RECORD_MAGIC */)
+				&& (log[position + 1] == type)
+				&& (log[position + 2] == slot)
+				&& (log[position + 3] == index) )
+			{
+				result = position;
+			}
+		}
+
+		return result;
+	}
+
+	//! @brief Flip the bits of a byte of a file, as a corruption of the flash.
+	void corrupt(const std::string& path, long position)
+	{
+		FILE* fp = fopen(path.c_str(), "r+b");
+
+		fseek(fp, position, SEEK_SET);
+		const int data = fgetc(fp);
+		fseek(fp, position, SEEK_SET);
+		fputc(data ^ 0xFF, fp);
+
+		fclose(fp);
+	}
+
+	void write_file(const std::string& path, const std::string& data)
+	{
+		FILE* fp = fopen(path.c_str(), "wb");
+
+		fwrite(data.data(), 1, data.size(), fp);
+		fclose(fp);
+	}
+
+	/*!
+		@brief Get a metric of the store
+
+		@param [in] name Please set the name of the metric in the output of MotionStore::dump().
+	*/
+	unsigned long metric(const char* name)
+	{
+		Host::output().clear();
+		MotionStore::dump();
+
+		const std::string key = std::string("\"") + name + "\": ";
+		const size_t position = Host::output().output.find(key);
+
+		return (position == std::string::npos)? 0 : strtoul(Host::output().output.c_str() + position + key.size(), NULL, 10);
+	}
+
+	//! @brief Let the log be quiet, so MotionStore::idle() writes a checkpoint.
+	void checkpoint()
+	{
+		Host::advanceClock(2000 /* := CHECKPOINT_DELAY_MS */);
+		MotionStore::idle();
+	}
+
+	/*!
+		@brief Image of the files of the store, as they are on the flash when the power is cut
+
+		A file which is not in the image doesn't exist.
+	*/
+	typedef std::map<std::string, std::string> Image;
+
+	Image take_image(const std::string& root)
+	{
+		const char* FILES[] = { MOTION_FILE, MOTION_FILE_COMPACTING, MOTION_CHECKPOINT_FILE, CONFIG_FILE, SYSCFG_FILE };
+		Image result;
+
+		for (unsigned int index = 0; index < sizeof(FILES) / sizeof(FILES[0]); index++)
+		{
+			if (access((root + FILES[index]).c_str(), F_OK) == 0)
+			{
+				result[FILES[index]] = read_file(root + FILES[index]);
+			}
+		}
+
+		return result;
+	}
+
+	/*!
+		@brief Boot the storage from the image given
+
+		The image is written to a new directory, so the files opened before are not changed.
+	*/
+	std::string power_on(const char* name, const Image& image)
+	{
+		const std::string root = Host::makeFsRoot(name);
+
+		for (Image::const_iterator file = image.begin(); file != image.end(); ++file)
+		{
+			write_file(root + file->first, file->second);
+		}
+
+		Host::output().clear();
+		boot();
+
+		return root;
+	}
+
+	/*!
+		@brief Rewrite a motion until compaction is needed
+
+		The other motions given are installed first, so they are copied by the compaction.
+	*/
+	void fill_log()
+	{
+		install(1, 5);
+		install(2, 5);
+
+		while (metric("log_end") <= 0x40000 /* := COMPACTION_THRESHOLD */)
+		{
+			install(0, Motion::Header::FRAMELENGTH_MAX);
+		}
+	}
+
+	void check_filled_log()
+	{
+		check_motion(0, Motion::Header::FRAMELENGTH_MAX);
+		check_motion(1, 5);
+		check_motion(2, 5);
+	}
+
+	const unsigned char LEGACY_SLOTS[]         = { 0, 5, 44, 89 };
+	const unsigned char LEGACY_FRAME_LENGTHS[] = { 1, 20, 7, 3 };
+	const int           LEGACY_COUNT           = sizeof(LEGACY_SLOTS);
+}
+
+
+TEST(migrateLegacyLayout)
+{
+	const std::string root = Host::makeFsRoot("migrate");
+
+	boot();
+	make_legacy_file(LEGACY_SLOTS, LEGACY_FRAME_LENGTHS, LEGACY_COUNT);
+
+	Host::output().clear();
+	boot();
+
+	CHECK(Host::output().output.find(" : 4 motions in ") != std::string::npos);
+	CHECK(!SPIFFS.exists(MOTION_FILE_LEGACY));
+
+	for (int motion = 0; motion < LEGACY_COUNT; motion++)
+	{
+		check_motion(LEGACY_SLOTS[motion], LEGACY_FRAME_LENGTHS[motion]);
+	}
+
+	// The slots which were not installed are not migrated.
+	Motion::Header header;
+	header.slot = 1;
+
+	CHECK(!header.get());
+	CHECK(!MotionDirectory::get(1, header));
+}
+
+
+TEST(migrationSurvivesReboot)
+{
+	const std::string root = Host::makeFsRoot("migrate_reboot");
+
+	boot();
+	make_legacy_file(LEGACY_SLOTS, LEGACY_FRAME_LENGTHS, LEGACY_COUNT);
+	boot();
+
+	const std::string log = read_file(root + MOTION_FILE);
+
+	Host::output().clear();
+	boot();
+
+	// Nothing is migrated again, and the log is not changed by the boot.
+	CHECK(Host::output().output.find("migrate") == std::string::npos);
+	CHECK(read_file(root + MOTION_FILE) == log);
+
+	for (int motion = 0; motion < LEGACY_COUNT; motion++)
+	{
+		check_motion(LEGACY_SLOTS[motion], LEGACY_FRAME_LENGTHS[motion]);
+	}
+}
+
+
+TEST(migrationIsDeterministic)
+{
+	std::string logs[2];
+
+	for (int run = 0; run < 2; run++)
+	{
+		const std::string root = Host::makeFsRoot(run? "migrate_b" : "migrate_a");
+
+		boot();
+		make_legacy_file(LEGACY_SLOTS, LEGACY_FRAME_LENGTHS, LEGACY_COUNT);
+		boot();
+
+		logs[run] = read_file(root + MOTION_FILE);
+	}
+
+	CHECK(!logs[0].empty());
+	CHECK(logs[0] == logs[1]);
+}
+
+
+TEST(migrateEmptyLegacyFile)
+{
+	Host::makeFsRoot("migrate_empty");
+
+	boot();
+	make_legacy_file(LEGACY_SLOTS, LEGACY_FRAME_LENGTHS, 0);
+
+	Host::output().clear();
+	boot();
+
+	CHECK(Host::output().output.find(" : 0 motions in ") != std::string::npos);
+	CHECK(!SPIFFS.exists(MOTION_FILE_LEGACY));
+
+	for (int slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+	{
+		Motion::Header header;
+		CHECK(!MotionDirectory::get(slot, header));
+	}
+}
+
+
+TEST(replaySkipsCorruptRecordInTheMiddle)
+{
+	const std::string root = Host::makeFsRoot("replay_corrupt");
+
+	boot();
+	install(1, 5);
+	install(2, 5);
+	install(3, 5);
+
+	const std::string log = read_file(root + MOTION_FILE);
+
+	// A joint angle of the frame 2 of slot 2.
+	corrupt(root + MOTION_FILE, find_record(log, MotionStore::TYPE_FRAME, 2, 2) + 4 + 8);
+
+	Host::output().clear();
+	boot();
+
+	CHECK(Host::output().output.find("skip corrupt record") != std::string::npos);
+	CHECK(Host::output().output.find("torn tail") == std::string::npos);
+	CHECK_EQUAL(log.size(), read_file(root + MOTION_FILE).size());
+
+	// The records after the corrupt one are replayed.
+	check_motion(1, 5);
+	check_motion(3, 5);
+
+	Motion::Header header;
+	Motion::Frame  frame;
+
+	CHECK(!MotionDirectory::get(2, header));
+
+	frame.index = 2;
+	CHECK(!frame.get(2));
+
+	frame.index = 3;
+	CHECK(frame.get(2));
+
+	// Installing the slot again makes it sound.
+	install(2, 5);
+	CHECK(MotionDirectory::get(2, header));
+	check_motion(2, 5);
+}
+
+
+TEST(replaySkipsCorruptHeadInTheMiddle)
+{
+	const std::string root = Host::makeFsRoot("replay_corrupt_head");
+
+	boot();
+	install(1, 3);
+	install(2, 3);
+
+	const std::string log = read_file(root + MOTION_FILE);
+
+	// The magic of the frame 0 of slot 2, so the entry is unknown.
+	corrupt(root + MOTION_FILE, find_record(log, MotionStore::TYPE_FRAME, 2, 0));
+
+	boot();
+
+	CHECK_EQUAL(log.size(), read_file(root + MOTION_FILE).size());
+	check_motion(1, 3);
+
+	Motion::Frame frame;
+	frame.index = 1;
+
+	CHECK(frame.get(2));
+}
+
+
+TEST(replayDiscardsCorruptLastRecord)
+{
+	const std::string root = Host::makeFsRoot("replay_corrupt_last");
+
+	boot();
+	install(1, 3);
+	install(2, 3);
+
+	const std::string log   = read_file(root + MOTION_FILE);
+	const long        last  = find_record(log, MotionStore::TYPE_HEADER, 2, 0);
+
+	// The header of slot 2 is the last record, so it is a torn tail.
+	corrupt(root + MOTION_FILE, last + 4);
+
+	Host::output().clear();
+	boot();
+
+	CHECK(Host::output().output.find("torn tail") != std::string::npos);
+	CHECK_EQUAL(last, read_file(root + MOTION_FILE).size());
+
+	check_motion(1, 3);
+
+	Motion::Header header;
+	CHECK(!MotionDirectory::get(2, header));
+}
+
+
+TEST(replayDiscardsTornTail)
+{
+	const std::string root = Host::makeFsRoot("replay_torn");
+
+	boot();
+	install(1, 3);
+	install(2, 3);
+
+	const std::string log  = read_file(root + MOTION_FILE);
+	const long        last = find_record(log, MotionStore::TYPE_HEADER, 2, 0);
+
+	// The power is cut while the last record is written, so the file ends in the middle of it.
+	CHECK_EQUAL(0, truncate((root + MOTION_FILE).c_str(), last + 20));
+
+	Host::output().clear();
+	boot();
+
+	CHECK(Host::output().output.find("torn tail") != std::string::npos);
+	CHECK(Host::output().output.find("skip corrupt record") == std::string::npos);
+	CHECK_EQUAL(last, read_file(root + MOTION_FILE).size());
+
+	check_motion(1, 3);
+
+	Motion::Header header;
+	CHECK(!MotionDirectory::get(2, header));
+
+	// The log is appended from the end of the sound records.
+	install(2, 3);
+	boot();
+
+	check_motion(1, 3);
+	check_motion(2, 3);
+}
+
+
+TEST(interruptedReinstall)
+{
+	const std::string root = Host::makeFsRoot("reinstall");
+
+	boot();
+	install(1, 3);
+	install(2, 3);
+	checkpoint();
+
+	const Image         before    = take_image(root);
+	const unsigned long erase_end = read_file(root + MOTION_FILE).size() + 16 /* := record_size(TYPE_ERASE) */;
+
+	// The motion of slot 2 is installed again with other frames, so a header with the frames of another motion is found.
+	Motion::Header header;
+	make_header(header, 2, 5);
+
+	CHECK(MotionInstaller::begin(header));
+
+	for (unsigned char index = 0; index < header.frame_length; index++)
+	{
+		Motion::Frame frame;
+		make_frame(frame, 2, index);
+		frame.transition_time_ms += 1000;
+
+		CHECK(MotionInstaller::stage(frame));
+	}
+
+	CHECK(MotionInstaller::commit());
+
+	const std::string log = read_file(root + MOTION_FILE);
+
+	CHECK_EQUAL(MotionStore::TYPE_ERASE, log[erase_end - 16 + 1]);
+	CHECK(find_record(log, MotionStore::TYPE_HEADER, 2, 0) > find_record(log, MotionStore::TYPE_FRAME, 2, 4));
+
+	// The power is cut at every point of the commit, as the pages are written back in the order of the log.
+	for (unsigned long cut = before.at(MOTION_FILE).size(); cut <= log.size(); cut += 8)
+	{
+		Image image = before;
+		image[MOTION_FILE] = log.substr(0, cut);
+
+		power_on("reinstall_cut", image);
+
+		check_motion(1, 3);
+
+		header.slot = 2;
+
+		if (cut < erase_end)
+		{
+			check_motion(2, 3);
+		}
+		else if (cut < log.size())
+		{
+			CHECK(!header.get());
+			CHECK(!MotionDirectory::get(2, header));
+		}
+		else
+		{
+			CHECK(header.get());
+			CHECK_EQUAL(5, header.frame_length);
+
+			for (unsigned char index = 0; index < header.frame_length; index++)
+			{
+				Motion::Frame frame;
+				frame.index = index;
+
+				CHECK(frame.get(2));
+				CHECK_EQUAL(1100 + index, frame.transition_time_ms);
+			}
+		}
+	}
+}
+
+
+TEST(interruptedCheckpoint)
+{
+	const std::string root = Host::makeFsRoot("checkpoint");
+
+	boot();
+	install(1, 3);
+	checkpoint();
+
+	const std::string older = read_file(root + MOTION_CHECKPOINT_FILE);
+
+	install(2, 3);
+	install(3, 3);
+	checkpoint();
+
+	const Image  image       = take_image(root);
+	const std::string newer  = image.at(MOTION_CHECKPOINT_FILE);
+	const size_t HEADER_SIZE = 3 * sizeof(unsigned long); // := sizeof(CheckpointHeader)
+
+	CHECK_EQUAL(older.size(), newer.size());
+	CHECK(older != newer);
+
+	const char* NAMES[] = { "checkpoint_index", "checkpoint_index_torn", "checkpoint_header_torn" };
+	Image torn[3] = { image, image, image };
+
+	// The index is written, but the header is not.
+	torn[0][MOTION_CHECKPOINT_FILE] = older.substr(0, HEADER_SIZE) + newer.substr(HEADER_SIZE);
+
+	// The power is cut while the index is written.
+	const size_t half = HEADER_SIZE + (newer.size() - HEADER_SIZE) / 2;
+	torn[1][MOTION_CHECKPOINT_FILE] = older.substr(0, HEADER_SIZE) + newer.substr(HEADER_SIZE, half - HEADER_SIZE) + older.substr(half);
+
+	// The power is cut while the header is written.
+	torn[2][MOTION_CHECKPOINT_FILE] = newer;
+	torn[2][MOTION_CHECKPOINT_FILE][0] ^= 0xFF;
+
+	for (int state = 0; state < 3; state++)
+	{
+		const std::string torn_root = power_on(NAMES[state], torn[state]);
+
+		// The log is not changed, and every motion is restored by the replay.
+		CHECK(read_file(torn_root + MOTION_FILE) == image.at(MOTION_FILE));
+		CHECK(Host::output().output.find("torn tail") == std::string::npos);
+
+		check_motion(1, 3);
+		check_motion(2, 3);
+		check_motion(3, 3);
+	}
+}
+
+
+TEST(interruptedCompaction)
+{
+	const std::string root = Host::makeFsRoot("compaction");
+
+	boot();
+	fill_log();
+	checkpoint();
+
+	const unsigned long generation  = metric("generation");
+	const unsigned long compactions = metric("compactions");
+
+	// The images are taken before each step, until the step which replaces the log.
+	Image partial;
+	Image completed;
+
+	for (int step = 0; metric("compactions") == compactions; step++)
+	{
+		completed = take_image(root);
+
+		if (step == 2)
+		{
+			partial = completed;
+		}
+
+		MotionStore::idle();
+	}
+
+	const Image compacted = take_image(root);
+
+	CHECK(partial.count(MOTION_FILE_COMPACTING));
+	CHECK(completed.count(MOTION_FILE_COMPACTING));
+	CHECK(partial.at(MOTION_FILE_COMPACTING).size() < completed.at(MOTION_FILE_COMPACTING).size());
+	CHECK(compacted.at(MOTION_FILE).size() < completed.at(MOTION_FILE).size());
+
+	// The power is cut in the middle of the compaction, or before the log is removed.
+	power_on("compaction_partial", partial);
+	CHECK_EQUAL(generation, metric("generation"));
+	CHECK(!SPIFFS.exists(MOTION_FILE_COMPACTING));
+	check_filled_log();
+
+	power_on("compaction_completed", completed);
+	CHECK_EQUAL(generation, metric("generation"));
+	CHECK(!SPIFFS.exists(MOTION_FILE_COMPACTING));
+	check_filled_log();
+
+	// The log is removed, but the new log is not renamed.
+	Image removed = completed;
+	removed.erase(MOTION_FILE);
+
+	std::string state_root = power_on("compaction_removed", removed);
+	CHECK_EQUAL(generation + 1, metric("generation"));
+	CHECK(read_file(state_root + MOTION_FILE) == completed.at(MOTION_FILE_COMPACTING));
+	check_filled_log();
+
+	// The new log is renamed, but the checkpoint of it is not written.
+	Image renamed = completed;
+	renamed[MOTION_FILE] = completed.at(MOTION_FILE_COMPACTING);
+	renamed.erase(MOTION_FILE_COMPACTING);
+
+	state_root = power_on("compaction_renamed", renamed);
+	CHECK_EQUAL(generation + 1, metric("generation"));
+	CHECK(read_file(state_root + MOTION_FILE) == completed.at(MOTION_FILE_COMPACTING));
+	check_filled_log();
+
+	// The checkpoint of the old log is not applied to the new log.
+	install(3, 3);
+	boot();
+	check_filled_log();
+	check_motion(3, 3);
+}
+
+
+TEST(writeAmplification)
+{
+	Host::makeFsRoot("write_amplification");
+	boot();
+
+	const unsigned long RECORD_HEADER = (4 + sizeof(Motion::Header) + 4 + 15) / 16 * 16;
+	const unsigned long RECORD_FRAME  = (4 + sizeof(Motion::Frame)  + 4 + 15) / 16 * 16;
+
+	unsigned long logical  = metric("logical_bytes");
+	unsigned long physical = metric("physical_bytes");
+
+	for (unsigned char slot = 10; slot < 20; slot++)
+	{
+		install(slot, Motion::Header::FRAMELENGTH_MAX);
+	}
+
+	// A record costs its head, CRC-32 and padding, and nothing else is written.
+	CHECK_EQUAL(10 * (sizeof(Motion::Header) + Motion::Header::FRAMELENGTH_MAX * sizeof(Motion::Frame)), metric("logical_bytes") - logical);
+	CHECK_EQUAL(10 * (RECORD_HEADER + Motion::Header::FRAMELENGTH_MAX * RECORD_FRAME), metric("physical_bytes") - physical);
+
+	printf("  installing : %.2f physical bytes per logical byte\n",
+		static_cast<double>(metric("physical_bytes") - physical) / (metric("logical_bytes") - logical));
+
+	// A compaction copies only the live records, and the checkpoint.
+	logical  = metric("logical_bytes");
+	physical = metric("physical_bytes");
+
+	fill_log();
+
+	const unsigned long compactions = metric("compactions");
+
+	while (metric("compactions") == compactions)
+	{
+		MotionStore::idle();
+	}
+
+	const unsigned long live_bytes = metric("live_bytes");
+
+	CHECK_EQUAL(16 /* := LOG_BEGIN */ + live_bytes, metric("log_end"));
+	CHECK(metric("physical_bytes") - physical <= (metric("logical_bytes") - logical) * 115 / 100 + live_bytes + 4096);
+
+	printf("  rewriting with a compaction : %.2f physical bytes per logical byte\n",
+		static_cast<double>(metric("physical_bytes") - physical) / (metric("logical_bytes") - logical));
+
+	check_filled_log();
+	boot();
+	check_filled_log();
+}
+
+
+TEST(exportBreaksOnMotionRewritten)
+{
+	Host::makeFsRoot("export_rewritten");
+	boot();
+
+	install(1, 5);
+	install(2, 5);
+
+	unsigned char chunk[64];
+
+	// A whole export reads the size told at the beginning.
+	unsigned long size  = MotionPack::beginExport();
+	unsigned long bytes = 0;
+
+	for (unsigned int length; (length = MotionPack::readChunk(chunk, sizeof(chunk))) > 0; )
+	{
+		bytes += length;
+	}
+
+	CHECK(MotionPack::end());
+	CHECK_EQUAL(size, bytes);
+
+	// The frames of slot 2 are shortened after the export began, so its header no longer matches the pack.
+	size  = MotionPack::beginExport();
+	bytes = MotionPack::readChunk(chunk, 8 /* := PACK_HEADER_SIZE */);
+
+	install(2, 3);
+
+	for (unsigned int length; (length = MotionPack::readChunk(chunk, sizeof(chunk))) > 0; )
+	{
+		bytes += length;
+	}
+
+	CHECK(!MotionPack::end());
+	CHECK(bytes < size);
+}
+
+
+TEST(importInstallsWholeMotionsOnly)
+{
+	Host::makeFsRoot("import_source");
+	boot();
+
+	install(1, 5);
+	install(2, 5);
+
+	std::string pack;
+	unsigned char chunk[64];
+
+	MotionPack::beginExport();
+
+	for (unsigned int length; (length = MotionPack::readChunk(chunk, sizeof(chunk))) > 0; )
+	{
+		pack.append(reinterpret_cast<const char*>(chunk), length);
+	}
+
+	CHECK(MotionPack::end());
+
+	// The pack is cut in the middle of the frames of slot 2, after the frames of slot 1.
+	const unsigned int FRAME_SIZE = 2 + 2 * JointController::SUM;
+	const unsigned int cut        = 8 + 2 * sizeof(Motion::Header) + 5 * FRAME_SIZE + 2 * FRAME_SIZE;
+
+	Host::makeFsRoot("import_destination");
+	boot();
+
+	MotionPack::beginImport();
+	CHECK(MotionPack::writeChunk(reinterpret_cast<const unsigned char*>(pack.data()), cut));
+	CHECK(!MotionPack::importFinished());
+	CHECK(!MotionPack::end());
+
+	Motion::Header header;
+
+	CHECK(MotionDirectory::get(1, header));
+	CHECK_EQUAL(5, header.frame_length);
+	CHECK(!MotionDirectory::get(2, header));
+
+	// Nothing of slot 2 is in the store, not even its header.
+	header.slot = 2;
+	CHECK(!header.get());
+
+	// The whole pack installs both.
+	MotionPack::beginImport();
+
+	for (unsigned int position = 0; position < pack.size(); position += 50)
+	{
+		CHECK(MotionPack::writeChunk(reinterpret_cast<const unsigned char*>(pack.data()) + position, min(50U, static_cast<unsigned int>(pack.size() - position))));
+	}
+
+	CHECK(MotionPack::importFinished());
+	CHECK(MotionPack::end());
+	CHECK(MotionDirectory::get(2, header));
+	CHECK_EQUAL(5, header.frame_length);
+
+	boot();
+
+	CHECK(MotionDirectory::get(1, header));
+	CHECK(MotionDirectory::get(2, header));
+}
+
+
+TEST(installOfAnotherChannelIsRejected)
+{
+	Host::makeFsRoot("install_channels");
+	boot();
+
+	// The instances of the input channels own the installs.
+	const char channel_a = 'A';
+	const char channel_b = 'B';
+
+	Motion::Header header_a;
+	Motion::Header header_b;
+	Motion::Frame  frame;
+
+	make_header(header_a, 1, 3);
+	make_header(header_b, 2, 3);
+
+	CHECK(MotionInstaller::begin(header_a, &channel_a));
+
+	make_frame(frame, 1, 0);
+	CHECK(MotionInstaller::stage(frame, &channel_a));
+
+	// The stage of A is kept while B is rejected, and B can't stage, commit nor abort on it.
+	CHECK(!MotionInstaller::begin(header_b, &channel_b));
+
+	make_frame(frame, 2, 0);
+	CHECK(!MotionInstaller::stage(frame, &channel_b));
+	CHECK(!MotionInstaller::commit(&channel_b));
+	MotionInstaller::abort(&channel_b);
+
+	for (unsigned char index = 1; index < header_a.frame_length; index++)
+	{
+		make_frame(frame, 1, index);
+		CHECK(MotionInstaller::stage(frame, &channel_a));
+	}
+
+	CHECK(MotionInstaller::commit(&channel_a));
+	check_motion(1, 3);
+
+	// B installs after A has ended.
+	CHECK(MotionInstaller::begin(header_b, &channel_b));
+
+	// A channel lost on the way doesn't block the others after the timeout.
+	Host::advanceClock(MotionInstaller::STAGE_TIMEOUT_MS / 2);
+	CHECK(!MotionInstaller::begin(header_a, &channel_a));
+
+	Host::advanceClock(MotionInstaller::STAGE_TIMEOUT_MS);
+	CHECK(MotionInstaller::begin(header_a, &channel_a));
+
+	make_frame(frame, 2, 0);
+	CHECK(!MotionInstaller::stage(frame, &channel_b));
+
+	for (unsigned char index = 0; index < header_a.frame_length; index++)
+	{
+		make_frame(frame, 1, index);
+		frame.transition_time_ms += 1000;
+
+		CHECK(MotionInstaller::stage(frame, &channel_a));
+	}
+
+	CHECK(MotionInstaller::commit(&channel_a));
+
+	Motion::Header header;
+	header.slot = 2;
+	CHECK(!header.get());
+
+	frame.index = 2;
+	CHECK(frame.get(1));
+	CHECK_EQUAL(1100 + 2, frame.transition_time_ms);
+}
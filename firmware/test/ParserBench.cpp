@@ -0,0 +1,86 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <ctype.h>
+
+#include "Parser.h"
+
+#include "Test.h"
+
+
+namespace
+{
+	enum {
+		FRAME_LENGTH = 104,   //!< Length of the arguments of MOTION FRAME.
+		ITERATIONS   = 1 << 22
+	};
+
+	//! @brief Check a hex string one character at a time, as the reference of HexStringParser.
+	bool parse_scalar(const char* input)
+	{
+		if (*input == '\0')
+		{
+			return false;
+		}
+
+		for (; *input != '\0'; input++)
+		{
+			if (!isxdigit(static_cast<unsigned char>(*input)))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+
+TEST(hexDecoding)
+{
+	char frame[FRAME_LENGTH + 1];
+
+	srand(1);
+
+	for (int index = 0; index < FRAME_LENGTH; index++)
+	{
+		frame[index] = "0123456789ABCDEFabcdef"[rand() % 22];
+	}
+
+	frame[FRAME_LENGTH] = '\0';
+
+	// The offsets are walked through the frame, so the fields are read as the handlers do.
+	const unsigned char SIZES[] = { 2, 4, 8 };
+
+	for (unsigned int size_index = 0; size_index < sizeof(SIZES); size_index++)
+	{
+		const unsigned char size = SIZES[size_index];
+		char name[64];
+
+		snprintf(name, sizeof(name), "hexbytes2uintScalar, %d digits", size);
+		Test::benchmark(name, ITERATIONS, [&](unsigned long count) {
+			Test::keep(Utility::hexbytes2uintScalar(frame + (count * size) % (FRAME_LENGTH - 8), size));
+		});
+
+		snprintf(name, sizeof(name), "hexbytes2uint, %d digits", size);
+		Test::benchmark(name, ITERATIONS, [&](unsigned long count) {
+			Test::keep(Utility::hexbytes2uint(frame + (count * size) % (FRAME_LENGTH - 8), size));
+		});
+	}
+
+	Test::benchmark("isxdigit loop, MOTION FRAME", ITERATIONS / 16, [&](unsigned long) {
+		Test::keep(parse_scalar(frame));
+	});
+
+	Utility::HexStringParser parser;
+
+	Test::benchmark("HexStringParser, MOTION FRAME", ITERATIONS / 16, [&](unsigned long) {
+		Test::keep(parser.parse(frame));
+	});
+}
@@ -0,0 +1,174 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+#include <ctype.h>
+#include <strings.h>
+
+#include "Parser.h"
+
+#include "Test.h"
+
+
+namespace
+{
+	//! @brief Search the strings given from the head, as the reference of StringGroupParser.
+	int linear_search(const char* strings[], int size, const char* input)
+	{
+		for (int index = 0; index < size; index++)
+		{
+			if (strcasecmp(input, strings[index]) == 0)
+			{
+				return index;
+			}
+		}
+
+		return -1;
+	}
+
+	const char HEX_CHARS[] = "0123456789ABCDEFabcdef";
+	const int  HEX_CHARS_LENGTH = sizeof(HEX_CHARS) - 1;
+
+	//! @brief Check every conversion of the string given against the scalar reference.
+	void check_conversion(const char* bytes, unsigned char size)
+	{
+		CHECK_EQUAL(Utility::hexbytes2uintScalar(bytes, size), Utility::hexbytes2uint(bytes, size));
+
+		// The scalar reference of hexbytes2int() is the sign extension of the digits.
+		const unsigned int shift    = (sizeof(int) * 2 - size) * 4;
+		const int          expected = static_cast<int>(Utility::hexbytes2uintScalar(bytes, size) << shift) >> shift;
+
+		CHECK_EQUAL(expected, Utility::hexbytes2int(bytes, size));
+	}
+
+	//! @brief Check HexStringParser against isxdigit() for the string given.
+	void check_hex_string(const char* input)
+	{
+		bool expected = (input[0] != '\0');
+
+		for (const char* character = input; *character != '\0'; character++)
+		{
+			expected = expected && isxdigit(static_cast<unsigned char>(*character));
+		}
+
+		Utility::HexStringParser parser;
+
+		CHECK_EQUAL(expected, parser.parse(input));
+		CHECK_EQUAL(expected? 0 : -1, parser.index());
+	}
+}
+
+
+TEST(stringGroupParserMatchesLinearSearch)
+{
+	const char* STRINGS[] = { "AD", "AN", "BS", "CL", "FP", "HP", "MP", "MS", "PM", "SM" };
+	const int   STRINGS_LENGTH = sizeof(STRINGS) / sizeof(STRINGS[0]);
+
+	// Every size of the table is checked, so the bounds of the binary search are checked for 0 and 1 string too.
+	for (int size = 0; size <= STRINGS_LENGTH; size++)
+	{
+		Utility::StringGroupParser parser(STRINGS, size);
+
+		for (int first = 1; first < 128; first++)
+		{
+			for (int second = 0; second < 128; second++)
+			{
+				const char input[] = { static_cast<char>(first), static_cast<char>(second), '\0' };
+				const int  expected = linear_search(STRINGS, size, input);
+
+				CHECK_EQUAL(expected >= 0, parser.parse(input));
+				CHECK_EQUAL(expected, parser.index());
+			}
+		}
+	}
+}
+
+
+TEST(hexbytes2uintMatchesScalar)
+{
+	char bytes[8];
+
+	// Every string of the hex characters up to 4 characters, which is a whole word.
+	for (unsigned char size = 1; size <= 4; size++)
+	{
+		int combinations = 1;
+
+		for (unsigned char count = 0; count < size; count++)
+		{
+			combinations *= HEX_CHARS_LENGTH;
+		}
+
+		for (int combination = 0; combination < combinations; combination++)
+		{
+			for (int index = 0, rest = combination; index < size; index++, rest /= HEX_CHARS_LENGTH)
+			{
+				bytes[index] = HEX_CHARS[rest % HEX_CHARS_LENGTH];
+			}
+
+			check_conversion(bytes, size);
+		}
+	}
+
+	// The longer strings are made of a random head and every word, so each lane is checked at each position.
+	srand(1);
+
+	for (unsigned char size = 5; size <= 8; size++)
+	{
+		for (int combination = 0; combination < HEX_CHARS_LENGTH * HEX_CHARS_LENGTH * HEX_CHARS_LENGTH * HEX_CHARS_LENGTH; combination++)
+		{
+			for (int index = 0; index < size - 4; index++)
+			{
+				bytes[index] = HEX_CHARS[rand() % HEX_CHARS_LENGTH];
+			}
+
+			for (int index = size - 4, rest = combination; index < size; index++, rest /= HEX_CHARS_LENGTH)
+			{
+				bytes[index] = HEX_CHARS[rest % HEX_CHARS_LENGTH];
+			}
+
+			check_conversion(bytes, size);
+		}
+	}
+}
+
+
+TEST(hexStringParserMatchesIsxdigit)
+{
+	// Every string of 1 or 2 bytes.
+	for (int first = 1; first < 256; first++)
+	{
+		for (int second = 0; second < 256; second++)
+		{
+			const char input[] = { static_cast<char>(first), static_cast<char>(second), '\0' };
+
+			check_hex_string(input);
+		}
+	}
+
+	// Every byte at each position of the hex strings up to 9 characters, so each lane of the words is checked.
+	for (int size = 1; size <= 9; size++)
+	{
+		for (int position = 0; position < size; position++)
+		{
+			for (int byte = 1; byte < 256; byte++)
+			{
+				char input[10];
+
+				for (int index = 0; index < size; index++)
+				{
+					input[index] = HEX_CHARS[(index * 7) % HEX_CHARS_LENGTH];
+				}
+
+				input[position] = static_cast<char>(byte);
+				input[size]     = '\0';
+
+				check_hex_string(input);
+			}
+		}
+	}
+}
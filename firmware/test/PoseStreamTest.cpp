@@ -0,0 +1,269 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "ExternalFs.h"
+#include "JointController.h"
+#include "PoseStream.h"
+
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		NOT_APPLIED = -1 //!< PWM output set before an update, which no joint can have.
+	};
+
+	//! @brief Make a pose which has the same angle-diff on all the joints.
+	const int* pose(int angle_diff)
+	{
+		static int angle_diffs[JointController::SUM];
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			angle_diffs[joint_id] = angle_diff;
+		}
+
+		return angle_diffs;
+	}
+
+	/*!
+		@brief Apply the pose interpolated at the current time
+
+		The PWM outputs are cleared before, so applied() and notApplied() see only this update.
+	*/
+	void update(PoseStream& stream)
+	{
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			JointController::m_pwms[joint_id] = NOT_APPLIED;
+		}
+
+		stream.update();
+	}
+
+	//! @brief Decide all the joints are driven to the angle-diff, as setAngleDiff() does.
+	bool applied(JointController& joint_ctrl, int angle_diff)
+	{
+		int pwms[JointController::SUM];
+		memcpy(pwms, JointController::m_pwms, sizeof(pwms));
+
+		bool result = true;
+
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			joint_ctrl.setAngleDiff(joint_id, angle_diff);
+
+			result = result && (JointController::m_pwms[joint_id] == pwms[joint_id]);
+		}
+
+		return result;
+	}
+
+	bool notApplied()
+	{
+		for (int joint_id = 0; joint_id < JointController::SUM; joint_id++)
+		{
+			if (JointController::m_pwms[joint_id] != NOT_APPLIED)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/*!
+		@brief Get a metric of the stream
+
+		@param [in] name Please set the name of the metric in the output of PoseStream::dump().
+	*/
+	unsigned long metric(PoseStream& stream, const char* name)
+	{
+		Host::output().clear();
+		stream.dump();
+
+		const std::string key = std::string("\"") + name + "\": ";
+		const size_t position = Host::output().output.find(key);
+
+		return (position == std::string::npos)? 0 : strtoul(Host::output().output.c_str() + position + key.size(), NULL, 10);
+	}
+
+	void boot(JointController& joint_ctrl, const char* name)
+	{
+		Host::makeFsRoot(name);
+
+		ExternalFs::de_init();
+		ExternalFs::init();
+
+		joint_ctrl.resetSettings();
+	}
+}
+
+
+TEST(latencyIsTheDepth)
+{
+	JointController joint_ctrl;
+	PoseStream      stream(joint_ctrl);
+
+	boot(joint_ctrl, "pose_stream_latency");
+	Host::stopClock(true);
+
+	CHECK(!stream.begin(PoseStream::DEPTH_MS_MIN - 1));
+	CHECK(!stream.begin(PoseStream::DEPTH_MS_MAX + 1));
+
+	const unsigned int depths[] = { PoseStream::DEPTH_MS_MIN, PoseStream::DEPTH_MS_DEFAULT, PoseStream::DEPTH_MS_MAX };
+
+	for (unsigned int index = 0; index < sizeof(depths) / sizeof(depths[0]); index++)
+	{
+		CHECK(stream.begin(depths[index]));
+		CHECK_EQUAL(static_cast<unsigned long>(depths[index]), metric(stream, "depth_ms"));
+
+		// The timestamp of the host is not related to millis(), so the first pose decides the offset.
+		CHECK(stream.push(12345, pose(300)));
+
+		unsigned long latency_ms = 0;
+
+		for (update(stream); notApplied() && (latency_ms <= PoseStream::DEPTH_MS_MAX); update(stream))
+		{
+			Host::advanceClock(1);
+			latency_ms++;
+		}
+
+		CHECK_EQUAL(static_cast<unsigned long>(depths[index]), latency_ms);
+		CHECK(applied(joint_ctrl, 300));
+	}
+
+	stream.end();
+	CHECK(!stream.streaming());
+
+	Host::stopClock(false);
+}
+
+
+TEST(posesAreInterpolated)
+{
+	JointController joint_ctrl;
+	PoseStream      stream(joint_ctrl);
+
+	boot(joint_ctrl, "pose_stream_interpolation");
+	Host::stopClock(true);
+
+	CHECK(stream.begin(PoseStream::DEPTH_MS_DEFAULT));
+	CHECK(stream.push(1000, pose(0)));
+	CHECK(stream.push(1040, pose(300)));
+
+	Host::advanceClock(PoseStream::DEPTH_MS_DEFAULT);
+	update(stream);
+	CHECK(applied(joint_ctrl, 0));
+
+	Host::advanceClock(10);
+	update(stream);
+	CHECK(applied(joint_ctrl, 75));
+
+	Host::advanceClock(20);
+	update(stream);
+	CHECK(applied(joint_ctrl, 225));
+
+	// The buffer runs out at the last pose, so it is held and the underrun is counted once.
+	Host::advanceClock(10);
+	update(stream);
+	CHECK(applied(joint_ctrl, 300));
+	CHECK_EQUAL(1UL, metric(stream, "underruns"));
+
+	Host::advanceClock(40);
+	update(stream);
+	CHECK(notApplied());
+	CHECK_EQUAL(1UL, metric(stream, "underruns"));
+
+	// The next pose restarts the stream, moving from the held pose in the depth.
+	CHECK(stream.push(1200, pose(100)));
+
+	Host::advanceClock(PoseStream::DEPTH_MS_DEFAULT / 2);
+	update(stream);
+	CHECK(applied(joint_ctrl, 200));
+
+	Host::advanceClock(PoseStream::DEPTH_MS_DEFAULT / 2);
+	update(stream);
+	CHECK(applied(joint_ctrl, 100));
+	CHECK_EQUAL(2UL, metric(stream, "underruns"));
+
+	CHECK_EQUAL(3UL, metric(stream, "received"));
+	CHECK_EQUAL(0UL, metric(stream, "late"));
+
+	Host::stopClock(false);
+}
+
+
+TEST(posesOutOfOrderAndLate)
+{
+	JointController joint_ctrl;
+	PoseStream      stream(joint_ctrl);
+
+	boot(joint_ctrl, "pose_stream_order");
+	Host::stopClock(true);
+
+	CHECK(stream.begin(PoseStream::DEPTH_MS_DEFAULT));
+
+	// The pose at 40 [ms] is overtaken by the one at 80 [ms], and the timestamps wrap around at 16 bits.
+	CHECK(stream.push(0xFFF0, pose(0)));
+	CHECK(stream.push(0x0040, pose(200)));
+	CHECK(stream.push(0x0018, pose(400)));
+	CHECK_EQUAL(3UL, metric(stream, "buffered"));
+
+	Host::advanceClock(PoseStream::DEPTH_MS_DEFAULT);
+	update(stream);
+	CHECK(applied(joint_ctrl, 0));
+
+	Host::advanceClock(20);
+	update(stream);
+	CHECK(applied(joint_ctrl, 200));
+
+	Host::advanceClock(20);
+	update(stream);
+	CHECK(applied(joint_ctrl, 400));
+
+	Host::advanceClock(20);
+	update(stream);
+	CHECK(applied(joint_ctrl, 300));
+	CHECK_EQUAL(2UL, metric(stream, "buffered"));
+
+	// The play time of the pose at 50 [ms] has passed, so it arrived later than the depth.
+	CHECK(!stream.push(0x0022, pose(-400)));
+	CHECK_EQUAL(1UL, metric(stream, "late"));
+
+	// A pose arriving twice is dropped as a late one.
+	CHECK(!stream.push(0x0040, pose(-400)));
+	CHECK_EQUAL(2UL, metric(stream, "late"));
+
+	// The poses dropped don't change the motion.
+	Host::advanceClock(10);
+	update(stream);
+	CHECK(applied(joint_ctrl, 250));
+
+	CHECK_EQUAL(5UL, metric(stream, "received"));
+	CHECK_EQUAL(0UL, metric(stream, "underruns"));
+	CHECK_EQUAL(0UL, metric(stream, "overflows"));
+
+	// The host running ahead of the depth overflows the buffer.
+	for (int index = 1; index <= PoseStream::BUFFER_LENGTH - 2; index++)
+	{
+		CHECK(stream.push(0x0040 + index * 10, pose(index)));
+	}
+
+	CHECK(!stream.push(0x0040 + PoseStream::BUFFER_LENGTH * 10, pose(0)));
+
+	CHECK_EQUAL(1UL, metric(stream, "overflows"));
+	CHECK_EQUAL(static_cast<unsigned long>(PoseStream::BUFFER_LENGTH), metric(stream, "buffered"));
+
+	Host::stopClock(false);
+}
@@ -0,0 +1,269 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+// The tables of the protocol are read by Commands.h, so Protocol.cpp is built here in place of the library.
+#include "Protocol.cpp"
+#include "Commands.h"
+
+#include "Test.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <x86intrin.h>
+
+	inline unsigned long long cycles() { return __rdtsc(); }
+#else
+	inline unsigned long long cycles() { return 0; }
+#endif
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		STREAM_SIZE = 1 << 20, //!< Size of the stream fed for each command. (bytes)
+		BLOCK_SIZE  = Protocol::FEED_BLOCK_SIZE
+	};
+
+	enum {
+		INPUT_LENGTH = 256, //!< Count of the command names given to the parsers in turn. (It must be 2^N.)
+		ITERATIONS   = 1 << 22
+	};
+
+	/*!
+		@brief Feed a stream by the blocks read from a stream at once
+
+		@return Count of the commands completed.
+	*/
+	unsigned int feed_blocks(Protocol& protocol, const std::string& stream)
+	{
+		unsigned int completed = 0;
+
+		for (unsigned int position = 0; position < stream.size(); position += BLOCK_SIZE)
+		{
+			completed += protocol.feed(stream.data() + position, min(static_cast<unsigned int>(BLOCK_SIZE), static_cast<unsigned int>(stream.size() - position)));
+		}
+
+		return completed;
+	}
+
+	void report(const char* name, long commands, unsigned long long nsec)
+	{
+		printf("  %-44s %12.1f ns/cmd %13.0f cmds/s\n", name, static_cast<double>(nsec) / commands, commands * 1e9 / nsec);
+	}
+
+	void measure(int header_id, int cmd_id, bool binary)
+	{
+		std::string stream;
+		long        count = 0;
+
+		srand(1);
+
+		while (stream.size() < STREAM_SIZE)
+		{
+			stream += binary? Commands::binary(header_id, cmd_id) : Commands::text(header_id, cmd_id);
+			count++;
+		}
+
+		Commands::Dispatcher protocol;
+
+		const unsigned long long cycles_begin = cycles();
+		const unsigned long long nsec_begin   = Test::nsec();
+
+		feed_blocks(protocol, stream);
+
+		const double nsec   = static_cast<double>(Test::nsec() - nsec_begin) / count;
+		const double clocks = static_cast<double>(cycles() - cycles_begin) / count;
+
+		Test::keep(protocol.sink);
+
+		printf("  %-4s %-8s %12.0f %10.1f %10.0f %8.1f\n",
+			Commands::name(header_id, cmd_id).c_str(), binary? "binary" : "text",
+			1e9 / nsec, nsec, clocks, static_cast<double>(stream.size()) / count);
+	}
+}
+
+
+TEST(commandDispatch)
+{
+	for (int header_id = 0; header_id < Commands::HEADER_SUM; header_id++)
+	{
+		// The names of the header in random case, and a miss at times as garbage gives.
+		char inputs[INPUT_LENGTH][3];
+
+		srand(1);
+
+		for (int index = 0; index < INPUT_LENGTH; index++)
+		{
+			const char* symbol = Shared::SYMBOL[header_id][Commands::pick(Commands::count(header_id))];
+
+			inputs[index][0] = Commands::pick(2)? symbol[0] : tolower(symbol[0]);
+			inputs[index][1] = (Commands::pick(8) == 0)? static_cast<char>(' ' + Commands::pick(95)) : symbol[1];
+			inputs[index][2] = '\0';
+		}
+
+		Shared::CommandParser       command_parser(header_id);
+		Utility::StringGroupParser  string_group_parser(const_cast<const char**>(Shared::SYMBOL[header_id]), Commands::count(header_id));
+		Utility::AbstractParser*    parsers[] = { &string_group_parser, &command_parser };
+		const char*                 PARSER_NAMES[] = { "StringGroupParser", "CommandParser" };
+
+		for (int parser_index = 0; parser_index < 2; parser_index++)
+		{
+			Utility::AbstractParser& parser = *parsers[parser_index];
+			char name[64];
+
+			snprintf(name, sizeof(name), "%s, \"%c\" (%d commands)", PARSER_NAMES[parser_index], Shared::HEADER_SYMBOL[header_id], Commands::count(header_id));
+			Test::benchmark(name, ITERATIONS, [&](unsigned long count) {
+				Test::keep(parser.parse(inputs[count & (INPUT_LENGTH - 1)]));
+			});
+		}
+	}
+}
+
+
+TEST(eachCommand)
+{
+	printf("  %-4s %-8s %12s %10s %10s %8s\n", "cmd", "format", "cmds/s", "ns/cmd", "cycles/cmd", "bytes");
+
+	for (int header_id = 0; header_id < Commands::HEADER_SUM; header_id++)
+	{
+		for (int cmd_id = 0; cmd_id < Commands::count(header_id); cmd_id++)
+		{
+			measure(header_id, cmd_id, false);
+
+			if (Commands::binaryAvailable(header_id, cmd_id))
+			{
+				measure(header_id, cmd_id, true);
+			}
+		}
+	}
+}
+
+
+TEST(commandsPerSecond)
+{
+	std::string stream;
+	long        commands = 0;
+	long        frames   = 0;
+
+	srand(1);
+
+	while (stream.size() < STREAM_SIZE)
+	{
+		stream += Commands::any(frames, false);
+		commands++;
+	}
+
+	printf("  %ld commands (%ld frames of INSTALL MOTION), %lu bytes\n", commands, frames, static_cast<unsigned long>(stream.size()));
+
+	// A character at a time, as loop() fed the protocol before feed().
+	{
+		Commands::Dispatcher protocol;
+		const unsigned long long begin = Test::nsec();
+
+		for (unsigned int position = 0; position < stream.size(); position++)
+		{
+			protocol.readByte(stream[position]);
+
+			if (protocol.accept())
+			{
+				protocol.transitState();
+			}
+		}
+
+		report("readByte(), accept() and transitState()", commands, Test::nsec() - begin);
+		CHECK_EQUAL(commands + frames, protocol.dispatched);
+	}
+
+	{
+		Commands::Dispatcher protocol;
+		const unsigned long long begin = Test::nsec();
+
+		feed_blocks(protocol, stream);
+
+		report("feed(), blocks of FEED_BLOCK_SIZE", commands, Test::nsec() - begin);
+		CHECK_EQUAL(commands + frames, protocol.dispatched);
+	}
+
+	{
+		Commands::Dispatcher protocol;
+		Host::StringStream   channel;
+
+		channel.input = stream;
+		protocol.setFeedBudget(0xFFFFFFFF);
+
+		const unsigned long long begin = Test::nsec();
+
+		while (channel.available() > 0)
+		{
+			protocol.feed(channel);
+		}
+
+		report("feed() of a stream", commands, Test::nsec() - begin);
+		CHECK_EQUAL(commands + frames, protocol.dispatched);
+	}
+}
+
+
+TEST(textVersusBinary)
+{
+	std::string text_stream;
+	std::string binary_stream;
+	long        commands = 0;
+
+	srand(1);
+
+	// Both streams carry the same commands and arguments, so only the format differs.
+	while (binary_stream.size() < STREAM_SIZE)
+	{
+		for (int header_id = 0; header_id < Commands::HEADER_SUM; header_id++)
+		{
+			for (int cmd_id = 0; cmd_id < Commands::count(header_id); cmd_id++)
+			{
+				if (Commands::binaryAvailable(header_id, cmd_id))
+				{
+					std::string text;
+					std::string binary;
+
+					Commands::pair(header_id, cmd_id, text, binary);
+
+					text_stream   += text;
+					binary_stream += binary;
+					commands++;
+				}
+			}
+		}
+	}
+
+	Commands::Dispatcher text_protocol;
+	Commands::Dispatcher binary_protocol;
+
+	const unsigned long long text_begin = Test::nsec();
+	feed_blocks(text_protocol, text_stream);
+	const unsigned long long text_nsec = Test::nsec() - text_begin;
+
+	const unsigned long long binary_begin = Test::nsec();
+	feed_blocks(binary_protocol, binary_stream);
+	const unsigned long long binary_nsec = Test::nsec() - binary_begin;
+
+	CHECK_EQUAL(commands, text_protocol.dispatched);
+	CHECK_EQUAL(commands, binary_protocol.dispatched);
+	CHECK_EQUAL(text_protocol.sink, binary_protocol.sink);
+
+	char name[64];
+
+	printf("  %ld commands\n", commands);
+	snprintf(name, sizeof(name), "text, %.1f bytes/cmd", static_cast<double>(text_stream.size()) / commands);
+	report(name, commands, text_nsec);
+	snprintf(name, sizeof(name), "binary, %.1f bytes/cmd", static_cast<double>(binary_stream.size()) / commands);
+	report(name, commands, binary_nsec);
+	printf("  binary / text : %.2f of the bytes, %.2f of the time\n",
+		static_cast<double>(binary_stream.size()) / text_stream.size(), static_cast<double>(binary_nsec) / text_nsec);
+}
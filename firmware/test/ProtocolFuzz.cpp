@@ -0,0 +1,209 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+/*!
+	@note
+	The fuzzer feeds the protocol with the streams of valid commands, of the commands mutated and of garbage,
+	and checks every command dispatched is in the tables. It is built with the sanitizers, which catch the rest.
+	<br><br>
+	"make fuzz" runs the built-in fuzzer for the iterations given by the argument,
+	and "make fuzz FUZZER=libfuzzer" builds LLVMFuzzerTestOneInput() for libFuzzer instead.
+*/
+#include <Arduino.h>
+
+#include "Protocol.cpp"
+#include "Commands.h"
+#include "Host.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	/*!
+		@brief Feed a stream to the protocol
+
+		@param [in] chunk Please set max size of the blocks given to feed(), or 0 to use readByte() instead.
+	*/
+	void feed(Commands::Dispatcher& protocol, const std::string& stream, unsigned int chunk)
+	{
+		if (chunk == 0)
+		{
+			for (unsigned int position = 0; position < stream.size(); position++)
+			{
+				protocol.readByte(stream[position]);
+
+				if (protocol.accept())
+				{
+					protocol.transitState();
+				}
+			}
+
+			return;
+		}
+
+		for (unsigned int position = 0; position < stream.size(); )
+		{
+			const unsigned int block  = 1 + Commands::pick(chunk);
+			const unsigned int length = min(block, static_cast<unsigned int>(stream.size() - position));
+
+			protocol.feed(stream.data() + position, length);
+			position += length;
+		}
+	}
+
+	/*!
+		@brief Feed a stream from a channel, and check the replies
+
+		Each reply is "@<sequence><status><pipeline credit>\r\n", so the replies are torn if their size is not a multiple of it.
+	*/
+	bool feed_channel(Commands::Dispatcher& protocol, const std::string& stream)
+	{
+		Host::StringStream channel;
+		channel.input = stream;
+
+		while (channel.available() > 0)
+		{
+			protocol.feed(channel);
+		}
+
+		return ((channel.output.size() % 9) == 0);
+	}
+
+	void mutate(std::string& stream)
+	{
+		for (int count = 1 + Commands::pick(4); (count > 0) && !(stream.empty()); count--)
+		{
+			const int position = Commands::pick(stream.size());
+
+			switch (Commands::pick(4))
+			{
+				case 0: stream[position] = static_cast<char>(Commands::pick(256)); break;
+				case 1: stream.erase(position, 1); break;
+				case 2: stream.insert(position, 1, static_cast<char>(Commands::pick(256))); break;
+				case 3: stream.insert(position, "@" + Commands::hex(2)); break;
+			}
+		}
+	}
+
+	std::string garbage()
+	{
+		std::string result;
+
+		for (int count = 1 + Commands::pick(200); count > 0; count--)
+		{
+			result += static_cast<char>(Commands::pick(256));
+		}
+
+		return result;
+	}
+}
+
+
+#ifdef LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	// The first byte selects the way of feeding, so the corpus covers the tokens split between blocks.
+	const std::string stream(reinterpret_cast<const char*>(data + 1), size - 1);
+
+	srand(data[0]);
+
+	Commands::Dispatcher protocol;
+
+	if (data[0] & 0x80)
+	{
+		if (!feed_channel(protocol, stream))
+		{
+			abort();
+		}
+	}
+	else
+	{
+		feed(protocol, stream, data[0] & 0x7F);
+	}
+
+	return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+	const long iterations = (argc > 1)? atol(argv[1]) : 20000;
+
+	srand(1);
+
+	// Clean streams must dispatch every command, by feed() and by readByte(). (Binary frames are accepted only by feed().)
+	for (unsigned int chunk = 0; chunk <= 80; chunk += 80)
+	{
+		Commands::Dispatcher protocol;
+		std::string          stream;
+		long                 frames = 0;
+
+		for (long count = 0; count < iterations; count++)
+		{
+			stream += Commands::any(frames, chunk != 0);
+		}
+
+		feed(protocol, stream, chunk);
+
+		printf("%s clean stream : %ld commands, %ld dispatches (%ld expected)\n",
+			(chunk == 0)? "readByte()" : "feed()", iterations, protocol.dispatched, iterations + frames);
+
+		if (   (protocol.dispatched != iterations + frames)
+			|| !(protocol.ready()) )
+		{
+			return 1;
+		}
+	}
+
+	// The mutations and garbage must not fault, which the sanitizers watch.
+	Commands::Dispatcher protocol;
+	long                 bytes = 0;
+
+	for (long count = 0; count < iterations; count++)
+	{
+		std::string stream;
+		long        frames = 0;
+
+		for (int command = 1 + Commands::pick(8); command > 0; command--)
+		{
+			stream += Commands::pick(10)? Commands::any(frames, true) : garbage();
+		}
+
+		mutate(stream);
+		bytes += stream.size();
+
+		if (Commands::pick(4) == 0)
+		{
+			if (!feed_channel(protocol, stream))
+			{
+				printf("torn reply\n");
+
+				return 1;
+			}
+		}
+		else
+		{
+			feed(protocol, stream, (Commands::pick(8) == 0)? 0 : 80);
+		}
+	}
+
+	printf("fuzz : %ld iterations, %ld bytes, %ld dispatches, no fault\n", iterations, bytes, protocol.dispatched);
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,308 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "Checksum.h"
+#include "Protocol.h"
+
+#include "Host.h"
+#include "Test.h"
+
+using namespace PLEN2;
+
+
+namespace
+{
+	/*!
+		@brief Protocol which records the commands dispatched
+
+		Each entry is "<header index>:<command index>:<arguments>".
+	*/
+	class Recorder : public Protocol
+	{
+	public:
+		std::vector<std::string> log;
+		bool rejecting; //!< The commands are rejected, as a handler does for the arguments out of range.
+
+		Recorder()
+			: rejecting(false)
+		{
+			// noop.
+		}
+
+		virtual void afterHook()
+		{
+			if (m_state == READY)
+			{
+				char entry[Buffer::LENGTH + 16];
+				snprintf(entry, sizeof(entry), "%d:%d:%s", m_header_id, m_cmd_id, m_binary_args? "(binary)" : m_buffer.data);
+
+				log.push_back(entry);
+
+				if (rejecting)
+				{
+					m_setStatus(STATUS_NACK_REJECTED);
+				}
+			}
+		}
+
+		unsigned int argUint(unsigned char offset, unsigned char digits) { return m_argUint(offset, digits); }
+		int          argInt(unsigned char offset, unsigned char digits)  { return m_argInt(offset, digits); }
+	};
+
+	unsigned int feed(Protocol& protocol, const std::string& data)
+	{
+		return protocol.feed(data.data(), data.size());
+	}
+
+	//! @brief Make a binary frame of the command id and the payload given.
+	std::string binary_frame(unsigned char command_id, const std::string& payload)
+	{
+		std::string body;
+		body += static_cast<char>(payload.size() + 1);
+		body += static_cast<char>(command_id);
+		body += payload;
+
+		const unsigned int crc = Utility::crc16(reinterpret_cast<const unsigned char*>(body.data()), body.size());
+
+		return std::string(1, static_cast<char>(Protocol::BINARY_START)) + body
+			+ static_cast<char>(crc & 0xFF) + static_cast<char>(crc >> 8);
+	}
+
+	/*!
+		@brief Feed the commands given from a channel, and get the replies sent to it
+
+		A command of another channel is fed between, so a reply sent to the wrong channel is found.
+	*/
+	std::string reply(Protocol& protocol, const std::string& data)
+	{
+		Recorder         other;
+		Host::StringStream channel;
+		Host::StringStream other_channel;
+
+		channel.input       = data;
+		other_channel.input = "@7F<VI";
+
+		protocol.feed(channel);
+		other.feed(other_channel);
+
+		CHECK(other_channel.output == "@7F0080\r\n");
+
+		return channel.output;
+	}
+}
+
+
+TEST(channelsKeepTheirOwnCommand)
+{
+	Recorder a;
+	Recorder b;
+
+	// A token of A is split by a whole command of B.
+	CHECK_EQUAL(0, feed(a, "$AD00"));
+	CHECK_EQUAL(1, feed(b, "<VI"));
+	CHECK_EQUAL(1, feed(a, "123"));
+
+	CHECK_EQUAL(1, a.log.size());
+	CHECK(a.log[0] == "0:0:00123");
+	CHECK_EQUAL(0x00, a.argUint(0, 2));
+	CHECK_EQUAL(0x123, a.argInt(2, 3));
+
+	CHECK_EQUAL(1, b.log.size());
+	CHECK(b.log[0] == "3:8:VI");
+}
+
+
+TEST(channelsKeepTheirOwnHeader)
+{
+	Recorder a;
+	Recorder b;
+
+	// The header of A is parsed, and B parses another header and command before A's command.
+	feed(a, "$");
+	feed(b, ">HO");
+	feed(a, "HP");
+	feed(b, "0A064");
+
+	CHECK_EQUAL(1, a.log.size());
+	CHECK(a.log[0] == "0:6:HP");
+
+	CHECK_EQUAL(1, b.log.size());
+	CHECK(b.log[0] == "2:1:0A064");
+}
+
+
+TEST(binaryFrameBetweenTextTokens)
+{
+	Recorder a;
+	Recorder b;
+
+	const std::string payload("\x0A\x9C\xFF", 3);
+
+	feed(a, "<M");
+	feed(b, binary_frame(0 << 5 | 1 /* := APPLY NATIVE */, payload));
+	feed(a, "O05");
+
+	CHECK_EQUAL(1, a.log.size());
+	CHECK(a.log[0] == "3:5:05");
+
+	CHECK_EQUAL(1, b.log.size());
+	CHECK(b.log[0] == "0:1:(binary)");
+}
+
+
+TEST(interleavedChannelsDispatchAsAlone)
+{
+	const char* const COMMANDS[] = {
+		"$AD00123", "<VI", "$HP", ">HO0A064", "#PU0102", "$PM05", "<MO2A", "$AN0AF9C", ">MA03384", "#RI", "<JS"
+	};
+	const int COMMAND_SUM = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+	const int CHANNEL_SUM = 3;
+
+	std::string scripts[CHANNEL_SUM];
+
+	for (int channel = 0; channel < CHANNEL_SUM; channel++)
+	{
+		for (int count = 0; count < 40; count++)
+		{
+			scripts[channel] += COMMANDS[(count * (channel + 2) + channel) % COMMAND_SUM];
+
+			if ((count % 7) == channel)
+			{
+				scripts[channel] += binary_frame(0 << 5 | 0 /* := APPLY DIFF */, std::string("\x01\x23\x01", 3));
+			}
+		}
+	}
+
+	Recorder alone[CHANNEL_SUM];
+
+	for (int channel = 0; channel < CHANNEL_SUM; channel++)
+	{
+		feed(alone[channel], scripts[channel]);
+	}
+
+	for (int seed = 1; seed <= 50; seed++)
+	{
+		srand(seed);
+
+		Recorder     interleaved[CHANNEL_SUM];
+		unsigned int position[CHANNEL_SUM] = { 0 };
+
+		// The scripts are fed by random chunks from the channels picked at random.
+		for (int rest = CHANNEL_SUM; rest > 0; )
+		{
+			const int channel = rand() % CHANNEL_SUM;
+
+			if (position[channel] >= scripts[channel].size())
+			{
+				continue;
+			}
+
+			const unsigned int chunk  = 1 + rand() % 6;
+			const unsigned int length = min(chunk, static_cast<unsigned int>(scripts[channel].size() - position[channel]));
+
+			interleaved[channel].feed(scripts[channel].data() + position[channel], length);
+			position[channel] += length;
+
+			if (position[channel] == scripts[channel].size())
+			{
+				rest--;
+			}
+		}
+
+		for (int channel = 0; channel < CHANNEL_SUM; channel++)
+		{
+			CHECK_EQUAL(alone[channel].log.size(), interleaved[channel].log.size());
+			CHECK(alone[channel].log == interleaved[channel].log);
+		}
+	}
+}
+
+
+TEST(replyAcknowledged)
+{
+	Recorder a;
+
+	CHECK(reply(a, "@01$AN0A064") == "@010080\r\n");
+	CHECK(reply(a, "@02" + binary_frame(0 << 5 | 1 /* := APPLY NATIVE */, std::string("\x0A\x9C\xFF", 3))) == "@020080\r\n");
+
+	// A command without the sequence number is not replied.
+	CHECK(reply(a, "$AN0A064").empty());
+	CHECK_EQUAL(3, a.log.size());
+}
+
+
+TEST(replySyntaxError)
+{
+	Recorder a;
+
+	CHECK(reply(a, "@03$ZZ") == "@030180\r\n");
+
+	// The command sequenced before has not come. (The next command is held unreplied.)
+	CHECK(reply(a, "@04@05<VI") == "@04017A\r\n@050080\r\n");
+	CHECK_EQUAL(1, a.log.size());
+}
+
+
+TEST(replyBrokenFrame)
+{
+	Recorder a;
+
+	std::string frame = binary_frame(0 << 5 | 1 /* := APPLY NATIVE */, std::string("\x0A\x9C\xFF", 3));
+	frame[frame.size() - 1] ^= 0xFF;
+
+	CHECK(reply(a, "@06" + frame) == "@060280\r\n");
+	CHECK(a.log.empty());
+}
+
+
+TEST(replyRejected)
+{
+	Recorder a;
+	a.rejecting = true;
+
+	CHECK(reply(a, "@07$AN0A064") == "@070380\r\n");
+
+	// The status is of each command, so the next one is acknowledged.
+	a.rejecting = false;
+	CHECK(reply(a, "@08$AN0A064") == "@080080\r\n");
+}
+
+
+TEST(replyCreditsLeft)
+{
+	Recorder a;
+
+	// The rest of the block read and the bytes left on the channel are not replied yet.
+	std::string commands;
+
+	for (int sequence = 0x10; sequence < 0x18; sequence++)
+	{
+		char command[16];
+		snprintf(command, sizeof(command), "@%02X$AN0A064", sequence);
+
+		commands += command;
+	}
+
+	CHECK_EQUAL(88, commands.size());
+	CHECK(reply(a, commands) ==
+		"@100033\r\n" // 128 - (64 - 11) - (88 - 64)
+		"@11003E\r\n"
+		"@120049\r\n"
+		"@130054\r\n"
+		"@14005F\r\n"
+		"@15006A\r\n"
+		"@160075\r\n"
+		"@170080\r\n"
+	);
+
+	// The credit is never below zero, when the limit is under the bytes held.
+	a.setPipelineLimit(20);
+	CHECK(reply(a, commands.substr(0, 33)) == "@100000\r\n@110009\r\n@120014\r\n");
+}
@@ -0,0 +1,221 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <Arduino.h>
+
+#include "ExternalFs.h"
+#include "Motion.h"
+#include "MotionDirectory.h"
+#include "MotionInstaller.h"
+#include "MotionStore.h"
+
+#include "Test.h"
+
+extern File fp_motion;
+extern File fp_config;
+
+using namespace PLEN2;
+
+
+namespace
+{
+	enum {
+		MOTION_COUNT = 40, //!< Count of the motions installed for the benchmarks.
+		TRACE_LENGTH = 4096,
+
+		FILLED_MOTION_FILE_SIZE = 0x200000 //!< Size of the motion file that the format filled before. (2 MB)
+	};
+
+	class Access
+	{
+	public:
+		unsigned char slot;
+		unsigned char index;
+	};
+
+	void boot()
+	{
+		ExternalFs::de_init();
+		ExternalFs::init();
+		MotionStore::init();
+		Motion::migrate();
+		MotionDirectory::init();
+	}
+
+	void install(unsigned char slot, unsigned char frame_length)
+	{
+		Motion::Header header;
+		header.init();
+		header.slot         = slot;
+		header.frame_length = frame_length;
+
+		MotionInstaller::begin(header);
+
+		for (unsigned char index = 0; index < frame_length; index++)
+		{
+			Motion::Frame frame;
+			memset(&frame, 0, sizeof(frame));
+
+			frame.index              = index;
+			frame.transition_time_ms = 100;
+			frame.joint_angle[0]     = slot * 10 + index;
+
+			MotionInstaller::stage(frame);
+		}
+
+		MotionInstaller::commit();
+	}
+
+	/*!
+		@brief Make a trace of the frames read by playing motions
+
+		Motions are picked at random, and their frames are read in order, as MotionController does.
+	*/
+	void make_playback_trace(Access trace[], unsigned int length)
+	{
+		srand(1);
+
+		unsigned int position = 0;
+
+		while (position < length)
+		{
+			const unsigned char slot = rand() % MOTION_COUNT;
+
+			for (unsigned char index = 0; (index < Motion::Header::FRAMELENGTH_MAX) && (position < length); index++)
+			{
+				trace[position].slot  = slot;
+				trace[position].index = index;
+				position++;
+			}
+		}
+	}
+
+	/*!
+		@brief Format the files filled, as ExternalFs::init() did before the files were sparse
+
+		Each block of BUF_SIZE bytes is written and flushed by ExternalFs::write().
+	*/
+	void format_filled()
+	{
+		const char*        FILES[] = { MOTION_FILE, CONFIG_FILE, SYSCFG_FILE };
+		const unsigned int SIZES[] = { FILLED_MOTION_FILE_SIZE, CONFIG_FILE_SIZE, SYSCFG_FILE_SIZE };
+
+		unsigned char block[BUF_SIZE];
+		memset(block, ExternalFs::FILL_VALUE(), sizeof(block));
+
+		for (unsigned int file = 0; file < sizeof(FILES) / sizeof(FILES[0]); file++)
+		{
+			File fp = SPIFFS.open(FILES[file], "w+");
+
+			for (unsigned int address = 0; address < SIZES[file]; address += BUF_SIZE)
+			{
+				ExternalFs::write(address, BUF_SIZE, block, fp);
+			}
+
+			fp.close();
+		}
+	}
+
+	Access trace[TRACE_LENGTH];
+}
+
+
+TEST(format)
+{
+	// Each format is of a new directory, so the files don't exist before.
+	char name[32];
+
+	ExternalFs::de_init();
+
+	const double filled_nsec = Test::benchmark("format, 2 MB filled by 1 KB writes", 8, [&](unsigned long count) {
+		snprintf(name, sizeof(name), "bench_format_filled_%lu", count);
+		Host::makeFsRoot(name);
+
+		format_filled();
+		ExternalFs::init();
+		ExternalFs::de_init();
+	});
+
+	const double sparse_nsec = Test::benchmark("format, sparse files", 8, [&](unsigned long count) {
+		snprintf(name, sizeof(name), "bench_format_sparse_%lu", count);
+		Host::makeFsRoot(name);
+
+		ExternalFs::init();
+		ExternalFs::de_init();
+	});
+
+	printf("  sparse format : %.0fx faster, and writes no byte instead of %lu bytes\n",
+		filled_nsec / sparse_nsec, FILLED_MOTION_FILE_SIZE + CONFIG_FILE_SIZE + SYSCFG_FILE_SIZE);
+}
+
+
+TEST(slotAccess)
+{
+	Host::makeFsRoot("bench_slot");
+	boot();
+
+	unsigned char data[30 /* := ExternalFs::SLOT_SIZE() */];
+	memset(data, 0x5A, sizeof(data));
+
+	const unsigned int SLOTS = 4096;
+
+	Test::benchmark("writeSlot, sequential", SLOTS, [&](unsigned long count) {
+		ExternalFs::writeSlot(count, data, sizeof(data), fp_config);
+	});
+
+	Test::benchmark("writeSlot, sequential in a transaction", SLOTS, [&](unsigned long count) {
+		if (count == 0) { ExternalFs::begin(fp_config); }
+		ExternalFs::writeSlot(count, data, sizeof(data), fp_config);
+		if (count == SLOTS - 1) { ExternalFs::commit(); }
+	});
+
+	Test::benchmark("readSlot, sequential", SLOTS * 16, [&](unsigned long count) {
+		ExternalFs::readSlot(count % SLOTS, data, sizeof(data), fp_config);
+		Test::keep(data);
+	});
+
+	srand(1);
+
+	Test::benchmark("readSlot, random", SLOTS * 16, [&](unsigned long) {
+		ExternalFs::readSlot(rand() % SLOTS, data, sizeof(data), fp_config);
+		Test::keep(data);
+	});
+}
+
+
+TEST(motionAccess)
+{
+	Host::makeFsRoot("bench_motion");
+	boot();
+
+	Test::benchmark("install a motion of 20 frames", MOTION_COUNT, [&](unsigned long count) {
+		install(count, Motion::Header::FRAMELENGTH_MAX);
+	});
+
+	make_playback_trace(trace, TRACE_LENGTH);
+
+	const double frame_nsec = Test::benchmark("Frame::get, playback trace", TRACE_LENGTH * 16, [&](unsigned long count) {
+		Motion::Frame frame;
+		frame.index = trace[count % TRACE_LENGTH].index;
+		frame.get(trace[count % TRACE_LENGTH].slot);
+		Test::keep(frame);
+	});
+
+	Test::benchmark("Header::get, random", TRACE_LENGTH * 16, [&](unsigned long count) {
+		Motion::Header header;
+		header.slot = rand() % MOTION_COUNT;
+		header.get();
+		Test::keep(header);
+	});
+
+	Test::benchmark("boot (checkpoint and replay)", 64, [&](unsigned long) {
+		boot();
+	});
+
+	printf("  frame read bandwidth : %.1f MB/s\n", sizeof(Motion::Frame) / frame_nsec * 1e3);
+}
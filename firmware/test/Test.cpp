@@ -0,0 +1,76 @@
+/*
+	Copyright (c) 2015,
+	- Kazuyuki TAKASE - https://github.com/junbowu
+	- PLEN Project Company Inc. - https://plen.jp
+
+	This software is released under the MIT License.
+	(See also : http://opensource.org/licenses/mit-license.php)
+*/
+#include <string.h>
+
+#include "Test.h"
+
+
+Test::Entry::Entry(const char* name_given, Case run_given)
+	: name(name_given)
+	, run(run_given)
+{
+	entries().push_back(this);
+}
+
+
+std::vector<Test::Entry*>& Test::entries()
+{
+	static std::vector<Entry*> instance;
+
+	return instance;
+}
+
+
+unsigned long& Test::failures()
+{
+	static unsigned long instance = 0;
+
+	return instance;
+}
+
+
+void Test::fail(const char* file, int line, const char* expression, long long expected, long long actual)
+{
+	failures()++;
+
+	printf("%s:%d: FAILED: %s (expected %lld, actual %lld)\n", file, line, expression, expected, actual);
+}
+
+
+/*!
+	@note
+	Runs all the cases, or the ones whose names contain the argument given.
+*/
+int main(int argc, char* argv[])
+{
+	unsigned int runs = 0;
+
+	for (unsigned int index = 0; index < Test::entries().size(); index++)
+	{
+		Test::Entry& entry = *Test::entries()[index];
+
+		if (   (argc > 1)
+			&& (strstr(entry.name, argv[1]) == NULL) )
+		{
+			continue;
+		}
+
+		const unsigned long failures = Test::failures();
+
+		printf("[ RUN  ] %s\n", entry.name);
+		entry.run();
+		printf("[ %s ] %s\n", (Test::failures() == failures)? " OK " : "FAIL", entry.name);
+
+		runs++;
+	}
+
+	printf("%u case(s), %lu failure(s)\n", runs, Test::failures());
+
+	return (Test::failures() == 0)? 0 : 1;
+}
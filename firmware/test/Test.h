@@ -0,0 +1,110 @@
+/*!
+	@file      Test.h
+	@brief     Tiny test and benchmark framework for the host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_TEST_TEST_H
+#define PLEN2_TEST_TEST_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Host.h"
+
+
+namespace Test
+{
+	typedef void (*Case)();
+
+	/*!
+		@brief Registered case of a test or a benchmark
+	*/
+	class Entry
+	{
+	public:
+		const char* name;
+		Case        run;
+
+		Entry(const char* name_given, Case run_given);
+	};
+
+	//! @brief Get the cases registered.
+	std::vector<Entry*>& entries();
+
+	//! @brief Get count of the checks failed.
+	unsigned long& failures();
+
+	//! @brief Report a check failed.
+	void fail(const char* file, int line, const char* expression, long long expected, long long actual);
+
+	//! @brief Get the monotonic clock. (nsec)
+	inline unsigned long long nsec()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		return now.tv_sec * 1000000000ULL + now.tv_nsec;
+	}
+
+	/*!
+		@brief Measure a body, and print the time per an iteration
+
+		The body is run **iterations** times, and each run is given the count of the runs before.
+
+		@return Time per an iteration. (nsec)
+	*/
+	template <typename Body>
+	double benchmark(const char* name, unsigned long iterations, Body body)
+	{
+		const unsigned long long begin = nsec();
+
+		for (unsigned long index = 0; index < iterations; index++)
+		{
+			body(index);
+		}
+
+		const double result = static_cast<double>(nsec() - begin) / iterations;
+
+		printf("  %-44s %12.1f ns/op %14.0f op/s\n", name, result, 1e9 / result);
+
+		return result;
+	}
+
+	//! @brief Keep a value from the optimizer.
+	template <typename Value>
+	inline void keep(const Value& value)
+	{
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+}
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b)  TEST_CONCAT_(a, b)
+
+/*!
+	@brief Define a case
+
+	The cases of a file are run in the order of their definitions by Test::main().
+*/
+#define TEST(name) \
+	static void name(); \
+	static Test::Entry TEST_CONCAT(entry_, name)(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { \
+		if (!(expression)) { Test::fail(__FILE__, __LINE__, #expression, 1, 0); } \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		const long long expected_ = static_cast<long long>(expected); \
+		const long long actual_   = static_cast<long long>(actual); \
+		if (expected_ != actual_) { Test::fail(__FILE__, __LINE__, #actual, expected_, actual_); } \
+	} while (0)
+
+#endif // PLEN2_TEST_TEST_H
@@ -0,0 +1,29 @@
+/*!
+	@file      Adafruit_NeoPixel.h
+	@brief     WS2812 driver stub to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#define NEO_GRB 0
+
+
+//! @brief LED strip which outputs nothing.
+class Adafruit_NeoPixel
+{
+public:
+	Adafruit_NeoPixel(int, int, int) {}
+
+	void begin() {}
+	void show() {}
+	void setPixelColor(int, uint32_t) {}
+
+	static uint32_t Color(uint8_t red, uint8_t green, uint8_t blue)
+	{
+		return (static_cast<uint32_t>(red) << 16) | (static_cast<uint32_t>(green) << 8) | blue;
+	}
+};
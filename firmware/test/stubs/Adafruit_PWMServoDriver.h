@@ -0,0 +1,20 @@
+/*!
+	@file      Adafruit_PWMServoDriver.h
+	@brief     PCA9685 driver stub to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+//! @brief PWM driver which outputs nothing.
+class Adafruit_PWMServoDriver
+{
+public:
+	void begin() {}
+	void setPWMFreq(float) {}
+	void setPWM(uint8_t, uint16_t, uint16_t) {}
+};
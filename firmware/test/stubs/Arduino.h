@@ -0,0 +1,156 @@
+/*!
+	@file      Arduino.h
+	@brief     Subset of the Arduino core to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef PLEN2_TEST_ARDUINO_H
+#define PLEN2_TEST_ARDUINO_H
+
+/*!
+	@note
+	The standard headers are included before min() and max() are defined,
+	because the macros break their declarations.
+*/
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+class __FlashStringHelper;
+
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+/*!
+	@note
+	The reads copy the bytes, because the tables may have wider types on the host. (e.g. unsigned long)
+	It is right on little endian hosts, as the ESP8266.
+*/
+#define PROGMEM
+#define pgm_read_byte(address)  (pgm_read<uint8_t>(address))
+#define pgm_read_word(address)  (pgm_read<uint16_t>(address))
+#define pgm_read_dword(address) (pgm_read<uint32_t>(address))
+
+template <typename Value>
+inline Value pgm_read(const void* address)
+{
+	Value value;
+	memcpy(&value, address, sizeof(value));
+
+	return value;
+}
+
+#define HEX 16
+#define DEC 10
+
+#define SDA 4
+#define SCL 5
+#define A0  0
+#define D3  3
+#define D4  4
+#define D5  5
+#define D6  6
+#define D7  7
+
+#ifndef min
+	#define min(a, b) ((a) < (b)? (a) : (b))
+	#define max(a, b) ((a) > (b)? (a) : (b))
+#endif
+
+#define constrain(value, low, high) ((value) < (low)? (low) : ((value) > (high)? (high) : (value)))
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long msec);
+void yield();
+
+long random(long max_value);
+long random(long min_value, long max_value);
+long map(long value, long from_low, long from_high, long to_low, long to_high);
+int  analogRead(int pin);
+
+inline void noInterrupts() {}
+inline void interrupts()   {}
+
+
+/*!
+	@brief Output of the host
+
+	The characters are written to stdout.
+*/
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t data) = 0;
+	virtual size_t write(const uint8_t* data, size_t size);
+	size_t write(const char* string);
+	virtual void flush() {}
+
+	size_t print(const __FlashStringHelper* string);
+	size_t print(const char* string);
+	size_t print(char value);
+	size_t print(int value, int base = DEC);
+	size_t print(unsigned int value, int base = DEC);
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+
+	size_t println(const __FlashStringHelper* string);
+	size_t println(const char* string);
+	size_t println(char value);
+	size_t println(int value, int base = DEC);
+	size_t println(unsigned int value, int base = DEC);
+	size_t println(long value, int base = DEC);
+	size_t println(unsigned long value, int base = DEC);
+	size_t println(double value, int digits = 2);
+	size_t println();
+};
+
+/*!
+	@brief Input of the host
+*/
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	size_t readBytes(char buffer[], size_t size);
+	size_t readBytes(uint8_t buffer[], size_t size);
+};
+
+/*!
+	@brief Serial of the host, which discards the input and writes the output to stdout
+*/
+class HardwareSerial : public Stream
+{
+public:
+	void begin(unsigned long) {}
+
+	virtual int available() { return 0; }
+	virtual int read() { return -1; }
+	virtual int peek() { return -1; }
+	virtual size_t write(uint8_t data);
+	using Print::write;
+
+	operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // PLEN2_TEST_ARDUINO_H
@@ -0,0 +1,17 @@
+/*!
+	@file      Servo.h
+	@brief     Servo stub to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+//! @brief Servo which outputs nothing.
+class Servo
+{
+public:
+	void attach(int) {}
+	void attach(int, int, int) {}
+	void write(int) {}
+};
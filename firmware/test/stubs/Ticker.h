@@ -0,0 +1,17 @@
+/*!
+	@file      Ticker.h
+	@brief     Ticker stub to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+//! @brief Ticker which never calls back. (The tests call the callbacks themselves.)
+class Ticker
+{
+public:
+	void attach_ms(unsigned long, void (*)()) {}
+	void attach(float, void (*)()) {}
+	void detach() {}
+};
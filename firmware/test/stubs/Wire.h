@@ -0,0 +1,37 @@
+/*!
+	@file      Wire.h
+	@brief     I2C stub to build the firmware on a host.
+	@author    Kazuyuki TAKASE
+	@copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+/*!
+	@brief I2C bus which replies the bytes given
+
+	Each request reads **reply** from its beginning, and the bytes over it are 0.
+	So a test gives the registers of a device, like the sensor values of MPU-6050. (Reads give 0 by default.)
+*/
+class TwoWire
+{
+public:
+	enum { REPLY_LENGTH = 32 };
+
+	uint8_t reply[REPLY_LENGTH];
+
+	void    begin(int, int) {}
+	void    beginTransmission(uint8_t) {}
+	size_t  write(uint8_t) { return 1; }
+	uint8_t endTransmission() { return 0; }
+	uint8_t requestFrom(uint8_t, uint8_t size) { m_position = 0; return size; }
+	int     read() { return (m_position < REPLY_LENGTH)? reply[m_position++] : 0; }
+
+private:
+	unsigned int m_position;
+};
+
+extern TwoWire Wire;